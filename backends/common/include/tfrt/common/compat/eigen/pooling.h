@@ -0,0 +1,262 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- pooling.h ------------------------------------------------*- C++ -*-===//
+//
+// Max, average and global average pooling of NHWC tensors.
+//
+// Pooling windows are clipped to the input bounds instead of checking every
+// window element for padding, and channels are processed in fixed size blocks
+// accumulated in local arrays, so that the compiler can keep the accumulators
+// in vector registers along the contiguous channels dimension.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_COMPAT_EIGEN_POOLING_H_
+#define TFRT_BACKENDS_COMMON_COMPAT_EIGEN_POOLING_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+
+namespace tfrt {
+namespace compat {
+
+enum class PoolingType { kMax, kAvg };
+
+struct Pool2DParams {
+  std::array<ssize_t, 4> input_shape;   // [batch, height, width, channels]
+  std::array<ssize_t, 4> output_shape;  // [batch, height, width, channels]
+  std::array<ssize_t, 2> pool_size;     // [height, width]
+  std::array<ssize_t, 2> strides;       // [height, width]
+  std::array<ssize_t, 4> paddings;      // [top, bottom, left, right]
+};
+
+// Computes pooling parameters for the "same" or "valid" padding, with the
+// same output shape and padding as in Tensorflow.
+inline Expected<Pool2DParams> ComputePool2DParams(
+    std::array<ssize_t, 4> input_shape, std::array<ssize_t, 2> pool_size,
+    std::array<ssize_t, 2> strides, string_view padding) {
+  if (pool_size[0] <= 0 || pool_size[1] <= 0) {
+    return MakeStringError("Pooling window size must be positive");
+  }
+  if (strides[0] <= 0 || strides[1] <= 0) {
+    return MakeStringError("Pooling strides must be positive");
+  }
+
+  Pool2DParams params;
+  params.input_shape = input_shape;
+  params.pool_size = pool_size;
+  params.strides = strides;
+  params.paddings = {0, 0, 0, 0};
+  params.output_shape = {input_shape[0], 0, 0, input_shape[3]};
+
+  for (int i = 0; i < 2; ++i) {
+    const ssize_t in = input_shape[i + 1];
+    if (padding == "same") {
+      const ssize_t out = (in + strides[i] - 1) / strides[i];
+      const ssize_t total =
+          std::max<ssize_t>((out - 1) * strides[i] + pool_size[i] - in, 0);
+      params.output_shape[i + 1] = out;
+      params.paddings[2 * i] = total / 2;
+      params.paddings[2 * i + 1] = total - total / 2;
+    } else if (padding == "valid") {
+      if (in < pool_size[i]) {
+        return MakeStringError("Pooling window is larger than the input");
+      }
+      params.output_shape[i + 1] = (in - pool_size[i]) / strides[i] + 1;
+    } else {
+      return MakeStringError("Pooling padding '", padding,
+                             "' is not recognized");
+    }
+  }
+
+  return params;
+}
+
+namespace internal {
+
+// Number of channels accumulated together in local arrays.
+constexpr ssize_t kPoolingChannelBlock = 16;
+
+// Computes pooling for output rows [begin, end), where rows are indexed as
+// `batch * output_height + output_row`.
+template <PoolingType type, typename T>
+void Pool2DRows(const Pool2DParams& params, const T* input, T* output,
+                ssize_t begin, ssize_t end) {
+  constexpr ssize_t kBlock = kPoolingChannelBlock;
+
+  const ssize_t in_h = params.input_shape[1];
+  const ssize_t in_w = params.input_shape[2];
+  const ssize_t out_h = params.output_shape[1];
+  const ssize_t out_w = params.output_shape[2];
+  const ssize_t channels = params.input_shape[3];
+
+  for (ssize_t row = begin; row < end; ++row) {
+    const ssize_t batch = row / out_h;
+    const ssize_t oh = row % out_h;
+
+    // Clip the pooling window to the input bounds.
+    const ssize_t h_start = oh * params.strides[0] - params.paddings[0];
+    const ssize_t h_begin = std::max<ssize_t>(h_start, 0);
+    const ssize_t h_end = std::min(h_start + params.pool_size[0], in_h);
+
+    const T* batch_input = input + batch * in_h * in_w * channels;
+    T* row_output = output + row * out_w * channels;
+
+    for (ssize_t ow = 0; ow < out_w; ++ow) {
+      const ssize_t w_start = ow * params.strides[1] - params.paddings[2];
+      const ssize_t w_begin = std::max<ssize_t>(w_start, 0);
+      const ssize_t w_end = std::min(w_start + params.pool_size[1], in_w);
+
+      T* out = row_output + ow * channels;
+
+      for (ssize_t c0 = 0; c0 < channels; c0 += kBlock) {
+        const ssize_t n = std::min(kBlock, channels - c0);
+
+        T acc[kBlock];
+        std::fill_n(acc, kBlock, type == PoolingType::kMax
+                                     ? std::numeric_limits<T>::lowest()
+                                     : T(0));
+
+        for (ssize_t h = h_begin; h < h_end; ++h) {
+          for (ssize_t w = w_begin; w < w_end; ++w) {
+            const T* in = batch_input + (h * in_w + w) * channels + c0;
+            if (n == kBlock) {
+              for (ssize_t c = 0; c < kBlock; ++c) {
+                acc[c] = type == PoolingType::kMax ? std::max(acc[c], in[c])
+                                                   : acc[c] + in[c];
+              }
+            } else {
+              for (ssize_t c = 0; c < n; ++c) {
+                acc[c] = type == PoolingType::kMax ? std::max(acc[c], in[c])
+                                                   : acc[c] + in[c];
+              }
+            }
+          }
+        }
+
+        if (type == PoolingType::kAvg) {
+          // Padded values are not included in the average.
+          const T count = static_cast<T>((h_end - h_begin) * (w_end - w_begin));
+          for (ssize_t c = 0; c < kBlock; ++c) acc[c] /= count;
+        }
+
+        std::copy_n(acc, n, out + c0);
+      }
+    }
+  }
+}
+
+// Computes global average pooling for the [begin, end) range of
+// `batch * num_channel_blocks + channel_block` indices.
+template <typename T>
+void GlobalAveragePoolBlocks(std::array<ssize_t, 4> input_shape,
+                             const T* input, T* output, ssize_t begin,
+                             ssize_t end) {
+  constexpr ssize_t kBlock = kPoolingChannelBlock;
+
+  const ssize_t pixels = input_shape[1] * input_shape[2];
+  const ssize_t channels = input_shape[3];
+  const ssize_t num_blocks = (channels + kBlock - 1) / kBlock;
+
+  for (ssize_t index = begin; index < end; ++index) {
+    const ssize_t batch = index / num_blocks;
+    const ssize_t c0 = (index % num_blocks) * kBlock;
+    const ssize_t n = std::min(kBlock, channels - c0);
+
+    T acc[kBlock] = {};
+    const T* in = input + batch * pixels * channels + c0;
+    for (ssize_t p = 0; p < pixels; ++p, in += channels) {
+      for (ssize_t c = 0; c < n; ++c) acc[c] += in[c];
+    }
+
+    for (ssize_t c = 0; c < n; ++c) {
+      output[batch * channels + c0 + c] = acc[c] / static_cast<T>(pixels);
+    }
+  }
+}
+
+}  // namespace internal
+
+// Computes the NHWC `output` of the 2D pooling of the NHWC `input` in
+// parallel, and calls `done` when the output is ready. Input and output
+// buffers must stay alive until then.
+template <typename T>
+void AsyncPool2D(HostContext* host, PoolingType type,
+                 const Pool2DParams& params, const T* input, T* output,
+                 llvm::unique_function<void()> done) {
+  // Make sure that every task pools at least this many input values, so we do
+  // not create too many small tasks for small images.
+  static constexpr ssize_t kMinTaskSize = 16 * 1024;
+
+  const ssize_t num_rows = params.output_shape[0] * params.output_shape[1];
+  const ssize_t row_size = params.output_shape[2] * params.output_shape[3] *
+                           params.pool_size[0] * params.pool_size[1];
+  const size_t min_block_size =
+      std::max<ssize_t>(1, kMinTaskSize / std::max<ssize_t>(1, row_size));
+
+  auto compute = [type, params, input, output](size_t begin, size_t end) {
+    if (type == PoolingType::kMax) {
+      internal::Pool2DRows<PoolingType::kMax>(params, input, output, begin,
+                                              end);
+    } else {
+      internal::Pool2DRows<PoolingType::kAvg>(params, input, output, begin,
+                                              end);
+    }
+  };
+
+  ParallelFor(host).Execute(num_rows,
+                            ParallelFor::BlockSizes::Min(min_block_size),
+                            std::move(compute), std::move(done));
+}
+
+// Computes the `[batch, channels]` global average pooling `output` of the
+// NHWC `input` in parallel, and calls `done` when the output is ready.
+template <typename T>
+void AsyncGlobalAveragePool(HostContext* host,
+                            std::array<ssize_t, 4> input_shape,
+                            const T* input, T* output,
+                            llvm::unique_function<void()> done) {
+  static constexpr ssize_t kMinTaskSize = 16 * 1024;
+
+  const ssize_t num_blocks =
+      (input_shape[3] + internal::kPoolingChannelBlock - 1) /
+      internal::kPoolingChannelBlock;
+  const ssize_t block_size = input_shape[1] * input_shape[2] *
+                             internal::kPoolingChannelBlock;
+  const size_t min_block_size =
+      std::max<ssize_t>(1, kMinTaskSize / std::max<ssize_t>(1, block_size));
+
+  auto compute = [input_shape, input, output](size_t begin, size_t end) {
+    internal::GlobalAveragePoolBlocks(input_shape, input, output, begin, end);
+  };
+
+  ParallelFor(host).Execute(input_shape[0] * num_blocks,
+                            ParallelFor::BlockSizes::Min(min_block_size),
+                            std::move(compute), std::move(done));
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_COMPAT_EIGEN_POOLING_H_
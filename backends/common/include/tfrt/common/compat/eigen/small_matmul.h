@@ -0,0 +1,188 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- small_matmul.h -------------------------------------------*- C++ -*-===//
+//
+// Matrix multiplication of small matrices, and the size based selection of
+// the matrix multiplication strategy.
+//
+// For small matrices the cost of Eigen tensor contraction is dominated by
+// packing, by the evaluator setup and by scheduling work into the thread pool,
+// so they are multiplied synchronously by a register blocked micro kernel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SMALL_MATMUL_H_
+#define TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SMALL_MATMUL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+enum class MatMulStrategy {
+  // Register blocked micro kernel in the caller thread.
+  kSmall,
+  // Eigen tensor contraction in the caller thread.
+  kSingleThreaded,
+  // Eigen tensor contraction in the HostContext thread pool.
+  kThreadPool,
+};
+
+// Largest `m * n * k` products computed by the micro kernel, and by the
+// single threaded Eigen contraction. The micro kernel crossover was measured
+// with the BM_MatMul_NxNxN benchmarks in eigen/matmul.benchmarks.mlir.
+// Below the second threshold Eigen contraction splits the work into so few
+// blocks that scheduling them into the thread pool does not pay off.
+constexpr int64_t kSmallMatMulMaxCost = 64 * 64 * 64;
+constexpr int64_t kSingleThreadedMatMulMaxCost = 128 * 128 * 128;
+
+// Selects the strategy for the multiplication of the `m` x `k` and `k` x `n`
+// matrices.
+inline MatMulStrategy SelectMatMulStrategy(int64_t m, int64_t n, int64_t k) {
+  const int64_t cost = m * n * k;
+  if (cost <= kSmallMatMulMaxCost) return MatMulStrategy::kSmall;
+  if (cost <= kSingleThreadedMatMulMaxCost)
+    return MatMulStrategy::kSingleThreaded;
+  return MatMulStrategy::kThreadPool;
+}
+
+namespace internal {
+
+// Every micro kernel tile keeps up to kSmallMatMulTileRows x
+// kSmallMatMulTilePackets packets of accumulators in registers.
+constexpr int64_t kSmallMatMulTileRows = 4;
+constexpr int64_t kSmallMatMulTilePackets = 2;
+
+// Computes the `Rows` x `Packets * packet_size` tile of
+// `C = alpha * A * B + beta * C`. For every value along the depth dimension,
+// loads one row of `B` packets and broadcasts one value of `A` per tile row,
+// so the accumulators never leave the registers.
+template <typename T, typename Packet, int64_t Rows, int64_t Packets>
+EIGEN_ALWAYS_INLINE void SmallMatMulTile(T alpha, const T* a, int64_t lda,
+                                         const T* b, int64_t ldb, T beta, T* c,
+                                         int64_t ldc, int64_t depth) {
+  using Eigen::internal::pload1;
+  using Eigen::internal::ploadu;
+  using Eigen::internal::pmadd;
+  using Eigen::internal::pmul;
+  using Eigen::internal::pset1;
+  using Eigen::internal::pstoreu;
+  constexpr int64_t kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  Packet acc[Rows][Packets];
+  for (int64_t i = 0; i < Rows; ++i) {
+    for (int64_t j = 0; j < Packets; ++j) acc[i][j] = pset1<Packet>(T(0));
+  }
+
+  for (int64_t p = 0; p < depth; ++p) {
+    Packet b_row[Packets];
+    for (int64_t j = 0; j < Packets; ++j)
+      b_row[j] = ploadu<Packet>(b + p * ldb + j * kPacketSize);
+
+    for (int64_t i = 0; i < Rows; ++i) {
+      const Packet a_value = pload1<Packet>(a + i * lda + p);
+      for (int64_t j = 0; j < Packets; ++j)
+        acc[i][j] = pmadd(a_value, b_row[j], acc[i][j]);
+    }
+  }
+
+  // Do not read `C` if `beta` is zero, because it can be uninitialized.
+  const Packet alpha_packet = pset1<Packet>(alpha);
+  const Packet beta_packet = pset1<Packet>(beta);
+  for (int64_t i = 0; i < Rows; ++i) {
+    for (int64_t j = 0; j < Packets; ++j) {
+      T* out = c + i * ldc + j * kPacketSize;
+      Packet result = pmul(alpha_packet, acc[i][j]);
+      if (beta != T(0))
+        result = pmadd(beta_packet, ploadu<Packet>(out), result);
+      pstoreu(out, result);
+    }
+  }
+}
+
+// Computes columns [col, n) of a block of `Rows` rows of `C` with the widest
+// tiles that fit, and continues with the next smaller packet type (down to
+// the scalar type `T`) for the columns that are left.
+template <typename T, typename Packet, int64_t Rows>
+struct SmallMatMulColumns {
+  using HalfPacket = typename Eigen::internal::unpacket_traits<Packet>::half;
+  using NextPacket = typename std::conditional<
+      std::is_same<HalfPacket, Packet>::value, T, HalfPacket>::type;
+
+  static void Run(T alpha, const T* a, int64_t lda, const T* b, int64_t ldb,
+                  T beta, T* c, int64_t ldc, int64_t col, int64_t n,
+                  int64_t k) {
+    constexpr int64_t kPackets = kSmallMatMulTilePackets;
+    constexpr int64_t kPacketSize =
+        Eigen::internal::unpacket_traits<Packet>::size;
+
+    for (; col + kPackets * kPacketSize <= n; col += kPackets * kPacketSize) {
+      SmallMatMulTile<T, Packet, Rows, kPackets>(alpha, a, lda, b + col, ldb,
+                                                 beta, c + col, ldc, k);
+    }
+    for (; col + kPacketSize <= n; col += kPacketSize) {
+      SmallMatMulTile<T, Packet, Rows, 1>(alpha, a, lda, b + col, ldb, beta,
+                                          c + col, ldc, k);
+    }
+    SmallMatMulColumns<T, NextPacket, Rows>::Run(alpha, a, lda, b, ldb, beta,
+                                                 c, ldc, col, n, k);
+  }
+};
+
+template <typename T, int64_t Rows>
+struct SmallMatMulColumns<T, T, Rows> {
+  static void Run(T alpha, const T* a, int64_t lda, const T* b, int64_t ldb,
+                  T beta, T* c, int64_t ldc, int64_t col, int64_t n,
+                  int64_t k) {
+    for (; col < n; ++col) {
+      SmallMatMulTile<T, T, Rows, 1>(alpha, a, lda, b + col, ldb, beta,
+                                     c + col, ldc, k);
+    }
+  }
+};
+
+}  // namespace internal
+
+// Computes `C = alpha * A * B + beta * C`, where `A`, `B` and `C` are RowMajor
+// `m` x `k`, `k` x `n` and `m` x `n` matrices with row strides `lda`, `ldb`
+// and `ldc`. `C` must not alias `A` or `B`.
+template <typename T>
+void SmallMatMul(T alpha, const T* a, int64_t lda, const T* b, int64_t ldb,
+                 T beta, T* c, int64_t ldc, int64_t m, int64_t n, int64_t k) {
+  using Packet = typename Eigen::internal::packet_traits<T>::type;
+  constexpr int64_t kRows = internal::kSmallMatMulTileRows;
+
+  int64_t row = 0;
+  for (; row + kRows <= m; row += kRows) {
+    internal::SmallMatMulColumns<T, Packet, kRows>::Run(
+        alpha, a + row * lda, lda, b, ldb, beta, c + row * ldc, ldc, 0, n, k);
+  }
+  for (; row < m; ++row) {
+    internal::SmallMatMulColumns<T, Packet, 1>::Run(
+        alpha, a + row * lda, lda, b, ldb, beta, c + row * ldc, ldc, 0, n, k);
+  }
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SMALL_MATMUL_H_
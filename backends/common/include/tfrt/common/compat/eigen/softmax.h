@@ -0,0 +1,356 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- softmax.h ------------------------------------------------*- C++ -*-===//
+//
+// Row-wise softmax, log-softmax and fused softmax cross-entropy.
+//
+// Every row of a [rows, cols] matrix is normalized independently. The row
+// maximum is subtracted before exponentiation for numerical stability, and
+// all passes over a row use Eigen packets, including the vectorized
+// polynomial approximation of exp. Rows are evaluated in parallel blocks in
+// the HostContext thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SOFTMAX_H_
+#define TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SOFTMAX_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+enum class SoftmaxType { kSoftmax, kLogSoftmax };
+
+namespace internal {
+
+// Every parallel block normalizes rows with at least this many elements in
+// total, to amortize scheduling costs for small rows.
+constexpr int64_t kSoftmaxMinBlockElements = 16 * 1024;
+
+template <typename T>
+using SoftmaxPacket = typename Eigen::internal::packet_traits<T>::type;
+
+template <typename T>
+constexpr int64_t SoftmaxPacketSize() {
+  return Eigen::internal::unpacket_traits<SoftmaxPacket<T>>::size;
+}
+
+// Returns the maximum value of the row.
+template <typename T>
+T RowMax(const T* row, int64_t cols) {
+  using Packet = SoftmaxPacket<T>;
+  constexpr int64_t kPacketSize = SoftmaxPacketSize<T>();
+
+  T max = -std::numeric_limits<T>::infinity();
+  int64_t j = 0;
+  if (cols >= kPacketSize) {
+    using Eigen::internal::ploadu;
+    Packet acc = ploadu<Packet>(row);
+    for (j = kPacketSize; j + kPacketSize <= cols; j += kPacketSize)
+      acc = Eigen::internal::pmax(acc, ploadu<Packet>(row + j));
+    max = Eigen::internal::predux_max(acc);
+  }
+  for (; j < cols; ++j) max = std::max(max, row[j]);
+  return max;
+}
+
+// Returns the sum of `exp(row[j] - shift)`. Stores the exponents into `out`
+// if it is not null. `out` can alias `row`.
+template <typename T>
+T RowExpSum(const T* row, T shift, T* out, int64_t cols) {
+  using Packet = SoftmaxPacket<T>;
+  using Eigen::internal::padd;
+  using Eigen::internal::pexp;
+  using Eigen::internal::ploadu;
+  using Eigen::internal::psub;
+  constexpr int64_t kPacketSize = SoftmaxPacketSize<T>();
+
+  const Packet shift_packet = Eigen::internal::pset1<Packet>(shift);
+  Packet acc = Eigen::internal::pset1<Packet>(T(0));
+  int64_t j = 0;
+  for (; j + kPacketSize <= cols; j += kPacketSize) {
+    const Packet value = pexp(psub(ploadu<Packet>(row + j), shift_packet));
+    if (out) Eigen::internal::pstoreu(out + j, value);
+    acc = padd(acc, value);
+  }
+
+  T sum = Eigen::internal::predux(acc);
+  if (j == cols) return sum;
+
+  // Compute exponents of the remaining values with a padded packet, because
+  // scalar exp is much slower, and rows are often short (e.g. 10 classes).
+  T tail[kPacketSize];
+  const int64_t tail_size = cols - j;
+  std::fill(std::copy(row + j, row + cols, tail), tail + kPacketSize, shift);
+  Eigen::internal::pstoreu(
+      tail, pexp(psub(ploadu<Packet>(tail), shift_packet)));
+  for (int64_t i = 0; i < tail_size; ++i) sum += tail[i];
+  if (out) std::copy(tail, tail + tail_size, out + j);
+  return sum;
+}
+
+// Computes `out[j] = row[j] * scale + offset`. `out` can alias `row`.
+template <typename T>
+void RowScaleAndOffset(const T* row, T scale, T offset, T* out,
+                       int64_t cols) {
+  using Packet = SoftmaxPacket<T>;
+  constexpr int64_t kPacketSize = SoftmaxPacketSize<T>();
+
+  const Packet scale_packet = Eigen::internal::pset1<Packet>(scale);
+  const Packet offset_packet = Eigen::internal::pset1<Packet>(offset);
+  int64_t j = 0;
+  for (; j + kPacketSize <= cols; j += kPacketSize) {
+    const Packet value = Eigen::internal::ploadu<Packet>(row + j);
+    Eigen::internal::pstoreu(
+        out + j, Eigen::internal::pmadd(value, scale_packet, offset_packet));
+  }
+  for (; j < cols; ++j) out[j] = row[j] * scale + offset;
+}
+
+// Computes the softmax or log-softmax of a single row.
+template <typename T>
+void SoftmaxRow(SoftmaxType type, const T* row, T* out, int64_t cols) {
+  const T max = RowMax(row, cols);
+  if (type == SoftmaxType::kSoftmax) {
+    const T sum = RowExpSum(row, max, out, cols);
+    RowScaleAndOffset(out, T(1) / sum, T(0), out, cols);
+  } else {
+    const T sum = RowExpSum<T>(row, max, /*out=*/nullptr, cols);
+    RowScaleAndOffset(row, T(1), -(max + std::log(sum)), out, cols);
+  }
+}
+
+// Computes the cross-entropy loss of a single row of logits and the gradient
+// of the loss with respect to the logits:
+//   loss = sum_j -labels[j] * log_softmax(logits)[j]
+//   backprop[j] = softmax(logits)[j] - labels[j]
+// `backprop` can alias `logits`.
+template <typename T>
+T SoftmaxCrossEntropyRow(const T* logits, const T* labels, T* backprop,
+                         int64_t cols) {
+  using Packet = SoftmaxPacket<T>;
+  using Eigen::internal::padd;
+  using Eigen::internal::pmadd;
+  using Eigen::internal::ploadu;
+  constexpr int64_t kPacketSize = SoftmaxPacketSize<T>();
+
+  // Since sum_j labels[j] * log_softmax[j] =
+  //   sum_j labels[j] * logits[j] - sum_j labels[j] * (max + log(sum_exp)),
+  // accumulate both label sums before the logits are overwritten.
+  Packet dot_acc = Eigen::internal::pset1<Packet>(T(0));
+  Packet labels_acc = Eigen::internal::pset1<Packet>(T(0));
+  int64_t j = 0;
+  for (; j + kPacketSize <= cols; j += kPacketSize) {
+    const Packet label = ploadu<Packet>(labels + j);
+    dot_acc = pmadd(label, ploadu<Packet>(logits + j), dot_acc);
+    labels_acc = padd(labels_acc, label);
+  }
+  T dot = Eigen::internal::predux(dot_acc);
+  T labels_sum = Eigen::internal::predux(labels_acc);
+  for (; j < cols; ++j) {
+    dot += labels[j] * logits[j];
+    labels_sum += labels[j];
+  }
+
+  const T max = RowMax(logits, cols);
+  const T sum = RowExpSum(logits, max, backprop, cols);
+  const T inv_sum = T(1) / sum;
+
+  const Packet inv_sum_packet = Eigen::internal::pset1<Packet>(inv_sum);
+  for (j = 0; j + kPacketSize <= cols; j += kPacketSize) {
+    const Packet value = Eigen::internal::pmul(
+        ploadu<Packet>(backprop + j), inv_sum_packet);
+    Eigen::internal::pstoreu(
+        backprop + j, Eigen::internal::psub(value, ploadu<Packet>(labels + j)));
+  }
+  for (; j < cols; ++j) backprop[j] = backprop[j] * inv_sum - labels[j];
+
+  return labels_sum * (max + std::log(sum)) - dot;
+}
+
+// Rows shorter than this many packets are normalized in chunks of rows, so
+// exp is evaluated with full packets over all values of the chunk, instead of
+// mostly padded packets per row.
+constexpr int64_t kShortRowMaxPackets = 2;
+constexpr int64_t kShortRowsChunkSize = 64;
+
+template <typename T>
+constexpr int64_t ShortRowMaxCols() {
+  return kShortRowMaxPackets * SoftmaxPacketSize<T>();
+}
+
+// Computes the softmax or log-softmax of up to kShortRowsChunkSize rows with
+// less than ShortRowMaxCols<T>() values each.
+template <typename T>
+void SoftmaxShortRowsChunk(SoftmaxType type, const T* input, T* output,
+                           int64_t rows, int64_t cols) {
+  T exps[kShortRowsChunkSize * ShortRowMaxCols<T>()];
+  const int64_t size = rows * cols;
+
+  // Subtract the row maximum, and exponentiate the whole chunk at once.
+  for (int64_t r = 0; r < rows; ++r) {
+    const T* row = input + r * cols;
+    const T max = *std::max_element(row, row + cols);
+    for (int64_t j = 0; j < cols; ++j) output[r * cols + j] = row[j] - max;
+  }
+  RowExpSum<T>(output, T(0), exps, size);
+
+  for (int64_t r = 0; r < rows; ++r) {
+    T* out = output + r * cols;
+    const T* row_exps = exps + r * cols;
+    const T sum = std::accumulate(row_exps, row_exps + cols, T(0));
+    if (type == SoftmaxType::kSoftmax) {
+      const T inv_sum = T(1) / sum;
+      for (int64_t j = 0; j < cols; ++j) out[j] = row_exps[j] * inv_sum;
+    } else {
+      const T log_sum = std::log(sum);
+      for (int64_t j = 0; j < cols; ++j) out[j] -= log_sum;
+    }
+  }
+}
+
+// Computes the softmax cross-entropy of up to kShortRowsChunkSize rows with
+// less than ShortRowMaxCols<T>() values each (see SoftmaxCrossEntropyRow).
+template <typename T>
+void SoftmaxCrossEntropyShortRowsChunk(const T* logits, const T* labels,
+                                       T* loss, T* backprop, int64_t rows,
+                                       int64_t cols) {
+  T labels_sums[kShortRowsChunkSize];
+
+  // Accumulate the label sums into `loss` before the logits are overwritten
+  // with the shifted logits.
+  for (int64_t r = 0; r < rows; ++r) {
+    const T* row = logits + r * cols;
+    const T* label = labels + r * cols;
+    const T max = *std::max_element(row, row + cols);
+    T dot = 0;
+    T labels_sum = 0;
+    for (int64_t j = 0; j < cols; ++j) {
+      dot += label[j] * row[j];
+      labels_sum += label[j];
+    }
+    loss[r] = labels_sum * max - dot;
+    labels_sums[r] = labels_sum;
+    for (int64_t j = 0; j < cols; ++j) backprop[r * cols + j] = row[j] - max;
+  }
+  RowExpSum<T>(backprop, T(0), backprop, rows * cols);
+
+  for (int64_t r = 0; r < rows; ++r) {
+    T* out = backprop + r * cols;
+    const T* label = labels + r * cols;
+    const T sum = std::accumulate(out, out + cols, T(0));
+    const T inv_sum = T(1) / sum;
+    loss[r] += labels_sums[r] * std::log(sum);
+    for (int64_t j = 0; j < cols; ++j) out[j] = out[j] * inv_sum - label[j];
+  }
+}
+
+// Computes the softmax or log-softmax of all rows.
+template <typename T>
+void SoftmaxRows(SoftmaxType type, const T* input, T* output, int64_t rows,
+                 int64_t cols) {
+  if (cols >= ShortRowMaxCols<T>()) {
+    for (int64_t r = 0; r < rows; ++r)
+      SoftmaxRow(type, input + r * cols, output + r * cols, cols);
+    return;
+  }
+
+  for (int64_t r = 0; r < rows; r += kShortRowsChunkSize) {
+    SoftmaxShortRowsChunk(type, input + r * cols, output + r * cols,
+                          std::min(kShortRowsChunkSize, rows - r), cols);
+  }
+}
+
+// Computes the softmax cross-entropy of all rows.
+template <typename T>
+void SoftmaxCrossEntropyRows(const T* logits, const T* labels, T* loss,
+                             T* backprop, int64_t rows, int64_t cols) {
+  if (cols >= ShortRowMaxCols<T>()) {
+    for (int64_t r = 0; r < rows; ++r) {
+      loss[r] = SoftmaxCrossEntropyRow(logits + r * cols, labels + r * cols,
+                                       backprop + r * cols, cols);
+    }
+    return;
+  }
+
+  for (int64_t r = 0; r < rows; r += kShortRowsChunkSize) {
+    const int64_t offset = r * cols;
+    SoftmaxCrossEntropyShortRowsChunk(
+        logits + offset, labels + offset, loss + r, backprop + offset,
+        std::min(kShortRowsChunkSize, rows - r), cols);
+  }
+}
+
+inline ParallelFor::BlockSizes SoftmaxBlockSizes(int64_t cols) {
+  const int64_t min_block_size =
+      kSoftmaxMinBlockElements / std::max<int64_t>(1, cols);
+  return ParallelFor::BlockSizes::Min(std::max<int64_t>(1, min_block_size));
+}
+
+}  // namespace internal
+
+// Computes the softmax or log-softmax of every row of the `rows` x `cols`
+// RowMajor matrix `input`, and calls `done` when all rows are completed.
+// `output` can alias `input`.
+template <typename T>
+void AsyncSoftmax(HostContext* host, SoftmaxType type, const T* input,
+                  T* output, int64_t rows, int64_t cols,
+                  llvm::unique_function<void()> done) {
+  auto compute = [=](size_t begin, size_t end) {
+    internal::SoftmaxRows(type, input + begin * cols, output + begin * cols,
+                          end - begin, cols);
+  };
+
+  ParallelFor(host).Execute(rows, internal::SoftmaxBlockSizes(cols),
+                            std::move(compute), std::move(done));
+}
+
+// Computes the cross-entropy `loss` of every row of `logits` against the
+// `labels` probabilities, and its gradient `backprop`, and calls `done` when
+// all rows are completed. `logits`, `labels` and `backprop` are `rows` x
+// `cols` RowMajor matrices, and `loss` is a vector of `rows` values.
+// `backprop` can alias `logits`.
+template <typename T>
+void AsyncSoftmaxCrossEntropy(HostContext* host, const T* logits,
+                              const T* labels, T* loss, T* backprop,
+                              int64_t rows, int64_t cols,
+                              llvm::unique_function<void()> done) {
+  auto compute = [=](size_t begin, size_t end) {
+    const size_t offset = begin * cols;
+    internal::SoftmaxCrossEntropyRows(logits + offset, labels + offset,
+                                      loss + begin, backprop + offset,
+                                      end - begin, cols);
+  };
+
+  ParallelFor(host).Execute(rows, internal::SoftmaxBlockSizes(cols),
+                            std::move(compute), std::move(done));
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_COMPAT_EIGEN_SOFTMAX_H_
@@ -26,11 +26,17 @@
 
 #define EIGEN_USE_THREADS
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+
 #include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_frame.h"
 #include "tfrt/host_context/shared_context.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 
@@ -43,12 +49,11 @@ namespace compat {
 
 class EigenHostContext : public SharedContext {
  public:
-  // TODO(ezhulenev): Pass a custom Eigen::Allocator that wraps HostContext
-  // AllocateBytes/DeallocateBytes.
   explicit EigenHostContext(HostContext* host_context)
       : host_context_(host_context),
         thread_pool_(host_context),
-        device_(&thread_pool_, thread_pool_.NumThreads()) {}
+        allocator_(host_context),
+        device_(&thread_pool_, thread_pool_.NumThreads(), &allocator_) {}
 
   EigenHostContext(const EigenHostContext&) = delete;
   void operator=(const EigenHostContext&) = delete;
@@ -58,6 +63,10 @@ class EigenHostContext : public SharedContext {
 
   HostContext* host() const { return host_context_; };
 
+  // Upper bound on the total size of the freed Eigen temporary buffers that
+  // are kept for reuse by all allocator caches.
+  static constexpr size_t kMaxAllocatorCachedBytes = 16 * 1024 * 1024;
+
  private:
   //===--------------------------------------------------------------------===//
   // Eigen::ThreadPoolInterface implementation that wraps HostContext.
@@ -78,19 +87,62 @@ class EigenHostContext : public SharedContext {
       return host_context_->GetNumWorkerThreads();
     }
 
-    // Eigen expressions that are using this thread pool must not rely on
-    // CurrentThreadId(), and should use Eigen::ThreadLocal instead.
+    // Returns a logical thread index in the [0, NumThreads()) range if called
+    // from one of the HostContext worker threads, and -1 otherwise.
     int CurrentThreadId() const override {
-      assert(false && "CurrentThreadId is not supported by HostContext");
-      return -1;
+      return host_context_->GetCurrentWorkerThreadId();
     }
 
    private:
     HostContext* const host_context_;  // Must outlive *this.
   };
 
+  //===--------------------------------------------------------------------===//
+  // Eigen::Allocator implementation that wraps HostContext.
+  //===--------------------------------------------------------------------===//
+
+  // Allocates Eigen temporary buffers (e.g. tensor contraction packing
+  // buffers) with the HostContext allocator, so they are visible to the
+  // allocator profiling and pooling.
+  //
+  // Eigen allocates the same packing buffers for every evaluated contraction,
+  // so freed buffers are kept for reuse in small caches. HostContext worker
+  // threads use the caches selected by their worker thread ids, and all other
+  // threads use the caches selected by the std::thread::id hash. Buffers that
+  // would take the total size of the cached buffers over
+  // `kMaxAllocatorCachedBytes` are returned to the HostContext allocator.
+  class EigenHostContextAllocator : public Eigen::Allocator {
+   public:
+    explicit EigenHostContextAllocator(HostContext* host_context)
+        : host_context_(host_context) {}
+    ~EigenHostContextAllocator() override;
+
+    void* allocate(size_t num_bytes) const override;
+    void deallocate(void* buffer) const override;
+
+   private:
+    static constexpr int kNumCaches = 16;
+    static constexpr int kMaxCachedBuffers = 4;
+
+    struct Cache {
+      mutex mu;
+      llvm::SmallVector<void*, kMaxCachedBuffers> buffers TFRT_GUARDED_BY(mu);
+    };
+
+    Cache& GetThreadCache() const;
+
+    // Reserves `num_bytes` of the cached bytes budget, and returns false if
+    // the budget is exhausted.
+    bool ReserveCachedBytes(size_t num_bytes) const;
+
+    HostContext* const host_context_;  // Must outlive *this.
+    mutable std::array<Cache, kNumCaches> caches_;
+    mutable std::atomic<size_t> cached_bytes_{0};
+  };
+
   HostContext* host_context_;
   EigenHostContextThreadPool thread_pool_;
+  EigenHostContextAllocator allocator_;
   Eigen::ThreadPoolDevice device_;
 };
 
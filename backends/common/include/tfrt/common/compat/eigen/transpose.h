@@ -0,0 +1,315 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- transpose.h ----------------------------------------------*- C++ -*-===//
+//
+// N-D tensor transpose (dimensions permutation).
+//
+// The permutation is first simplified by dropping unit dimensions and merging
+// input dimensions that stay adjacent in the output, so for example NHWC to
+// NCHW becomes a batch of [H * W, C] matrix transposes. If the innermost
+// dimension is not permuted, rows of contiguous elements are copied.
+// Otherwise the innermost input and output dimensions are transposed in
+// cache sized tiles, using in-register packet block transposes for float and
+// double. Tiles are evaluated in parallel in the HostContext thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_COMPAT_EIGEN_TRANSPOSE_H_
+#define TFRT_BACKENDS_COMMON_COMPAT_EIGEN_TRANSPOSE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+// Returns an error if `perm` is not a permutation of [0, rank).
+inline Error ValidateTransposePermutation(ArrayRef<ssize_t> perm, int rank) {
+  if (perm.size() != static_cast<size_t>(rank))
+    return MakeStringError("transpose permutation size ", perm.size(),
+                           " does not match the input rank ", rank);
+
+  llvm::SmallVector<bool, 4> seen(rank, false);
+  for (ssize_t dim : perm) {
+    if (dim < 0 || dim >= rank || seen[dim])
+      return MakeStringError("transpose permutation is not a permutation of ",
+                             "the input dimensions");
+    seen[dim] = true;
+  }
+  return Error::success();
+}
+
+// Transposed tensor dimensions and permutation, after dropping unit
+// dimensions and merging input dimensions that stay adjacent in the output.
+// Output dimension `i` is the input dimension `perm[i]`.
+struct TransposePlan {
+  llvm::SmallVector<ssize_t, 4> dims;
+  llvm::SmallVector<ssize_t, 4> perm;
+
+  // Returns true if the transpose does not move any elements, and the output
+  // can share the input buffer.
+  bool IsIdentity() const { return perm.size() <= 1; }
+};
+
+// Computes the simplified transpose of a tensor with `dims` dimensions.
+// `perm` must be a valid permutation (see ValidateTransposePermutation).
+inline TransposePlan PlanTranspose(ArrayRef<ssize_t> dims,
+                                   ArrayRef<ssize_t> perm) {
+  // Map input dimensions to their index after dropping unit dimensions.
+  llvm::SmallVector<ssize_t, 4> index(dims.size(), -1);
+  llvm::SmallVector<ssize_t, 4> non_unit_dims;
+  for (size_t d = 0; d < dims.size(); ++d) {
+    if (dims[d] == 1) continue;
+    index[d] = non_unit_dims.size();
+    non_unit_dims.push_back(dims[d]);
+  }
+
+  llvm::SmallVector<ssize_t, 4> non_unit_perm;
+  for (ssize_t d : perm) {
+    if (index[d] >= 0) non_unit_perm.push_back(index[d]);
+  }
+
+  // Group runs of output dimensions that are consecutive input dimensions.
+  // Every group is identified by its first input dimension.
+  llvm::SmallVector<ssize_t, 4> group_start;
+  llvm::SmallVector<ssize_t, 4> group_size;
+  for (size_t i = 0; i < non_unit_perm.size(); ++i) {
+    if (i > 0 && non_unit_perm[i] == non_unit_perm[i - 1] + 1) {
+      group_size.back() *= non_unit_dims[non_unit_perm[i]];
+    } else {
+      group_start.push_back(non_unit_perm[i]);
+      group_size.push_back(non_unit_dims[non_unit_perm[i]]);
+    }
+  }
+
+  // Merged input dimensions are the groups sorted by their first dimension.
+  llvm::SmallVector<size_t, 4> groups(group_start.size());
+  for (size_t g = 0; g < groups.size(); ++g) groups[g] = g;
+  std::sort(groups.begin(), groups.end(), [&](size_t lhs, size_t rhs) {
+    return group_start[lhs] < group_start[rhs];
+  });
+
+  TransposePlan plan;
+  plan.perm.resize(groups.size());
+  for (size_t d = 0; d < groups.size(); ++d) {
+    plan.dims.push_back(group_size[groups[d]]);
+    plan.perm[groups[d]] = d;
+  }
+  return plan;
+}
+
+namespace internal {
+
+// Every parallel block moves at least this many elements, to amortize
+// scheduling costs.
+constexpr int64_t kTransposeMinBlockElements = 16 * 1024;
+
+// Square tiles of the innermost input and output dimensions. Every tile row
+// spans several full cache lines in the input and in the output, and a tile
+// of the input and a tile of the output stay in the L2 cache together.
+constexpr int64_t kTransposeTileSize = 64;
+
+template <typename T>
+struct IsPacketTransposable
+    : std::integral_constant<bool, (std::is_same<T, float>::value ||
+                                    std::is_same<T, double>::value) &&
+                                       Eigen::internal::packet_traits<
+                                           T>::Vectorizable> {};
+
+// Packet used for in-register block transposes: the widest packet with at
+// most 8 elements. Wider blocks (16x16 with AVX-512) are slower, because
+// every unaligned row load and store is split across two cache lines.
+template <typename T, typename Packet = typename Eigen::internal::packet_traits<
+                          T>::type,
+          bool = (Eigen::internal::unpacket_traits<Packet>::size <= 8)>
+struct TransposePacket {
+  using type = Packet;
+};
+
+template <typename T, typename Packet>
+struct TransposePacket<T, Packet, false>
+    : TransposePacket<
+          T, typename Eigen::internal::unpacket_traits<Packet>::half> {};
+
+// Computes `out[j * out_stride + i] = in[i * in_stride + j]` for all
+// `i < rows`, `j < cols` using packet block transposes.
+template <typename T>
+void TransposeTile(std::true_type, const T* in, int64_t in_stride, T* out,
+                   int64_t out_stride, int64_t rows, int64_t cols) {
+  using Packet = typename TransposePacket<T>::type;
+  constexpr int64_t kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  int64_t i = 0;
+  for (; i + kPacketSize <= rows; i += kPacketSize) {
+    int64_t j = 0;
+    for (; j + kPacketSize <= cols; j += kPacketSize) {
+      Eigen::internal::PacketBlock<Packet, kPacketSize> block;
+      for (int64_t k = 0; k < kPacketSize; ++k) {
+        block.packet[k] =
+            Eigen::internal::ploadu<Packet>(in + (i + k) * in_stride + j);
+      }
+      Eigen::internal::ptranspose(block);
+      for (int64_t k = 0; k < kPacketSize; ++k) {
+        Eigen::internal::pstoreu(out + (j + k) * out_stride + i,
+                                 block.packet[k]);
+      }
+    }
+    for (; j < cols; ++j) {
+      for (int64_t k = 0; k < kPacketSize; ++k)
+        out[j * out_stride + i + k] = in[(i + k) * in_stride + j];
+    }
+  }
+  for (; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j)
+      out[j * out_stride + i] = in[i * in_stride + j];
+  }
+}
+
+template <typename T>
+void TransposeTile(std::false_type, const T* in, int64_t in_stride, T* out,
+                   int64_t out_stride, int64_t rows, int64_t cols) {
+  for (int64_t i = 0; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j)
+      out[j * out_stride + i] = in[i * in_stride + j];
+  }
+}
+
+inline int64_t DivUp(int64_t a, int64_t b) { return (a + b - 1) / b; }
+
+}  // namespace internal
+
+// Computes the transpose of the `input` tensor with the simplified transpose
+// `plan` into the `output` tensor, and calls `done` when all elements are
+// moved. `input` and `output` must not alias.
+template <typename T>
+void AsyncTranspose(HostContext* host, const TransposePlan& plan,
+                    const T* input, T* output,
+                    llvm::unique_function<void()> done) {
+  const int rank = plan.dims.size();
+
+  int64_t num_elements = 1;
+  for (ssize_t dim : plan.dims) num_elements *= dim;
+
+  if (plan.IsIdentity() || num_elements == 0) {
+    std::memcpy(output, input, num_elements * sizeof(T));
+    done();
+    return;
+  }
+
+  // Strides of the input dimensions in the input and in the output.
+  llvm::SmallVector<int64_t, 4> in_strides(rank);
+  llvm::SmallVector<int64_t, 4> out_strides(rank);
+  for (int64_t d = rank - 1, in_stride = 1; d >= 0; --d) {
+    in_strides[d] = in_stride;
+    in_stride *= plan.dims[d];
+  }
+  for (int64_t i = rank - 1, out_stride = 1; i >= 0; --i) {
+    out_strides[plan.perm[i]] = out_stride;
+    out_stride *= plan.dims[plan.perm[i]];
+  }
+
+  // Input dimensions that are innermost in the input and in the output.
+  const int64_t in_inner = rank - 1;
+  const int64_t out_inner = plan.perm[rank - 1];
+
+  // The innermost dimension is not permuted: copy contiguous rows.
+  if (in_inner == out_inner) {
+    const int64_t row_size = plan.dims[in_inner];
+    const int64_t num_rows = num_elements / row_size;
+
+    auto compute = [=, dims = plan.dims, perm = plan.perm](size_t begin,
+                                                           size_t end) {
+      for (size_t row = begin; row < end; ++row) {
+        // Output rows are contiguous, find the matching input row.
+        int64_t index = row;
+        int64_t in_offset = 0;
+        for (int64_t i = rank - 2; i >= 0; --i) {
+          in_offset += index % dims[perm[i]] * in_strides[perm[i]];
+          index /= dims[perm[i]];
+        }
+        std::memcpy(output + row * row_size, input + in_offset,
+                    row_size * sizeof(T));
+      }
+    };
+
+    ParallelFor(host).Execute(
+        num_rows,
+        ParallelFor::BlockSizes::Min(internal::DivUp(
+            internal::kTransposeMinBlockElements, row_size)),
+        std::move(compute), std::move(done));
+    return;
+  }
+
+  // All other dimensions are iterated as a batch of tiled 2-D transposes.
+  llvm::SmallVector<int64_t, 4> batch_dims;
+  for (int64_t d = 0; d < rank; ++d) {
+    if (d != in_inner && d != out_inner) batch_dims.push_back(d);
+  }
+
+  const int64_t rows = plan.dims[out_inner];
+  const int64_t cols = plan.dims[in_inner];
+  const int64_t row_tiles = internal::DivUp(rows, internal::kTransposeTileSize);
+  const int64_t col_tiles = internal::DivUp(cols, internal::kTransposeTileSize);
+  const int64_t num_tiles =
+      num_elements / (rows * cols) * row_tiles * col_tiles;
+
+  auto compute = [=, dims = plan.dims](size_t begin, size_t end) {
+    constexpr int64_t kTile = internal::kTransposeTileSize;
+    for (size_t tile = begin; tile < end; ++tile) {
+      int64_t batch = tile / (row_tiles * col_tiles);
+      const int64_t row = (tile / col_tiles) % row_tiles * kTile;
+      const int64_t col = tile % col_tiles * kTile;
+
+      int64_t in_offset = row * in_strides[out_inner] + col;
+      int64_t out_offset = row + col * out_strides[in_inner];
+      for (auto it = batch_dims.rbegin(); it != batch_dims.rend(); ++it) {
+        const int64_t index = batch % dims[*it];
+        batch /= dims[*it];
+        in_offset += index * in_strides[*it];
+        out_offset += index * out_strides[*it];
+      }
+
+      internal::TransposeTile(internal::IsPacketTransposable<T>(),
+                              input + in_offset, in_strides[out_inner],
+                              output + out_offset, out_strides[in_inner],
+                              std::min(kTile, rows - row),
+                              std::min(kTile, cols - col));
+    }
+  };
+
+  constexpr int64_t kMinTilesPerBlock = std::max<int64_t>(
+      1, internal::kTransposeMinBlockElements /
+             (internal::kTransposeTileSize * internal::kTransposeTileSize));
+  ParallelFor(host).Execute(num_tiles,
+                            ParallelFor::BlockSizes::Min(kMinTilesPerBlock),
+                            std::move(compute), std::move(done));
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_COMPAT_EIGEN_TRANSPOSE_H_
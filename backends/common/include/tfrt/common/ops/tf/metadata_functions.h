@@ -28,6 +28,11 @@
 #include "tfrt/core_runtime/op_metadata_function.h"
 
 namespace tfrt {
+// The metadata function of tf.Transpose can not read the values of the `perm`
+// operand tensor, so tf.Transpose only supports this NHWC to NCHW permutation.
+// Other permutations must be folded into the `perm` attribute of _tf.Transpose.
+constexpr ssize_t kTfTransposeOperandPerm[] = {0, 3, 1, 2};
+
 // This function returns op names and corresponding metadata functions that
 // are used by TF Python API.
 llvm::ArrayRef<std::pair<llvm::StringRef, OpMetadataFn>>
@@ -205,6 +205,80 @@ class BatchNormOutputKernel {
   Eigen::Tensor<T, 1, Eigen::RowMajor> scaling_factor_;
 };
 
+// Applies batch normalization to the output block, and adds the residual
+// `shortcut` tensor before the activation function specified by `Activation`
+// type parameter (the tail of the ResNet block: conv -> batch_norm -> add ->
+// relu).
+//
+// The shortcut tensor must have the same shape as the convolution output, and
+// must not alias it. The position of an output block in the output tensor is
+// computed from the output block address, so that the shortcut values are
+// read block-wise while the output block is still in L1 cache.
+template <typename T, typename Activation = Identity>
+class BatchNormAddOutputKernel {
+  using Index = Eigen::Index;
+  using Vec = Eigen::Tensor<T, 1, Eigen::RowMajor, Index>;
+
+ public:
+  BatchNormAddOutputKernel(const EigenConstTensor<T, 1>& scale,
+                           const EigenConstTensor<T, 1>& offset,
+                           const EigenConstTensor<T, 1>& estimated_mean,
+                           const EigenConstTensor<T, 1>& estimated_variance,
+                           float epsilon, const T* shortcut_data,
+                           const T* output_data)
+      : offset_data_(offset.data()),
+        estimated_mean_data_(estimated_mean.data()),
+        shortcut_data_(shortcut_data),
+        output_data_(output_data) {
+    scaling_factor_ =
+        (estimated_variance + static_cast<T>(epsilon)).rsqrt() * scale;
+  }
+
+  EIGEN_ALWAYS_INLINE void operator()(
+      const internal::ContractionOutputMapper<T>& output_mapper,
+      const Eigen::TensorContractionParams& params, Index i, Index j,
+      Index num_rows, Index num_cols) const {
+    // There is no guarantee that any of the batch normalization parameters or
+    // the shortcut tensor will be aligned at the given offset.
+    using ScalingFactor = Eigen::TensorMap<const Vec, Eigen::Unaligned>;
+    using Offset = Eigen::TensorMap<const Vec, Eigen::Unaligned>;
+    using Mean = Eigen::TensorMap<const Vec, Eigen::Unaligned>;
+    using Shortcut = Eigen::TensorMap<const Vec, Eigen::Unaligned>;
+    using OutputChannels = Eigen::TensorMap<Vec, Eigen::Unaligned>;
+
+    assert(params.swapped_arguments &&
+           "Unexpected contraction output kernel parameters");
+    assert(i + num_rows <= scaling_factor_.size() &&
+           "Output block inner dimension is larger than the scaling factor");
+
+    const ScalingFactor scaling_factor(scaling_factor_.data() + i, num_rows);
+    const Offset offset(offset_data_ + i, num_rows);
+    const Mean mean(estimated_mean_data_ + i, num_rows);
+
+    for (Index col = 0; col < num_cols; ++col) {
+      T* output_base = &output_mapper(0, col);
+      OutputChannels output(output_base, num_rows);
+      const Shortcut shortcut(shortcut_data_ + (output_base - output_data_),
+                              num_rows);
+
+      auto scaled = (output - mean) * scaling_factor;
+      auto shifted = scaled + offset + shortcut;
+
+      output = Activation::template apply<decltype(shifted)>(shifted);
+    }
+  }
+
+ private:
+  const T* offset_data_;
+  const T* estimated_mean_data_;
+  const T* shortcut_data_;
+  const T* output_data_;
+
+  // Precomputed expression:
+  //   scaling_factor = (estimated_variance + epsilon).rsqrt() * scale
+  Eigen::Tensor<T, 1, Eigen::RowMajor> scaling_factor_;
+};
+
 }  // namespace compat
 }  // namespace tfrt
 
@@ -24,9 +24,12 @@
 #define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_H_
 
 #include <cstdint>
+#include <memory>
+#include <type_traits>
 
 #include "../contraction_output_kernel.h"
 #include "../spatial_convolution.h"
+#include "../winograd_convolution.h"
 #include "conv2d_shape_functions.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
@@ -44,6 +47,7 @@ namespace internal {
 using ::Eigen::Index;
 using ::tfrt::compat::AsEigenConstTensor;
 using ::tfrt::compat::AsEigenTensor;
+using ::tfrt::compat::BatchNormAddOutputKernel;
 using ::tfrt::compat::BiasAddOutputKernel;
 using ::tfrt::compat::SpatialConvolution;
 
@@ -72,6 +76,144 @@ inline llvm::Error CheckBatchNormArgs(const Conv2DParams& params,
   return llvm::Error::success();
 }
 
+// Algorithms used to compute 2D convolutions.
+enum class Conv2DAlgorithm {
+  // Eigen contraction of the image patches with the kernel (see
+  // spatial_convolution.h). Supports all convolution parameters.
+  kSpatialConvolution,
+  // 1x1 convolution with unit strides, computed as a contraction of the input
+  // reshaped to `[batch * height * width, in_channels]` with the kernel.
+  kPointwise,
+  // Winograd F(2x2, 3x3) for 3x3 float convolutions with unit strides and
+  // dilations (see winograd_convolution.h).
+  kWinograd,
+};
+
+// Heuristics for the Winograd convolution, measured with the ResNet-50 layer
+// shapes in conv2d.resnet50.benchmarks.mlir:
+//
+// - Convolutions with fewer channels don't have enough work in the
+//   element-wise products to pay for the input and output transforms.
+// - Filter transform and packing is done on every call, and it's amortized
+//   only if there are enough 2x2 output tiles, e.g. 7x7 outputs of the last
+//   ResNet-50 stage need batch size of at least 16.
+static constexpr ssize_t kWinogradMinChannels = 64;
+static constexpr ssize_t kWinogradMinTiles = 256;
+
+// Winograd convolution is implemented only for float. Other data types are
+// dispatched on this tag to the overloads that do not reference it.
+template <typename T>
+struct HasWinogradConv2D : std::is_same<T, float> {};
+
+// Selects the convolution algorithm for the convolution parameters.
+template <typename T>
+Conv2DAlgorithm SelectConv2DAlgorithm(const Conv2DParams& params) {
+  const FixedRankShape<4>& kernel_shape = params.kernel_shape;
+  const FixedRankShape<4>& output_shape = params.output_shape;
+
+  const bool unit_strides = params.strides[0] == 1 && params.strides[1] == 1;
+  const bool unit_dilations =
+      params.dilations[0] == 1 && params.dilations[1] == 1;
+
+  if (kernel_shape[0] == 1 && kernel_shape[1] == 1 && unit_strides &&
+      params.padding_type != PaddingType::kExplicit) {
+    return Conv2DAlgorithm::kPointwise;
+  }
+
+  const ssize_t num_tiles = output_shape[0] *
+                            ((output_shape[1] + 1) / 2) *
+                            ((output_shape[2] + 1) / 2);
+
+  if (HasWinogradConv2D<T>::value && kernel_shape[0] == 3 &&
+      kernel_shape[1] == 3 && unit_strides && unit_dilations &&
+      kernel_shape[2] >= kWinogradMinChannels &&
+      kernel_shape[3] >= kWinogradMinChannels &&
+      num_tiles >= kWinogradMinTiles) {
+    return Conv2DAlgorithm::kWinograd;
+  }
+
+  return Conv2DAlgorithm::kSpatialConvolution;
+}
+
+// Starts the convolution with the pointwise or the SpatialConvolution
+// algorithm. These algorithms are implemented for all data types, so this
+// overload is used for the data types that do not have a Winograd convolution.
+template <typename T, typename OutputKernel>
+void StartConv2D(std::false_type /*has_winograd*/, HostContext* host,
+                 Conv2DAlgorithm algorithm, const DHTIndexableView<T, 4>& input,
+                 const DHTIndexableView<T, 4>& kernel,
+                 const MutableDHTIndexableView<T, 4>& output,
+                 const Conv2DParams& params, OutputKernel output_kernel,
+                 llvm::unique_function<void()> on_done) {
+  assert(algorithm != Conv2DAlgorithm::kWinograd);
+
+  if (algorithm == Conv2DAlgorithm::kPointwise) {
+    const FixedRankShape<4>& kernel_shape = kernel.FixedShape();
+    const ssize_t rest_size = params.output_shape[0] *  // batch
+                              params.output_shape[1] *  // output height
+                              params.output_shape[2];   // output width
+
+    auto reshaped_in = FixedRankShape<2>({rest_size, kernel_shape[2]});
+    auto reshaped_kern = FixedRankShape<2>({kernel_shape[2], kernel_shape[3]});
+    auto reshaped_out = FixedRankShape<2>({rest_size, kernel_shape[3]});
+
+    auto input_t = AsEigenConstTensor(input, reshaped_in);
+    auto kernel_t = AsEigenConstTensor(kernel, reshaped_kern);
+    auto output_t = AsEigenTensor(output, reshaped_out);
+
+    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_dim({1, 0});
+    auto expr = input_t.contract(kernel_t, contract_dim, output_kernel);
+
+    AsyncAssign(host->GetOrCreateSharedContext<EigenHostContext>(),
+                std::move(output_t), std::move(expr), std::move(on_done));
+    return;
+  }
+
+  auto input_t = AsEigenConstTensor(input);
+  auto filter_t = AsEigenConstTensor(kernel);
+  auto output_t = AsEigenTensor(output);
+
+  // clang-format off
+  auto expr = SpatialConvolution(input_t, input.FixedShape(),
+                                 filter_t, kernel.FixedShape(),
+                                 /*strides=*/params.strides,
+                                 /*paddings=*/params.paddings,
+                                 /*dilations=*/params.dilations,
+                                 /*inflations=*/{1, 1},
+                                 /*output_kernel=*/output_kernel);
+  // clang-format on
+
+  AsyncAssign(host->GetOrCreateSharedContext<EigenHostContext>(),
+              std::move(output_t), std::move(expr), std::move(on_done));
+}
+
+// Float convolutions can also use the Winograd algorithm.
+template <typename T, typename OutputKernel>
+void StartConv2D(std::true_type /*has_winograd*/, HostContext* host,
+                 Conv2DAlgorithm algorithm, const DHTIndexableView<T, 4>& input,
+                 const DHTIndexableView<T, 4>& kernel,
+                 MutableDHTIndexableView<T, 4> output,
+                 const Conv2DParams& params, OutputKernel output_kernel,
+                 llvm::unique_function<void()> on_done) {
+  if (algorithm != Conv2DAlgorithm::kWinograd) {
+    StartConv2D<T>(std::false_type(), host, algorithm, input, kernel, output,
+                   params, std::move(output_kernel), std::move(on_done));
+    return;
+  }
+
+  const FixedRankShape<4>& in = params.input_shape;
+  const FixedRankShape<4>& out = params.output_shape;
+
+  AsyncWinogradConv2D(
+      host, input.data(), {in[0], in[1], in[2], in[3]}, kernel.data(),
+      params.kernel_shape[3],
+      {params.paddings[0], params.paddings[1], params.paddings[2],
+       params.paddings[3]},
+      output.data(), {out[0], out[1], out[2], out[3]},
+      std::make_unique<OutputKernel>(std::move(output_kernel)),
+      std::move(on_done));
+}
+
 template <typename T, typename OutputKernelBuilder>
 inline void Conv2DImpl(const DHTIndexableView<T, 4>& input,
                        const DHTIndexableView<T, 4>& kernel,
@@ -81,8 +223,6 @@ inline void Conv2DImpl(const DHTIndexableView<T, 4>& input,
                        OutputKernelBuilder output_kernel_builder,
                        KernelErrorHandler handler,
                        const ExecutionContext& exec_ctx, KernelFrame* frame) {
-  HostContext* host = exec_ctx.host();
-
   // Validate convolution parameters.
   auto params = ComputeConv2DParams(input.FixedShape(), kernel.FixedShape(),
                                     padding.get(), {strides[0], strides[1]});
@@ -99,48 +239,10 @@ inline void Conv2DImpl(const DHTIndexableView<T, 4>& input,
   auto on_done = [chain = chain_out.Allocate(),
                   frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
 
-  const FixedRankShape<4>& kernel_shape = kernel.FixedShape();
-
-  // 1x1 convolution can be computed as a simple Tensor contraction.
-  if (kernel_shape[0] == 1 && kernel_shape[1] == 1 &&  // 1x1 kernel
-      strides[0] == 1 && strides[1] == 1 &&            // 1x1 stride
-      params->padding_type != PaddingType::kExplicit) {
-    const ssize_t rest_size = params->output_shape[0] *  // batch
-                              params->output_shape[1] *  // output height
-                              params->output_shape[2];   // output width
-
-    auto reshaped_in = FixedRankShape<2>({rest_size, kernel_shape[2]});
-    auto reshaped_kern = FixedRankShape<2>({kernel_shape[2], kernel_shape[3]});
-    auto reshaped_out = FixedRankShape<2>({rest_size, kernel_shape[3]});
-
-    auto input_t = AsEigenConstTensor(input, reshaped_in);
-    auto kernel_t = AsEigenConstTensor(kernel, reshaped_kern);
-    auto output_t = AsEigenTensor(output, reshaped_out);
-
-    Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_dim({1, 0});
-    auto expr = input_t.contract(kernel_t, contract_dim, output_kernel.get());
-
-    AsyncAssign(host->GetOrCreateSharedContext<EigenHostContext>(),
-                std::move(output_t), std::move(expr), std::move(on_done));
-
-  } else {
-    auto input_t = AsEigenConstTensor(input);
-    auto filter_t = AsEigenConstTensor(kernel);
-    auto output_t = AsEigenTensor(output);
-
-    // clang-format off
-    auto expr = SpatialConvolution(input_t, input.FixedShape(),
-                                   filter_t, kernel.FixedShape(),
-                                   /*strides=*/{strides[0], strides[1]},
-                                   /*paddings=*/params->paddings,
-                                   /*dilations=*/params->dilations,
-                                   /*inflations=*/{1, 1},
-                                   /*output_kernel=*/output_kernel.get());
-    // clang-format on
-
-    AsyncAssign(host->GetOrCreateSharedContext<EigenHostContext>(),
-                std::move(output_t), std::move(expr), std::move(on_done));
-  }
+  StartConv2D<T>(HasWinogradConv2D<T>(), exec_ctx.host(),
+                 SelectConv2DAlgorithm<T>(params.get()), input, kernel, output,
+                 params.get(), std::move(output_kernel.get()),
+                 std::move(on_done));
 }
 
 template <typename T>
@@ -195,6 +297,51 @@ void Conv2DBatchNorm(ArgumentView<DHTIndexableView<T, 4>> input,
                 strides, std::move(output_kernel), handler, exec_ctx, frame);
 }
 
+// Conv2D + FusedBatchNorm + residual Add + Activation, e.g. the tail of the
+// ResNet block. `shortcut` has the same shape as the output.
+template <typename T, typename Activation = Identity>
+void Conv2DBatchNormAdd(
+    ArgumentView<DHTIndexableView<T, 4>> input,
+    ArgumentView<DHTIndexableView<T, 4>> kernel,
+    ArgumentView<DHTIndexableView<T, 1>> scale,   // aka gamma
+    ArgumentView<DHTIndexableView<T, 1>> offset,  // aka beta
+    ArgumentView<DHTIndexableView<T, 1>> estimated_mean,
+    ArgumentView<DHTIndexableView<T, 1>> estimated_variance,
+    ArgumentView<DHTIndexableView<T, 4>> shortcut,
+    ArgumentView<MutableDHTIndexableView<T, 4>> output,
+    Argument<Chain> chain_in, Result<Chain> chain_out, Attribute<float> epsilon,
+    StringAttribute padding, ArrayAttribute<ssize_t> strides,
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+    KernelFrame* frame) {
+  using OutputKernel = llvm::Expected<BatchNormAddOutputKernel<T, Activation>>;
+
+  auto output_kernel = [&](Conv2DParams params) -> OutputKernel {
+    if (auto err = CheckBatchNormArgs(
+            params, scale->FixedShape(), offset->FixedShape(),
+            estimated_mean->FixedShape(), estimated_variance->FixedShape())) {
+      return std::move(err);
+    }
+    if (auto err = CheckShapeMatch("shortcut shape", shortcut->FixedShape(),
+                                   "output shape", params.output_shape)) {
+      return std::move(err);
+    }
+    // The output kernel reads the shortcut after the output block is written.
+    if (shortcut->data() == output->data()) {
+      return MakeStringError("shortcut must not alias output");
+    }
+
+    return BatchNormAddOutputKernel<T, Activation>(
+        AsEigenConstTensor(scale.get()),               // gamma
+        AsEigenConstTensor(offset.get()),              // beta
+        AsEigenConstTensor(estimated_mean.get()),      // mean
+        AsEigenConstTensor(estimated_variance.get()),  // variance
+        epsilon.get(), shortcut->data(), output->data());
+  };
+
+  Conv2DImpl<T>(input.get(), kernel.get(), output.get(), chain_out, padding,
+                strides, std::move(output_kernel), handler, exec_ctx, frame);
+}
+
 template <typename T, typename Activation = Identity>
 void Conv2DBias(ArgumentView<DHTIndexableView<T, 4>> input,
                 ArgumentView<DHTIndexableView<T, 4>> kernel,
@@ -19,7 +19,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "../contraction_kernel.h"
+#include "../packed_weights.h"
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/common/compat/eigen/small_matmul.h"
 #include "tfrt/common/compat/eigen/tensor_types.h"
 #include "tfrt/host_context/kernel_utils.h"
 
@@ -34,6 +36,10 @@ using ::tfrt::compat::AsEigenTensor;
 //   C = alpha * AB + beta * C
 //
 // Link: https://en.wikipedia.org/wiki/Basic_Linear_Algebra_Subprograms#Level_3
+//
+// Small products are computed by the SmallMatMul micro kernel, medium ones by
+// Eigen tensor contraction in the caller thread, and only large ones in the
+// thread pool (see SelectMatMulStrategy).
 template <typename T>
 void MatMul(Argument<T> alpha, ArgumentView<DHTIndexableView<T, 2>> a,
             ArgumentView<DHTIndexableView<T, 2>> b, Argument<T> beta,
@@ -56,33 +62,106 @@ void MatMul(Argument<T> alpha, ArgumentView<DHTIndexableView<T, 2>> a,
     return;
   }
 
+  const Index m = shape_c[0];
+  const Index n = shape_c[1];
+  const Index k = shape_a[1];
+  const MatMulStrategy strategy = SelectMatMulStrategy(m, n, k);
+
+  // Small matrices are multiplied synchronously, without the tensor
+  // contraction and thread pool overheads.
+  if (strategy == MatMulStrategy::kSmall) {
+    SmallMatMul<T>(alpha.get(), a->data(), k, b->data(), n, beta.get(),
+                   c->data(), n, m, n, k);
+    chain_out.Set(chain_in);
+    return;
+  }
+
   // Contraction dimension.
   Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> contract_dim({1, 0});
 
-  auto on_done = [chain = chain_out.Allocate(),
-                  frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
-
   auto in0 = AsEigenConstTensor(a.get());
   auto in1 = AsEigenConstTensor(b.get());
   auto out = AsEigenTensor(c.get());
 
-  const EigenHostContext& cpu =
-      exec_ctx.host()->GetOrCreateSharedContext<EigenHostContext>();
+  auto assign = [&](auto expr) {
+    if (strategy == MatMulStrategy::kSingleThreaded) {
+      out = expr;
+      chain_out.Set(chain_in);
+      return;
+    }
 
-  if (alpha.get() == 1.0 && beta.get() == 0.0) {
-    auto expr = in0.contract(in1, contract_dim);
+    auto on_done = [chain = chain_out.Allocate(),
+                    frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
+
+    const EigenHostContext& cpu =
+        exec_ctx.host()->GetOrCreateSharedContext<EigenHostContext>();
     AsyncAssign(cpu, std::move(out), std::move(expr), std::move(on_done));
+  };
+
+  if (alpha.get() == 1.0 && beta.get() == 0.0) {
+    assign(in0.contract(in1, contract_dim));
 
   } else if (alpha.get() == 1.0) {
-    auto expr =
-        in0.contract(in1, contract_dim) + out.constant(beta.get()) * out;
-    AsyncAssign(cpu, std::move(out), std::move(expr), std::move(on_done));
+    assign(in0.contract(in1, contract_dim) + out.constant(beta.get()) * out);
 
   } else {
-    auto expr = out.constant(alpha.get()) * in0.contract(in1, contract_dim) +
-                out.constant(beta.get()) * out;
-    AsyncAssign(cpu, std::move(out), std::move(expr), std::move(on_done));
+    assign(out.constant(alpha.get()) * in0.contract(in1, contract_dim) +
+           out.constant(beta.get()) * out);
+  }
+}
+
+// Packs the 2-D `weights` for use as the right hand side of MatMulPacked. The
+// packed panels are cached per weights buffer, so packing the same weights
+// again (e.g. in every inference step) returns the cached panels.
+template <typename T>
+Expected<RCReference<PackedMatMulRhs<T>>> PackMatMulRhs(
+    const DenseHostTensor& weights, Argument<Chain> chain_in,
+    const ExecutionContext& exec_ctx) {
+  if (weights.shape().GetRank() != 2) {
+    return MakeStringError("PackMatMulRhs weights must be a 2-D tensor: ",
+                           weights.shape());
+  }
+  if (weights.dtype() != GetDType<T>()) {
+    return MakeStringError("PackMatMulRhs weights dtype mismatch: ",
+                           weights.dtype(), " vs. ", GetDType<T>());
   }
+  auto& cache = exec_ctx.host()
+                    ->GetOrCreateSharedContext<
+                        PackedWeightCache<PackedMatMulRhs<T>>>();
+  return cache.GetOrPack(weights, weights.shape().GetDimensionSize(0),
+                         weights.shape().GetDimensionSize(1));
+}
+
+// Matrix multiplication kernel with a pre-packed right hand side:
+//   C = A * B
+//
+// Skips the packing of B, that Eigen tensor contraction does on every call.
+template <typename T>
+void MatMulPacked(ArgumentView<DHTIndexableView<T, 2>> a,
+                  Argument<RCReference<PackedMatMulRhs<T>>> b,
+                  ArgumentView<MutableDHTIndexableView<T, 2>> c,
+                  Argument<Chain> chain_in, Result<Chain> chain_out,
+                  KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+                  KernelFrame* frame) {
+  const auto& shape_a = a->FixedShape();
+  const auto& shape_c = c->FixedShape();
+  if (shape_a[1] != (*b)->depth()) {
+    handler.ReportError("MatMulPacked input tensors inner dimension mismatch: ",
+                        shape_a, " vs. ", (*b)->depth());
+    return;
+  }
+  if (shape_c[0] != shape_a[0] || shape_c[1] != (*b)->cols()) {
+    handler.ReportError("MatMulPacked output shape ", shape_c,
+                        " does not match product shape of inputs: ", shape_a,
+                        " * [", (*b)->depth(), ", ", (*b)->cols(), "]");
+    return;
+  }
+
+  auto on_done = [chain = chain_out.Allocate(),
+                  frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
+
+  AsyncMatMulPacked<T>(exec_ctx.host(), a->data(), shape_a[0], b->CopyRef(),
+                       c->data(), std::move(on_done));
 }
 
 }  // namespace compat
@@ -90,6 +169,10 @@ void MatMul(Argument<T> alpha, ArgumentView<DHTIndexableView<T, 2>> a,
 void RegisterMatMulKernels(KernelRegistry* registry) {
   registry->AddKernel("eigen.matmul.f32", TFRT_KERNEL(compat::MatMul<float>));
   registry->AddKernel("eigen.matmul.i32", TFRT_KERNEL(compat::MatMul<int32_t>));
+  registry->AddKernel("eigen.pack_matmul_rhs.f32",
+                      TFRT_KERNEL(compat::PackMatMulRhs<float>));
+  registry->AddKernel("eigen.matmul.packed.f32",
+                      TFRT_KERNEL(compat::MatMulPacked<float>));
 }
 
 }  // namespace tfrt
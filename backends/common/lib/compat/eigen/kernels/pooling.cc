@@ -0,0 +1,122 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- pooling.cc ------------------------------------------------*- C++-*-===//
+//
+// Max, average and global average pooling kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+
+#include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/common/compat/eigen/pooling.h"
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+
+namespace tfrt {
+namespace compat {
+
+template <PoolingType type, typename T>
+static void Pool2D(ArgumentView<DHTIndexableView<T, 4>> input,
+                   ArgumentView<MutableDHTIndexableView<T, 4>> output,
+                   Argument<Chain> chain_in, Result<Chain> chain_out,
+                   StringAttribute padding, ArrayAttribute<ssize_t> pool_size,
+                   ArrayAttribute<ssize_t> strides, KernelErrorHandler handler,
+                   const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  const char* name = type == PoolingType::kMax ? "MaxPool2D" : "AvgPool2D";
+
+  if (pool_size.size() != 2) {
+    handler.ReportError(name, " expects pool_size to have 2 elements");
+    return;
+  }
+
+  if (strides.size() != 2) {
+    handler.ReportError(name, " expects strides to have 2 elements");
+    return;
+  }
+
+  // Shapes have format (batch_size, height, width, channel_num).
+  const auto& shape_input = input->FixedShape();
+  const auto& shape_output = output->FixedShape();
+
+  auto params = ComputePool2DParams(
+      {shape_input[0], shape_input[1], shape_input[2], shape_input[3]},
+      {pool_size[0], pool_size[1]}, {strides[0], strides[1]}, padding.get());
+  TFRT_RETURN_IF_ERROR(handler, params.takeError());
+
+  const auto& expected = params->output_shape;
+  typename MutableDHTIndexableView<T, 4>::FixedShapeType expected_output_shape(
+      {expected[0], expected[1], expected[2], expected[3]});
+
+  if (shape_output != expected_output_shape) {
+    handler.ReportError(name, " output shape ", shape_output,
+                        " does not match the expected output shape ",
+                        expected_output_shape);
+    return;
+  }
+
+  AsyncPool2D<T>(exec_ctx.host(), type, *params, input->data(),
+                 output->data(),
+                 [chain = chain_out.Allocate(),
+                  frame = RAIIKernelFrame(*frame)]() { chain.emplace(); });
+}
+
+template <typename T>
+static void GlobalAveragePool(
+    ArgumentView<DHTIndexableView<T, 4>> input,
+    ArgumentView<MutableDHTIndexableView<T, 2>> output,
+    Argument<Chain> chain_in, Result<Chain> chain_out,
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+    KernelFrame* frame) {
+  // Input has format (batch_size, height, width, channel_num), and output has
+  // format (batch_size, channel_num).
+  const auto& shape_input = input->FixedShape();
+  const auto& shape_output = output->FixedShape();
+
+  typename MutableDHTIndexableView<T, 2>::FixedShapeType expected_output_shape(
+      {shape_input[0], shape_input[3]});
+
+  if (shape_output != expected_output_shape) {
+    handler.ReportError("GlobalAveragePool output shape ", shape_output,
+                        " does not match the expected output shape ",
+                        expected_output_shape);
+    return;
+  }
+
+  AsyncGlobalAveragePool<T>(
+      exec_ctx.host(),
+      {shape_input[0], shape_input[1], shape_input[2], shape_input[3]},
+      input->data(), output->data(),
+      [chain = chain_out.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
+}
+
+}  // namespace compat
+
+void RegisterPoolingKernels(KernelRegistry* registry) {
+  registry->AddKernel(
+      "eigen.max_pooling_2d.f32",
+      TFRT_KERNEL(compat::Pool2D<compat::PoolingType::kMax, float>));
+  registry->AddKernel(
+      "eigen.avg_pooling_2d.f32",
+      TFRT_KERNEL(compat::Pool2D<compat::PoolingType::kAvg, float>));
+  registry->AddKernel("eigen.global_avg_pooling.f32",
+                      TFRT_KERNEL(compat::GlobalAveragePool<float>));
+}
+
+}  // namespace tfrt
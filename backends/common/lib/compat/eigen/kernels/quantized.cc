@@ -0,0 +1,396 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- quantized.cc ----------------------------------------------*- C++-*-===//
+//
+// Quantized (uint8 activations, int8 weights) matmul and conv2d kernels.
+//
+// Quantized values are encoded as `real = scale * (quantized - zero_point)`.
+// Weights are symmetric (zero point is 0), and the activations zero point is
+// passed as an attribute. Each output channel has an int32 bias and a float
+// requantization multiplier `input_scale * weights_scale / output_scale`.
+//
+// The plain kernels pack the weights on every call. Constant weights can be
+// packed once by the eigen.pack_*.qi8 kernels and passed to the .packed
+// kernels instead.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "../packed_weights.h"
+#include "../quantized_gemm.h"
+#include "conv2d.h"
+#include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/host_context/kernel_utils.h"
+
+namespace tfrt {
+namespace compat {
+
+using ::Eigen::Index;
+
+namespace {
+
+llvm::Error CheckRequantizeArgs(ssize_t channels,
+                                const FixedRankShape<1>& bias_shape,
+                                const FixedRankShape<1>& scale_shape) {
+  if (auto err = CheckDimensionMatch("bias shape", bias_shape[0],
+                                     "output channels size", channels)) {
+    return err;
+  }
+  return CheckDimensionMatch("scale shape", scale_shape[0],
+                             "output channels size", channels);
+}
+
+// Packs the RowMajor `depth` x `cols` matrix `weights`.
+RCReference<PackedQuantizedWeights> PackWeights(const int8_t* weights,
+                                                Index depth, Index cols) {
+  return TakeRef(new PackedQuantizedWeights(weights, depth, cols));
+}
+
+// Returns the int8 `weights` viewed as a RowMajor `depth` x `cols` matrix and
+// packed. Packed weights are cached per weights buffer, so the weights must not
+// be modified after they were packed.
+Expected<RCReference<PackedQuantizedWeights>> GetOrPackWeights(
+    const DenseHostTensor& weights, Index depth, Index cols,
+    HostContext* host) {
+  if (weights.dtype() != GetDType<int8_t>()) {
+    return MakeStringError("quantized weights dtype mismatch: ",
+                           weights.dtype(), " vs. ", GetDType<int8_t>());
+  }
+  auto& cache = host->GetOrCreateSharedContext<
+      PackedWeightCache<PackedQuantizedWeights>>();
+  return cache.GetOrPack(weights, depth, cols);
+}
+
+}  // namespace
+
+// Int8 HWIO convolution filter packed as a `[KH*KW*IC, OC]` matrix.
+struct PackedQuantizedConv2DFilter {
+  FixedRankShape<4> shape;
+  RCReference<PackedQuantizedWeights> weights;
+};
+
+// Packs the 2-D int8 `weights` for use as the right hand side of
+// MatMulQuantizedPacked. Like PackMatMulRhs, packed weights are cached per
+// weights buffer, so the caller must not modify the weights after they were
+// packed.
+Expected<RCReference<PackedQuantizedWeights>> PackQuantizedMatMulRhs(
+    const DenseHostTensor& weights, Argument<Chain> chain_in,
+    const ExecutionContext& exec_ctx) {
+  const TensorShape& shape = weights.shape();
+  if (shape.GetRank() != 2) {
+    return MakeStringError(
+        "PackQuantizedMatMulRhs weights must be a 2-D tensor: ", shape);
+  }
+  return GetOrPackWeights(weights, shape.GetDimensionSize(0),
+                          shape.GetDimensionSize(1), exec_ctx.host());
+}
+
+// Packs the 4-D int8 HWIO `filter` for use by Conv2DQuantizedPacked. Packed
+// filters are cached per filter buffer, so the caller must not modify the
+// filter after it was packed.
+Expected<PackedQuantizedConv2DFilter> PackQuantizedConv2DFilter(
+    const DenseHostTensor& filter, Argument<Chain> chain_in,
+    const ExecutionContext& exec_ctx) {
+  if (filter.shape().GetRank() != 4) {
+    return MakeStringError(
+        "PackQuantizedConv2DFilter filter must be a 4-D tensor: ",
+        filter.shape());
+  }
+  FixedRankShape<4> shape(filter.shape());
+  auto weights = GetOrPackWeights(filter, shape[0] * shape[1] * shape[2],
+                                  shape[3], exec_ctx.host());
+  if (!weights) return weights.takeError();
+  return PackedQuantizedConv2DFilter{shape, std::move(*weights)};
+}
+
+// Quantized matrix multiplication of `a` by the `b` matrix with shape
+// `shape_b`. `get_weights()` returns `b` packed, it is called after the
+// arguments are validated.
+template <typename Activation, typename GetWeights>
+void MatMulQuantizedImpl(const DHTIndexableView<uint8_t, 2>& a,
+                         const FixedRankShape<2>& shape_b,
+                         GetWeights get_weights,
+                         const DHTIndexableView<int32_t, 1>& bias,
+                         const DHTIndexableView<float, 1>& scale,
+                         const MutableDHTIndexableView<uint8_t, 2>& c,
+                         Result<Chain> chain_out, int32_t input_zero_point,
+                         int32_t output_zero_point, KernelErrorHandler handler,
+                         const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  const auto& shape_a = a.FixedShape();
+  const auto& shape_c = c.FixedShape();
+  if (shape_a[1] != shape_b[0]) {
+    handler.ReportError("MatMul input tensors inner dimension mismatch: ",
+                        shape_a, " vs. ", shape_b);
+    return;
+  }
+  if (shape_c[0] != shape_a[0] || shape_c[1] != shape_b[1]) {
+    handler.ReportError("MatMul output shape ", shape_c,
+                        " does not match product shape of inputs: ", shape_a,
+                        " * ", shape_b);
+    return;
+  }
+  TFRT_RETURN_IF_ERROR(handler, CheckRequantizeArgs(shape_b[1],
+                                                    bias.FixedShape(),
+                                                    scale.FixedShape()));
+
+  RCReference<PackedQuantizedWeights> weights = get_weights();
+  auto output_kernel = std::make_unique<RequantizeOutputKernel<Activation>>(
+      AsEigenConstTensor(bias), AsEigenConstTensor(scale),
+      weights->column_sums(), input_zero_point, output_zero_point);
+
+  auto on_done = [chain = chain_out.Allocate(),
+                  frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
+
+  const uint8_t* data = a.data();
+  const Index depth = shape_a[1];
+  auto load_rows = [data, depth](size_t begin, size_t end,
+                                 std::vector<uint8_t>*) {
+    return data + begin * depth;
+  };
+
+  AsyncQuantizedGemm(exec_ctx.host(), shape_a[0], depth, std::move(load_rows),
+                     std::move(weights), std::move(output_kernel), c.data(),
+                     std::move(on_done));
+}
+
+// Quantized matrix multiplication kernel:
+//   C = requantize(A * B + bias)
+//
+// B is packed on every call, see MatMulQuantizedPacked for constant weights.
+template <typename Activation = Identity>
+void MatMulQuantized(ArgumentView<DHTIndexableView<uint8_t, 2>> a,
+                     ArgumentView<DHTIndexableView<int8_t, 2>> b,
+                     ArgumentView<DHTIndexableView<int32_t, 1>> bias,
+                     ArgumentView<DHTIndexableView<float, 1>> scale,
+                     ArgumentView<MutableDHTIndexableView<uint8_t, 2>> c,
+                     Argument<Chain> chain_in, Result<Chain> chain_out,
+                     Attribute<int32_t> input_zero_point,
+                     Attribute<int32_t> output_zero_point,
+                     KernelErrorHandler handler,
+                     const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  const auto& shape_b = b->FixedShape();
+  auto pack = [&]() { return PackWeights(b->data(), shape_b[0], shape_b[1]); };
+  MatMulQuantizedImpl<Activation>(
+      a.get(), shape_b, pack, bias.get(), scale.get(), c.get(), chain_out,
+      input_zero_point.get(), output_zero_point.get(), handler, exec_ctx,
+      frame);
+}
+
+// Quantized matrix multiplication kernel with a pre-packed B:
+//   C = requantize(A * B + bias)
+template <typename Activation = Identity>
+void MatMulQuantizedPacked(
+    ArgumentView<DHTIndexableView<uint8_t, 2>> a,
+    Argument<RCReference<PackedQuantizedWeights>> b,
+    ArgumentView<DHTIndexableView<int32_t, 1>> bias,
+    ArgumentView<DHTIndexableView<float, 1>> scale,
+    ArgumentView<MutableDHTIndexableView<uint8_t, 2>> c,
+    Argument<Chain> chain_in, Result<Chain> chain_out,
+    Attribute<int32_t> input_zero_point, Attribute<int32_t> output_zero_point,
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+    KernelFrame* frame) {
+  const FixedRankShape<2> shape_b({(*b)->depth(), (*b)->cols()});
+  auto get_weights = [&]() { return b->CopyRef(); };
+  MatMulQuantizedImpl<Activation>(
+      a.get(), shape_b, get_weights, bias.get(), scale.get(), c.get(),
+      chain_out, input_zero_point.get(), output_zero_point.get(), handler,
+      exec_ctx, frame);
+}
+
+// Quantized 2D convolution of the NHWC `input` with the HWIO filter with shape
+// `filter_shape`. `get_weights()` returns the filter packed as a
+// `[KH*KW*IC, OC]` matrix, it is called after the arguments are validated.
+//
+// Convolution is computed as a matrix multiplication of image patches
+// `[N*OH*OW, KH*KW*IC]` with the filter reshaped to `[KH*KW*IC, OC]`. Image
+// patches are materialized one block of output pixels at a time. Padded
+// values are filled with the input zero point, which is a quantized real zero.
+template <typename Activation, typename GetWeights>
+void Conv2DQuantizedImpl(const DHTIndexableView<uint8_t, 4>& input,
+                         const FixedRankShape<4>& filter_shape,
+                         GetWeights get_weights,
+                         const DHTIndexableView<int32_t, 1>& bias,
+                         const DHTIndexableView<float, 1>& scale,
+                         const MutableDHTIndexableView<uint8_t, 4>& output,
+                         Result<Chain> chain_out, int32_t input_zero_point,
+                         int32_t output_zero_point, StringAttribute padding,
+                         ArrayAttribute<ssize_t> strides,
+                         KernelErrorHandler handler,
+                         const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  auto params = ComputeConv2DParams(input.FixedShape(), filter_shape,
+                                    padding.get(), {strides[0], strides[1]});
+  TFRT_RETURN_IF_ERROR(handler, params.takeError());
+  TFRT_RETURN_IF_ERROR(
+      handler, CheckShapeMatch("output tensor shape", output.FixedShape(),
+                               "computed output shape", params->output_shape));
+  TFRT_RETURN_IF_ERROR(
+      handler, CheckRequantizeArgs(params->output_shape[3], bias.FixedShape(),
+                                   scale.FixedShape()));
+
+  const FixedRankShape<4>& in = params->input_shape;
+  const FixedRankShape<4>& kern = params->kernel_shape;
+  const FixedRankShape<4>& out = params->output_shape;
+
+  const Index patch_size = kern[0] * kern[1] * kern[2];
+  RCReference<PackedQuantizedWeights> weights = get_weights();
+  auto output_kernel = std::make_unique<RequantizeOutputKernel<Activation>>(
+      AsEigenConstTensor(bias), AsEigenConstTensor(scale),
+      weights->column_sums(), input_zero_point, output_zero_point);
+
+  auto on_done = [chain = chain_out.Allocate(),
+                  frame = RAIIKernelFrame(*frame)]() { chain.emplace(); };
+
+  const bool is_pointwise = kern[0] == 1 && kern[1] == 1 &&
+                            params->strides[0] == 1 &&
+                            params->strides[1] == 1 &&
+                            params->padding_type != PaddingType::kExplicit;
+
+  // 1x1 convolution with unit strides multiplies input pixels directly.
+  const uint8_t* data = input.data();
+  if (is_pointwise) {
+    auto load_rows = [data, patch_size](size_t begin, size_t end,
+                                        std::vector<uint8_t>*) {
+      return data + begin * patch_size;
+    };
+    AsyncQuantizedGemm(exec_ctx.host(), out[0] * out[1] * out[2], patch_size,
+                       std::move(load_rows), std::move(weights),
+                       std::move(output_kernel), output.data(),
+                       std::move(on_done));
+    return;
+  }
+
+  const uint8_t zero_point = static_cast<uint8_t>(input_zero_point);
+  auto load_rows = [data, in, kern, out, params = params.get(), patch_size,
+                    zero_point](size_t begin, size_t end,
+                                std::vector<uint8_t>* scratch) {
+    scratch->resize((end - begin) * patch_size);
+    const Index channels = in[3];
+
+    for (size_t pixel = begin; pixel < end; ++pixel) {
+      const Index batch = pixel / (out[1] * out[2]);
+      const Index oh = (pixel / out[2]) % out[1];
+      const Index ow = pixel % out[2];
+      uint8_t* patch = scratch->data() + (pixel - begin) * patch_size;
+
+      for (Index kh = 0; kh < kern[0]; ++kh) {
+        const Index ih = oh * params.strides[0] + kh * params.dilations[0] -
+                         params.paddings[0];
+        for (Index kw = 0; kw < kern[1]; ++kw) {
+          const Index iw = ow * params.strides[1] + kw * params.dilations[1] -
+                           params.paddings[2];
+          uint8_t* dst = patch + (kh * kern[1] + kw) * channels;
+          if (ih < 0 || ih >= in[1] || iw < 0 || iw >= in[2]) {
+            std::fill(dst, dst + channels, zero_point);
+          } else {
+            std::memcpy(dst,
+                        data + ((batch * in[1] + ih) * in[2] + iw) * channels,
+                        channels);
+          }
+        }
+      }
+    }
+    return scratch->data();
+  };
+
+  AsyncQuantizedGemm(exec_ctx.host(), out[0] * out[1] * out[2], patch_size,
+                     std::move(load_rows), std::move(weights),
+                     std::move(output_kernel), output.data(),
+                     std::move(on_done));
+}
+
+
+// Quantized 2D convolution kernel with NHWC input and HWIO filter:
+//   output = requantize(conv2d(input, filter) + bias)
+//
+// The filter is packed on every call, see Conv2DQuantizedPacked for constant
+// filters.
+template <typename Activation = Identity>
+void Conv2DQuantized(ArgumentView<DHTIndexableView<uint8_t, 4>> input,
+                     ArgumentView<DHTIndexableView<int8_t, 4>> filter,
+                     ArgumentView<DHTIndexableView<int32_t, 1>> bias,
+                     ArgumentView<DHTIndexableView<float, 1>> scale,
+                     ArgumentView<MutableDHTIndexableView<uint8_t, 4>> output,
+                     Argument<Chain> chain_in, Result<Chain> chain_out,
+                     Attribute<int32_t> input_zero_point,
+                     Attribute<int32_t> output_zero_point,
+                     StringAttribute padding, ArrayAttribute<ssize_t> strides,
+                     KernelErrorHandler handler,
+                     const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  const auto& shape = filter->FixedShape();
+  auto pack = [&]() {
+    return PackWeights(filter->data(), shape[0] * shape[1] * shape[2],
+                       shape[3]);
+  };
+  Conv2DQuantizedImpl<Activation>(
+      input.get(), shape, pack, bias.get(), scale.get(), output.get(),
+      chain_out, input_zero_point.get(), output_zero_point.get(), padding,
+      strides, handler, exec_ctx, frame);
+}
+
+// Quantized 2D convolution kernel with NHWC input and a pre-packed filter:
+//   output = requantize(conv2d(input, filter) + bias)
+template <typename Activation = Identity>
+void Conv2DQuantizedPacked(
+    ArgumentView<DHTIndexableView<uint8_t, 4>> input,
+    Argument<PackedQuantizedConv2DFilter> filter,
+    ArgumentView<DHTIndexableView<int32_t, 1>> bias,
+    ArgumentView<DHTIndexableView<float, 1>> scale,
+    ArgumentView<MutableDHTIndexableView<uint8_t, 4>> output,
+    Argument<Chain> chain_in, Result<Chain> chain_out,
+    Attribute<int32_t> input_zero_point, Attribute<int32_t> output_zero_point,
+    StringAttribute padding, ArrayAttribute<ssize_t> strides,
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+    KernelFrame* frame) {
+  auto get_weights = [&]() { return filter->weights.CopyRef(); };
+  Conv2DQuantizedImpl<Activation>(
+      input.get(), filter->shape, get_weights, bias.get(), scale.get(),
+      output.get(), chain_out, input_zero_point.get(), output_zero_point.get(),
+      padding, strides, handler, exec_ctx, frame);
+}
+
+}  // namespace compat
+
+void RegisterQuantizedKernels(KernelRegistry* registry) {
+  registry->AddKernel("eigen.matmul.qi8",
+                      TFRT_KERNEL(compat::MatMulQuantized<>));
+  registry->AddKernel("eigen.matmul.relu.qi8",
+                      TFRT_KERNEL(compat::MatMulQuantized<compat::Relu>));
+  registry->AddKernel("eigen.conv2d.qi8",
+                      TFRT_KERNEL(compat::Conv2DQuantized<>));
+  registry->AddKernel("eigen.conv2d.relu.qi8",
+                      TFRT_KERNEL(compat::Conv2DQuantized<compat::Relu>));
+
+  registry->AddKernel("eigen.pack_matmul_rhs.qi8",
+                      TFRT_KERNEL(compat::PackQuantizedMatMulRhs));
+  registry->AddKernel("eigen.matmul.packed.qi8",
+                      TFRT_KERNEL(compat::MatMulQuantizedPacked<>));
+  registry->AddKernel(
+      "eigen.matmul.packed.relu.qi8",
+      TFRT_KERNEL(compat::MatMulQuantizedPacked<compat::Relu>));
+  registry->AddKernel("eigen.pack_conv2d_filter.qi8",
+                      TFRT_KERNEL(compat::PackQuantizedConv2DFilter));
+  registry->AddKernel("eigen.conv2d.packed.qi8",
+                      TFRT_KERNEL(compat::Conv2DQuantizedPacked<>));
+  registry->AddKernel(
+      "eigen.conv2d.packed.relu.qi8",
+      TFRT_KERNEL(compat::Conv2DQuantizedPacked<compat::Relu>));
+}
+
+}  // namespace tfrt
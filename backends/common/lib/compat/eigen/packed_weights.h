@@ -0,0 +1,261 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- packed_weights.h -----------------------------------------*- C++ -*-===//
+//
+// Matrix multiplication with a pre-packed right hand side.
+//
+// Eigen tensor contraction packs blocks of both contraction inputs into the
+// panel format expected by the gebp kernel (see "Anatomy of High-Performance
+// Matrix Multiplication") every time the contraction is evaluated. In
+// inference the right hand side is usually a constant weight matrix, so its
+// packed panels can be computed once and reused by all later invocations.
+//
+// IMPORTANT: Like Eigen TensorContraction, we compute the RowMajor
+// `C[MxN] = A[MxK] * B[KxN]` as the ColMajor `C^T = B^T * A^T`. The weights
+// `B^T` become the gebp lhs, that is packed ahead of time, and the activations
+// `A^T` become the gebp rhs, that is packed on every invocation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_PACKED_WEIGHTS_H_
+#define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_PACKED_WEIGHTS_H_
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/host_context/shared_context.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+// Right hand side `B[KxN]` of a matrix multiplication, packed into gebp lhs
+// panels of `kc` x `mc` elements. Panels are stored contiguously, ordered by
+// the depth (K) block first and the column (N) block second.
+template <typename T>
+class PackedMatMulRhs : public ReferenceCounted<PackedMatMulRhs<T>> {
+  using Index = Eigen::Index;
+  using Traits = Eigen::internal::gebp_traits<T, T>;
+  using LhsMapper = Eigen::internal::const_blas_data_mapper<T, Index,
+                                                            Eigen::ColMajor>;
+  using LhsPacker =
+      Eigen::internal::gemm_pack_lhs<T, Index, LhsMapper, Traits::mr,
+                                     Traits::LhsProgress,
+                                     typename Traits::LhsPacket4Packing,
+                                     Eigen::ColMajor>;
+
+ public:
+  using ElementType = T;
+
+  // Packs the RowMajor `depth` x `cols` matrix `data`.
+  PackedMatMulRhs(const T* data, Index depth, Index cols)
+      : depth_(depth), cols_(cols), kc_(depth), mc_(cols) {
+    // Blocking along the activations dimension does not change the packed
+    // layout, use a typical inference batch size for the heuristic.
+    Index nc = 64;
+    Eigen::internal::computeProductBlockingSizes<T, T>(kc_, mc_, nc);
+    kc_ = std::max<Index>(kc_, 1);
+    mc_ = std::max<Index>(mc_, 1);
+
+    data_.resize(depth_ * cols_);
+    // B^T is a ColMajor `cols` x `depth` matrix with stride `cols`.
+    LhsMapper weights(data, cols_);
+    T* packed = data_.data();
+    for (Index k = 0; k < depth_; k += kc_) {
+      const Index actual_kc = std::min(kc_, depth_ - k);
+      for (Index n = 0; n < cols_; n += mc_) {
+        const Index actual_mc = std::min(mc_, cols_ - n);
+        LhsPacker()(packed, weights.getSubMapper(n, k), actual_kc, actual_mc);
+        packed += actual_kc * actual_mc;
+      }
+    }
+  }
+
+  Index depth() const { return depth_; }
+  Index cols() const { return cols_; }
+  size_t SizeInBytes() const { return data_.size() * sizeof(T); }
+
+  // Computes columns [begin, end) of the RowMajor `C = A * B`, where `A` has
+  // `m` rows and `depth()` columns, and `C` has `m` rows and `cols()`
+  // columns. `scratch` holds packed blocks of `A`.
+  void Multiply(const T* a, T* c, Index begin, Index end,
+                std::vector<T, Eigen::aligned_allocator<T>>* scratch) const {
+    using RhsMapper = Eigen::internal::const_blas_data_mapper<T, Index,
+                                                              Eigen::ColMajor>;
+    using OutputMapper =
+        Eigen::internal::blas_data_mapper<T, Index, Eigen::ColMajor>;
+    using RhsPacker = Eigen::internal::gemm_pack_rhs<T, Index, RhsMapper,
+                                                     Traits::nr,
+                                                     Eigen::ColMajor>;
+    using GebpKernel =
+        Eigen::internal::gebp_kernel<T, T, Index, OutputMapper, Traits::mr,
+                                     Traits::nr, /*ConjugateLhs=*/false,
+                                     /*ConjugateRhs=*/false>;
+
+    // A^T is a ColMajor `depth` x `m` matrix with stride `depth`, and C^T is a
+    // ColMajor `cols` x `m` matrix with stride `cols`.
+    RhsMapper activations(a, depth_);
+    OutputMapper output(c, cols_);
+
+    const Index m = end - begin;
+    std::fill(c + begin * cols_, c + end * cols_, T(0));
+    scratch->resize(std::min(kc_, depth_) * m);
+
+    const T* packed = data_.data();
+    for (Index k = 0; k < depth_; k += kc_) {
+      const Index actual_kc = std::min(kc_, depth_ - k);
+      RhsPacker()(scratch->data(), activations.getSubMapper(k, begin),
+                  actual_kc, m);
+      for (Index n = 0; n < cols_; n += mc_) {
+        const Index actual_mc = std::min(mc_, cols_ - n);
+        GebpKernel()(output.getSubMapper(n, begin), packed, scratch->data(),
+                     actual_mc, actual_kc, m, /*alpha=*/T(1));
+        packed += actual_kc * actual_mc;
+      }
+    }
+  }
+
+ private:
+  const Index depth_;
+  const Index cols_;
+  Index kc_;
+  Index mc_;
+  std::vector<T, Eigen::aligned_allocator<T>> data_;
+};
+
+// Computes the RowMajor `c = a * rhs` in parallel, and calls `done` when the
+// output is ready. `a` and `c` must stay alive until then.
+template <typename T>
+void AsyncMatMulPacked(HostContext* host, const T* a, Eigen::Index m,
+                       RCReference<PackedMatMulRhs<T>> rhs, T* c,
+                       llvm::unique_function<void()> done) {
+  // Rows of the output are independent, so each task multiplies a block of
+  // `a` rows by all the packed panels. Blocks are large enough to amortize
+  // the gebp micro kernel setup.
+  static constexpr size_t kMinBlockRows = 16;
+
+  auto* rhs_ptr = rhs.get();
+  ParallelFor(host).Execute(
+      m, ParallelFor::BlockSizes::Min(kMinBlockRows),
+      [rhs_ptr, a, c](size_t begin, size_t end) {
+        std::vector<T, Eigen::aligned_allocator<T>> scratch;
+        rhs_ptr->Multiply(a, c, begin, end, &scratch);
+      },
+      [rhs = std::move(rhs), done = std::move(done)]() mutable {
+        rhs.reset();
+        done();
+      });
+}
+
+// Cache of weights packed into `Packed`, keyed by the identity of the weights
+// HostBuffer and the packed matrix shape. `Packed` is reference counted, and is
+// constructed from the RowMajor weights matrix data, depth and columns. Cached
+// entries keep the weights buffer alive, so that a buffer address can't be
+// reused by different weights while its packed panels are cached. Weights
+// must not be modified after they were packed.
+//
+// The total size of the cached panels is bounded by kMaxCachedBytes. When it
+// is exceeded, the least recently used entries are evicted, which releases
+// their weights buffers. Evicted panels stay valid for the kernels that still
+// hold a reference to them.
+template <typename Packed>
+class PackedWeightCache : public SharedContext {
+  using Index = Eigen::Index;
+  using T = typename Packed::ElementType;
+
+ public:
+  static constexpr size_t kMaxCachedBytes = 64 << 20;
+
+  explicit PackedWeightCache(HostContext* host) {}
+
+  // Returns `weights` viewed as a RowMajor `depth` x `cols` matrix and packed,
+  // packing them on the first call for a given weights buffer.
+  RCReference<Packed> GetOrPack(const DenseHostTensor& weights, Index depth,
+                                Index cols) {
+    assert(weights.shape().GetNumElements() == depth * cols);
+    Key key{weights.buffer().get(), depth, cols};
+
+    {
+      mutex_lock lock(mu_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+        return it->second.packed.CopyRef();
+      }
+    }
+
+    // Pack without holding the lock. If two threads race to pack the same
+    // weights, the first one to finish wins and the other result is dropped.
+    auto packed =
+        TakeRef(new Packed(static_cast<const T*>(weights.data()), depth, cols));
+
+    // Weights that do not fit into the cache are packed on every call.
+    const size_t bytes = packed->SizeInBytes();
+    if (bytes > kMaxCachedBytes) return packed;
+
+    mutex_lock lock(mu_);
+    auto inserted = entries_.emplace(
+        key, Entry{weights.buffer().CopyRef(), std::move(packed), {}});
+    Entry& entry = inserted.first->second;
+    if (!inserted.second) return entry.packed.CopyRef();
+
+    entry.lru_position = lru_.insert(lru_.begin(), key);
+    cached_bytes_ += bytes;
+    auto result = entry.packed.CopyRef();
+    while (cached_bytes_ > kMaxCachedBytes) EvictLeastRecentlyUsed();
+    return result;
+  }
+
+ private:
+  using Key = std::tuple<const HostBuffer*, Index, Index>;
+
+  struct Entry {
+    RCReference<HostBuffer> weights;
+    RCReference<Packed> packed;
+    typename std::list<Key>::iterator lru_position;
+  };
+
+  void EvictLeastRecentlyUsed() TFRT_REQUIRES(mu_) {
+    assert(!lru_.empty());
+    auto it = entries_.find(lru_.back());
+    cached_bytes_ -= it->second.packed->SizeInBytes();
+    entries_.erase(it);
+    lru_.pop_back();
+  }
+
+  mutex mu_;
+  std::map<Key, Entry> entries_ TFRT_GUARDED_BY(mu_);
+  // Keys of the cached entries, most recently used first.
+  std::list<Key> lru_ TFRT_GUARDED_BY(mu_);
+  size_t cached_bytes_ TFRT_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_PACKED_WEIGHTS_H_
@@ -0,0 +1,262 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- quantized_gemm.cc ----------------------------------------*- C++ -*-===//
+//
+// Quantized matrix multiplication micro kernels and runtime dispatch.
+//
+//===----------------------------------------------------------------------===//
+
+#include "quantized_gemm.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TFRT_QUANTIZED_GEMM_X86
+#include <immintrin.h>
+#endif
+
+namespace tfrt {
+namespace compat {
+
+using Index = Eigen::Index;
+
+namespace {
+
+constexpr Index kPanelCols = PackedQuantizedWeights::kPanelCols;
+constexpr Index kGroupDepth = PackedQuantizedWeights::kGroupDepth;
+
+// Number of activation rows multiplied by every loaded weights panel group.
+constexpr Index kTileRows = 4;
+
+// Loads kGroupDepth activations starting at `k`, padding them with zeros past
+// the end of the row.
+inline int32_t LoadGroup(const uint8_t* row, Index k, Index depth) {
+  int32_t group = 0;
+  std::memcpy(&group, row + k, std::min(kGroupDepth, depth - k));
+  return group;
+}
+
+void QuantizedGemmScalar(const uint8_t* a, Index rows, Index lda,
+                         const PackedQuantizedWeights& weights, int32_t* c) {
+  const Index depth = weights.depth();
+  const Index padded_cols = weights.padded_cols();
+  const Index num_groups = weights.padded_depth() / kGroupDepth;
+
+  for (Index row = 0; row < rows; ++row) {
+    const uint8_t* a_row = a + row * lda;
+    int32_t* c_row = c + row * padded_cols;
+
+    for (Index panel = 0; panel < padded_cols; panel += kPanelCols) {
+      const int8_t* b = weights.data() + panel * weights.padded_depth();
+      int32_t acc[kPanelCols] = {};
+
+      for (Index g = 0; g < num_groups; ++g) {
+        uint8_t group[kGroupDepth];
+        const int32_t packed_group = LoadGroup(a_row, g * kGroupDepth, depth);
+        std::memcpy(group, &packed_group, sizeof(group));
+
+        for (Index col = 0; col < kPanelCols; ++col) {
+          for (Index i = 0; i < kGroupDepth; ++i) {
+            acc[col] += group[i] * b[col * kGroupDepth + i];
+          }
+        }
+        b += kPanelCols * kGroupDepth;
+      }
+      std::memcpy(c_row + panel, acc, sizeof(acc));
+    }
+  }
+}
+
+#if defined(TFRT_QUANTIZED_GEMM_X86)
+
+template <int NumRows>
+__attribute__((target("avx512f,avx512vnni"))) void QuantizedGemmTileVnni(
+    const uint8_t* a, Index lda, Index depth, const int8_t* b,
+    Index num_groups, int32_t* c, Index ldc) {
+  __m512i acc[NumRows];
+  for (int i = 0; i < NumRows; ++i) acc[i] = _mm512_setzero_si512();
+
+  for (Index g = 0; g < num_groups; ++g) {
+    const __m512i weights =
+        _mm512_loadu_si512(b + g * kPanelCols * kGroupDepth);
+    for (int i = 0; i < NumRows; ++i) {
+      const __m512i group =
+          _mm512_set1_epi32(LoadGroup(a + i * lda, g * kGroupDepth, depth));
+      acc[i] = _mm512_dpbusd_epi32(acc[i], group, weights);
+    }
+  }
+
+  for (int i = 0; i < NumRows; ++i) {
+    _mm512_storeu_si512(c + i * ldc, acc[i]);
+  }
+}
+
+__attribute__((target("avx512f,avx512vnni"))) void QuantizedGemmVnni(
+    const uint8_t* a, Index rows, Index lda,
+    const PackedQuantizedWeights& weights, int32_t* c) {
+  const Index depth = weights.depth();
+  const Index padded_cols = weights.padded_cols();
+  const Index num_groups = weights.padded_depth() / kGroupDepth;
+
+  for (Index panel = 0; panel < padded_cols; panel += kPanelCols) {
+    const int8_t* b = weights.data() + panel * weights.padded_depth();
+    Index row = 0;
+    for (; row + kTileRows <= rows; row += kTileRows) {
+      int32_t* tile = c + row * padded_cols + panel;
+      QuantizedGemmTileVnni<kTileRows>(a + row * lda, lda, depth, b,
+                                       num_groups, tile, padded_cols);
+    }
+    for (; row < rows; ++row) {
+      QuantizedGemmTileVnni<1>(a + row * lda, lda, depth, b, num_groups,
+                               c + row * padded_cols + panel, padded_cols);
+    }
+  }
+}
+
+// Computes 8 columns of a panel. Every group of 4 columns x 4 depth values is
+// widened to int16, and multiplied with the activations group broadcasted to
+// all 64-bit lanes, which yields two partial sums per column.
+template <int NumRows>
+__attribute__((target("avx2"))) void QuantizedGemmTileAvx2(
+    const uint8_t* a, Index lda, Index depth, const int8_t* b,
+    Index num_groups, int32_t* c, Index ldc) {
+  // Partial sums of columns [0, 4) and [4, 8).
+  __m256i acc_lo[NumRows];
+  __m256i acc_hi[NumRows];
+  for (int i = 0; i < NumRows; ++i) {
+    acc_lo[i] = _mm256_setzero_si256();
+    acc_hi[i] = _mm256_setzero_si256();
+  }
+
+  for (Index g = 0; g < num_groups; ++g) {
+    const int8_t* group_weights = b + g * kPanelCols * kGroupDepth;
+    const __m256i weights_lo = _mm256_cvtepi8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_weights)));
+    const __m256i weights_hi = _mm256_cvtepi8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(group_weights + 16)));
+
+    for (int i = 0; i < NumRows; ++i) {
+      const __m128i group = _mm_cvtepu8_epi16(
+          _mm_cvtsi32_si128(LoadGroup(a + i * lda, g * kGroupDepth, depth)));
+      const __m256i activations = _mm256_broadcastq_epi64(group);
+      acc_lo[i] = _mm256_add_epi32(acc_lo[i],
+                                   _mm256_madd_epi16(weights_lo, activations));
+      acc_hi[i] = _mm256_add_epi32(acc_hi[i],
+                                   _mm256_madd_epi16(weights_hi, activations));
+    }
+  }
+
+  for (int i = 0; i < NumRows; ++i) {
+    // hadd yields columns [0, 1, 4, 5 | 2, 3, 6, 7], restore the order.
+    const __m256i sums = _mm256_hadd_epi32(acc_lo[i], acc_hi[i]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + i * ldc),
+                        _mm256_permute4x64_epi64(sums, 0xD8));
+  }
+}
+
+__attribute__((target("avx2"))) void QuantizedGemmAvx2(
+    const uint8_t* a, Index rows, Index lda,
+    const PackedQuantizedWeights& weights, int32_t* c) {
+  const Index depth = weights.depth();
+  const Index padded_cols = weights.padded_cols();
+  const Index num_groups = weights.padded_depth() / kGroupDepth;
+
+  // Weights of columns [8, 16) of a panel group follow columns [0, 8).
+  constexpr Index kHalfPanel = kPanelCols / 2;
+
+  for (Index panel = 0; panel < padded_cols; panel += kPanelCols) {
+    for (Index half = 0; half < 2; ++half) {
+      const int8_t* b = weights.data() + panel * weights.padded_depth() +
+                        half * kHalfPanel * kGroupDepth;
+      const Index col = panel + half * kHalfPanel;
+      Index row = 0;
+      for (; row + kTileRows <= rows; row += kTileRows) {
+        int32_t* tile = c + row * padded_cols + col;
+        QuantizedGemmTileAvx2<kTileRows>(a + row * lda, lda, depth, b,
+                                         num_groups, tile, padded_cols);
+      }
+      for (; row < rows; ++row) {
+        QuantizedGemmTileAvx2<1>(a + row * lda, lda, depth, b, num_groups,
+                                 c + row * padded_cols + col, padded_cols);
+      }
+    }
+  }
+}
+
+#endif  // TFRT_QUANTIZED_GEMM_X86
+
+}  // namespace
+
+QuantizedGemmIsa GetQuantizedGemmIsa() {
+  static QuantizedGemmIsa isa = QuantizedGemmIsa::kScalar;
+
+  static std::once_flag initialized;
+  std::call_once(initialized, [&] {
+    char* flag = std::getenv("TFRT_DISABLE_QUANTIZED_GEMM_SIMD");
+    if (flag && (strcmp(flag, "true") == 0 || strcmp(flag, "1") == 0)) {
+      return;
+    }
+#if defined(TFRT_QUANTIZED_GEMM_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512vnni")) {
+      isa = QuantizedGemmIsa::kAvx512Vnni;
+    } else if (__builtin_cpu_supports("avx2")) {
+      isa = QuantizedGemmIsa::kAvx2;
+    }
+#endif
+  });
+  return isa;
+}
+
+PackedQuantizedWeights::PackedQuantizedWeights(const int8_t* weights,
+                                               Index depth, Index cols)
+    : depth_(depth),
+      cols_(cols),
+      padded_depth_(Eigen::divup(depth, kGroupDepth) * kGroupDepth),
+      padded_cols_(Eigen::divup(cols, kPanelCols) * kPanelCols),
+      data_(padded_depth_ * padded_cols_, 0),
+      column_sums_(cols, 0) {
+  for (Index k = 0; k < depth; ++k) {
+    for (Index n = 0; n < cols; ++n) {
+      const int8_t value = weights[k * cols + n];
+      const Index panel = n / kPanelCols;
+      const Index group = k / kGroupDepth;
+      const Index offset = panel * kPanelCols * padded_depth_ +
+                           group * kPanelCols * kGroupDepth +
+                           (n % kPanelCols) * kGroupDepth + k % kGroupDepth;
+      data_[offset] = value;
+      column_sums_[n] += value;
+    }
+  }
+}
+
+void QuantizedGemm(const uint8_t* a, Index rows, Index lda,
+                   const PackedQuantizedWeights& weights, int32_t* c) {
+  switch (GetQuantizedGemmIsa()) {
+#if defined(TFRT_QUANTIZED_GEMM_X86)
+    case QuantizedGemmIsa::kAvx512Vnni:
+      return QuantizedGemmVnni(a, rows, lda, weights, c);
+    case QuantizedGemmIsa::kAvx2:
+      return QuantizedGemmAvx2(a, rows, lda, weights, c);
+#endif
+    default:
+      return QuantizedGemmScalar(a, rows, lda, weights, c);
+  }
+}
+
+}  // namespace compat
+}  // namespace tfrt
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- quantized_gemm.h -----------------------------------------*- C++ -*-===//
+//
+// Quantized matrix multiplication of uint8 activations with int8 weights and
+// int32 accumulation, that is used by the quantized matmul and conv2d kernels.
+//
+// Eigen does not have packing and gebp kernels for mixed uint8/int8 operands,
+// so the weights are packed into a layout that matches the dot product
+// instructions of the target CPU, and the micro kernel is selected at runtime:
+//
+// 1) AVX512-VNNI: vpdpbusd multiplies 4 uint8 activations with 4 int8 weights
+//    and accumulates the sum into an int32 lane.
+// 2) AVX2: weights and activations are widened to int16 and multiplied with
+//    vpmaddwd. Unlike vpmaddubsw, this can't saturate intermediate results.
+// 3) Scalar fallback for all other CPUs.
+//
+// All micro kernels produce bit identical results.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_QUANTIZED_GEMM_H_
+#define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_QUANTIZED_GEMM_H_
+
+#define EIGEN_USE_THREADS
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "contraction_output_kernel.h"
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/ref_count.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+enum class QuantizedGemmIsa { kScalar, kAvx2, kAvx512Vnni };
+
+// Returns the micro kernel instruction set selected for the current CPU. Can
+// be forced to the scalar fallback by setting the environment variable
+// TFRT_DISABLE_QUANTIZED_GEMM_SIMD=true.
+QuantizedGemmIsa GetQuantizedGemmIsa();
+
+// Weights matrix `B[KxN]` packed into panels of kPanelCols columns. Every
+// panel stores groups of kGroupDepth consecutive values along K for each of
+// its columns: [K / kGroupDepth][kPanelCols][kGroupDepth]. K and N are padded
+// with zeros to the multiples of the group depth and the panel size.
+class PackedQuantizedWeights
+    : public ReferenceCounted<PackedQuantizedWeights> {
+ public:
+  using Index = Eigen::Index;
+  using ElementType = int8_t;
+
+  static constexpr Index kPanelCols = 16;
+  static constexpr Index kGroupDepth = 4;
+
+  // Packs the RowMajor `depth` x `cols` matrix `weights`.
+  PackedQuantizedWeights(const int8_t* weights, Index depth, Index cols);
+
+  Index depth() const { return depth_; }
+  Index cols() const { return cols_; }
+  Index padded_depth() const { return padded_depth_; }
+  Index padded_cols() const { return padded_cols_; }
+
+  const int8_t* data() const { return data_.data(); }
+  size_t SizeInBytes() const {
+    return data_.size() + column_sums_.size() * sizeof(int32_t);
+  }
+
+  // Sums of the weights in every column, used to subtract the activations
+  // zero point contribution from the accumulators.
+  const std::vector<int32_t>& column_sums() const { return column_sums_; }
+
+ private:
+  Index depth_;
+  Index cols_;
+  Index padded_depth_;
+  Index padded_cols_;
+  std::vector<int8_t> data_;
+  std::vector<int32_t> column_sums_;
+};
+
+// Computes the int32 `C = A * B`, where `A` is a RowMajor `rows` x
+// `weights.depth()` uint8 matrix with row stride `lda`, and `C` is a RowMajor
+// `rows` x `weights.padded_cols()` matrix.
+void QuantizedGemm(const uint8_t* a, Eigen::Index rows, Eigen::Index lda,
+                   const PackedQuantizedWeights& weights, int32_t* c);
+
+// Requantizes int32 accumulators computed by QuantizedGemm into uint8 outputs:
+//
+//   real = (acc - input_zero_point * column_sum + bias) * scale
+//   out  = clamp(round(Activation(real)) + output_zero_point, 0, 255)
+//
+// where `scale` is the per output channel requantization multiplier, i.e.
+// input_scale * weights_scale / output_scale. Optionally applies the
+// activation function specified by `Activation` type parameter.
+template <typename Activation = Identity>
+class RequantizeOutputKernel {
+  using Index = Eigen::Index;
+  using IntVec = Eigen::Tensor<int32_t, 1, Eigen::RowMajor, Index>;
+  using FloatVec = Eigen::Tensor<float, 1, Eigen::RowMajor, Index>;
+  using ByteVec = Eigen::Tensor<uint8_t, 1, Eigen::RowMajor, Index>;
+
+ public:
+  RequantizeOutputKernel(const EigenConstTensor<int32_t, 1>& bias,
+                         const EigenConstTensor<float, 1>& scale,
+                         const std::vector<int32_t>& column_sums,
+                         int32_t input_zero_point, int32_t output_zero_point)
+      : scale_data_(scale.data()),
+        offset_(bias.size()),
+        output_zero_point_(static_cast<float>(output_zero_point)) {
+    for (Index i = 0; i < bias.size(); ++i) {
+      offset_[i] = bias.data()[i] - input_zero_point * column_sums[i];
+    }
+  }
+
+  // Requantizes `num_rows` rows of `num_cols` accumulators with row stride
+  // `acc_stride` into `output` with row stride `output_stride`.
+  void operator()(const int32_t* acc, Index acc_stride, Index num_rows,
+                  Index num_cols, uint8_t* output, Index output_stride) const {
+    using Acc = Eigen::TensorMap<const IntVec, Eigen::Unaligned>;
+    using Offset = Eigen::TensorMap<const IntVec, Eigen::Unaligned>;
+    using Scale = Eigen::TensorMap<const FloatVec, Eigen::Unaligned>;
+    using Output = Eigen::TensorMap<ByteVec, Eigen::Unaligned>;
+
+    assert(num_cols <= static_cast<Index>(offset_.size()) &&
+           "Output inner dimension is larger than the bias vector");
+
+    const Offset offset(offset_.data(), num_cols);
+    const Scale scale(scale_data_, num_cols);
+
+    for (Index row = 0; row < num_rows; ++row) {
+      const Acc accumulators(acc + row * acc_stride, num_cols);
+      Output out(output + row * output_stride, num_cols);
+
+      const auto real = (accumulators + offset).template cast<float>() * scale;
+      const auto activated = Activation::template apply<decltype(real)>(real);
+      out = (activated.round() + output_zero_point_)
+                .cwiseMax(0.0f)
+                .cwiseMin(255.0f)
+                .template cast<uint8_t>();
+    }
+  }
+
+ private:
+  const float* scale_data_;
+  // Precomputed: bias - input_zero_point * column_sums.
+  std::vector<int32_t> offset_;
+  float output_zero_point_;
+};
+
+// Computes the uint8 `output = output_kernel(A * weights)` in parallel, and
+// calls `done` when the output is ready. `output` is a RowMajor `rows` x
+// `weights->cols()` matrix.
+//
+// Rows of `A` are produced by `load_rows(begin, end, scratch)`, which returns
+// rows [begin, end) of `A` with row stride `lda`. It can return a pointer into
+// the original activations, or materialize the rows in `scratch` (e.g. image
+// patches for convolutions). All arguments must stay alive until `done`.
+template <typename OutputKernel, typename LoadRows>
+void AsyncQuantizedGemm(HostContext* host, Eigen::Index rows, Eigen::Index lda,
+                        LoadRows load_rows,
+                        RCReference<PackedQuantizedWeights> weights,
+                        std::unique_ptr<OutputKernel> output_kernel,
+                        uint8_t* output, llvm::unique_function<void()> done) {
+  // Each task computes a block of rows that is large enough to amortize the
+  // micro kernel setup, and keeps the int32 accumulators in a scratch buffer.
+  static constexpr size_t kMinBlockRows = 16;
+
+  auto* weights_ptr = weights.get();
+  auto* output_kernel_ptr = output_kernel.get();
+  ParallelFor(host).Execute(
+      rows, ParallelFor::BlockSizes::Min(kMinBlockRows),
+      [weights_ptr, output_kernel_ptr, lda, load_rows = std::move(load_rows),
+       output](size_t begin, size_t end) {
+        const Eigen::Index num_rows = end - begin;
+        std::vector<uint8_t> scratch;
+        const uint8_t* a = load_rows(begin, end, &scratch);
+
+        std::vector<int32_t> acc(num_rows * weights_ptr->padded_cols());
+        QuantizedGemm(a, num_rows, lda, *weights_ptr, acc.data());
+
+        const Eigen::Index cols = weights_ptr->cols();
+        (*output_kernel_ptr)(acc.data(), weights_ptr->padded_cols(), num_rows,
+                             cols, output + begin * cols, cols);
+      },
+      [weights = std::move(weights), output_kernel = std::move(output_kernel),
+       done = std::move(done)]() mutable {
+        weights.reset();
+        output_kernel.reset();
+        done();
+      });
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_QUANTIZED_GEMM_H_
@@ -0,0 +1,131 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- thread_pool_device.cc ------------------------------------*- C++ -*-===//
+//
+// Eigen::Allocator implementation that wraps HostContext.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/common/compat/eigen/thread_pool_device.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+#include "tfrt/host_context/host_context.h"
+
+namespace tfrt {
+namespace compat {
+
+namespace {
+
+// Buffers are aligned for Eigen packet loads, and prefixed with a header that
+// stores the buffer size, because Eigen::Allocator::deallocate does not pass
+// it and HostContext::DeallocateBytes requires it.
+constexpr size_t kAlignment =
+    std::max<size_t>(EIGEN_MAX_ALIGN_BYTES, alignof(std::max_align_t));
+constexpr size_t kHeaderSize = kAlignment;
+
+// Larger buffers are always returned to the HostContext allocator.
+constexpr size_t kMaxCachedBufferSize = 8 * 1024 * 1024;
+
+size_t& BufferSize(void* buffer) {
+  return *reinterpret_cast<size_t*>(static_cast<char*>(buffer) - kHeaderSize);
+}
+
+}  // namespace
+
+constexpr size_t EigenHostContext::kMaxAllocatorCachedBytes;
+
+EigenHostContext::EigenHostContextAllocator::~EigenHostContextAllocator() {
+  for (Cache& cache : caches_) {
+    mutex_lock lock(cache.mu);
+    for (void* buffer : cache.buffers) {
+      host_context_->DeallocateBytes(static_cast<char*>(buffer) - kHeaderSize,
+                                     BufferSize(buffer) + kHeaderSize);
+    }
+    cache.buffers.clear();
+  }
+}
+
+EigenHostContext::EigenHostContextAllocator::Cache&
+EigenHostContext::EigenHostContextAllocator::GetThreadCache() const {
+  const int worker_id = host_context_->GetCurrentWorkerThreadId();
+  if (worker_id >= 0) return caches_[worker_id % kNumCaches];
+
+  const size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return caches_[hash % kNumCaches];
+}
+
+bool EigenHostContext::EigenHostContextAllocator::ReserveCachedBytes(
+    size_t num_bytes) const {
+  size_t cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+  do {
+    if (cached_bytes + num_bytes > kMaxAllocatorCachedBytes) return false;
+  } while (!cached_bytes_.compare_exchange_weak(cached_bytes,
+                                                cached_bytes + num_bytes,
+                                                std::memory_order_relaxed));
+  return true;
+}
+
+void* EigenHostContext::EigenHostContextAllocator::allocate(
+    size_t num_bytes) const {
+  // Reuse a cached buffer that is large enough, but not much larger than the
+  // requested size.
+  if (num_bytes <= kMaxCachedBufferSize) {
+    Cache& cache = GetThreadCache();
+    mutex_lock lock(cache.mu);
+    auto it = std::find_if(
+        cache.buffers.begin(), cache.buffers.end(), [&](void* buffer) {
+          const size_t size = BufferSize(buffer);
+          return size >= num_bytes && size <= 2 * num_bytes;
+        });
+    if (it != cache.buffers.end()) {
+      void* buffer = *it;
+      cache.buffers.erase(it);
+      cached_bytes_.fetch_sub(BufferSize(buffer), std::memory_order_relaxed);
+      return buffer;
+    }
+  }
+
+  char* ptr = static_cast<char*>(
+      host_context_->AllocateBytes(num_bytes + kHeaderSize, kAlignment));
+  void* buffer = ptr + kHeaderSize;
+  BufferSize(buffer) = num_bytes;
+  return buffer;
+}
+
+void EigenHostContext::EigenHostContextAllocator::deallocate(
+    void* buffer) const {
+  if (buffer == nullptr) return;
+
+  const size_t num_bytes = BufferSize(buffer);
+  if (num_bytes <= kMaxCachedBufferSize) {
+    Cache& cache = GetThreadCache();
+    mutex_lock lock(cache.mu);
+    if (cache.buffers.size() < kMaxCachedBuffers &&
+        ReserveCachedBytes(num_bytes)) {
+      cache.buffers.push_back(buffer);
+      return;
+    }
+  }
+
+  host_context_->DeallocateBytes(static_cast<char*>(buffer) - kHeaderSize,
+                                 num_bytes + kHeaderSize);
+}
+
+}  // namespace compat
+}  // namespace tfrt
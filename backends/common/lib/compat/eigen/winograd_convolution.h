@@ -0,0 +1,357 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- winograd_convolution.h -----------------------------------*- C++ -*-===//
+//
+// Winograd F(2x2, 3x3) convolution for 3x3 filters with unit strides and
+// dilations (see "Fast Algorithms for Convolutional Neural Networks", Lavin
+// and Gray, 2015).
+//
+// Every 2x2 output tile is computed from a 4x4 input tile as:
+//
+//   Y = A^T [(G g G^T) * (B^T d B)] A
+//
+// where `*` is an element-wise product. Element-wise products of all tiles
+// and channels are batched into 16 independent matrix multiplications
+// `[num_tiles, in_channels] x [in_channels, out_channels]`, which needs 2.25x
+// fewer multiplications than the direct convolution.
+//
+// F(4x4, 3x3) would save more multiplications, but its transforms amplify the
+// float rounding error by more than an order of magnitude, so it's not used.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_WINOGRAD_CONVOLUTION_H_
+#define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_WINOGRAD_CONVOLUTION_H_
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "contraction_output_kernel.h"
+#include "llvm/ADT/FunctionExtras.h"
+#include "packed_weights.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace compat {
+
+namespace internal {
+
+// Number of elements in the transformed 4x4 tiles.
+constexpr Eigen::Index kWinogradTileSize = 16;
+
+// Transforms process channels in chunks that are copied to local arrays, so
+// that the compiler can vectorize the transforms along the channels without
+// worrying about aliasing between the inputs and the outputs.
+constexpr Eigen::Index kWinogradChannelChunk = 16;
+
+// Transforms the HWIO 3x3 `filter` into 16 RowMajor matrices
+// `[in_channels, out_channels]`: U = G g G^T, where
+//
+//   G = | 1    0    0   |
+//       | 1/2  1/2  1/2 |
+//       | 1/2 -1/2  1/2 |
+//       | 0    0    1   |
+inline void WinogradFilterTransform(const float* filter, Eigen::Index ic,
+                                    Eigen::Index oc, float* transformed) {
+  constexpr Eigen::Index kChunk = kWinogradChannelChunk;
+  const Eigen::Index stride = ic * oc;
+
+  for (Eigen::Index c0 = 0; c0 < stride; c0 += kChunk) {
+    const Eigen::Index n = std::min(kChunk, stride - c0);
+
+    float g[3][3][kChunk] = {};
+    for (int h = 0; h < 3; ++h) {
+      for (int w = 0; w < 3; ++w) {
+        std::copy_n(filter + (h * 3 + w) * stride + c0, n, g[h][w]);
+      }
+    }
+
+    // Gg: 4x3.
+    float t[4][3][kChunk];
+    for (int w = 0; w < 3; ++w) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        t[0][w][c] = g[0][w][c];
+        t[1][w][c] = 0.5f * (g[0][w][c] + g[1][w][c] + g[2][w][c]);
+        t[2][w][c] = 0.5f * (g[0][w][c] - g[1][w][c] + g[2][w][c]);
+        t[3][w][c] = g[2][w][c];
+      }
+    }
+
+    // (Gg)G^T: 4x4.
+    float u[4][4][kChunk];
+    for (int h = 0; h < 4; ++h) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        u[h][0][c] = t[h][0][c];
+        u[h][1][c] = 0.5f * (t[h][0][c] + t[h][1][c] + t[h][2][c]);
+        u[h][2][c] = 0.5f * (t[h][0][c] - t[h][1][c] + t[h][2][c]);
+        u[h][3][c] = t[h][2][c];
+      }
+    }
+
+    for (int h = 0; h < 4; ++h) {
+      for (int w = 0; w < 4; ++w) {
+        std::copy_n(u[h][w], n, transformed + (h * 4 + w) * stride + c0);
+      }
+    }
+  }
+}
+
+// Transforms a 4x4 input tile: V = B^T d B, where
+//
+//   B^T = | 1  0 -1  0 |
+//         | 0  1  1  0 |
+//         | 0 -1  1  0 |
+//         | 0  1  0 -1 |
+//
+// `d[h][w]` points to the `ic` input channels of the tile pixel (h, w).
+// Results are written with the stride `transformed_stride` between the 16
+// tile elements.
+inline void WinogradInputTransform(const float* const (&d)[4][4],
+                                   Eigen::Index ic, float* transformed,
+                                   Eigen::Index transformed_stride) {
+  constexpr Eigen::Index kChunk = kWinogradChannelChunk;
+
+  for (Eigen::Index c0 = 0; c0 < ic; c0 += kChunk) {
+    const Eigen::Index n = std::min(kChunk, ic - c0);
+
+    float x[4][4][kChunk] = {};
+    for (int h = 0; h < 4; ++h) {
+      for (int w = 0; w < 4; ++w) std::copy_n(d[h][w] + c0, n, x[h][w]);
+    }
+
+    // B^T d: 4x4.
+    float t[4][4][kChunk];
+    for (int w = 0; w < 4; ++w) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        t[0][w][c] = x[0][w][c] - x[2][w][c];
+        t[1][w][c] = x[1][w][c] + x[2][w][c];
+        t[2][w][c] = x[2][w][c] - x[1][w][c];
+        t[3][w][c] = x[1][w][c] - x[3][w][c];
+      }
+    }
+
+    // (B^T d)B: 4x4.
+    float v[4][4][kChunk];
+    for (int h = 0; h < 4; ++h) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        v[h][0][c] = t[h][0][c] - t[h][2][c];
+        v[h][1][c] = t[h][1][c] + t[h][2][c];
+        v[h][2][c] = t[h][2][c] - t[h][1][c];
+        v[h][3][c] = t[h][1][c] - t[h][3][c];
+      }
+    }
+
+    for (int h = 0; h < 4; ++h) {
+      for (int w = 0; w < 4; ++w) {
+        std::copy_n(v[h][w], n,
+                    transformed + (h * 4 + w) * transformed_stride + c0);
+      }
+    }
+  }
+}
+
+// Transforms the 4x4 element-wise products back into a 2x2 output tile:
+// Y = A^T m A, where
+//
+//   A^T = | 1  1  1  0 |
+//         | 0  1 -1 -1 |
+//
+// `out[h][w]` points to the `oc` output channels of the output pixel (h, w).
+inline void WinogradOutputTransform(const float* m,
+                                    Eigen::Index transformed_stride,
+                                    Eigen::Index oc,
+                                    float* const (&out)[2][2]) {
+  constexpr Eigen::Index kChunk = kWinogradChannelChunk;
+
+  for (Eigen::Index c0 = 0; c0 < oc; c0 += kChunk) {
+    const Eigen::Index n = std::min(kChunk, oc - c0);
+
+    float x[4][4][kChunk] = {};
+    for (int h = 0; h < 4; ++h) {
+      for (int w = 0; w < 4; ++w) {
+        std::copy_n(m + (h * 4 + w) * transformed_stride + c0, n, x[h][w]);
+      }
+    }
+
+    // A^T m: 2x4.
+    float t[2][4][kChunk];
+    for (int w = 0; w < 4; ++w) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        t[0][w][c] = x[0][w][c] + x[1][w][c] + x[2][w][c];
+        t[1][w][c] = x[1][w][c] - x[2][w][c] - x[3][w][c];
+      }
+    }
+
+    // (A^T m)A: 2x2.
+    float y[2][2][kChunk];
+    for (int h = 0; h < 2; ++h) {
+      for (Eigen::Index c = 0; c < kChunk; ++c) {
+        y[h][0][c] = t[h][0][c] + t[h][1][c] + t[h][2][c];
+        y[h][1][c] = t[h][1][c] - t[h][2][c] - t[h][3][c];
+      }
+    }
+
+    for (int h = 0; h < 2; ++h) {
+      for (int w = 0; w < 2; ++w) std::copy_n(y[h][w], n, out[h][w] + c0);
+    }
+  }
+}
+
+}  // namespace internal
+
+// Computes the NHWC `output` of a 3x3 convolution of the NHWC `input` with the
+// HWIO `filter` with unit strides and dilations, and calls `done` when the
+// output is ready. `paddings` are {top, bottom, left, right}. Output kernel is
+// called for every output row segment after it was computed, in the same way
+// as it's called by the Eigen contraction of a spatial convolution. All
+// buffers must stay alive until `done`.
+template <typename OutputKernel>
+void AsyncWinogradConv2D(HostContext* host, const float* input,
+                         std::array<Eigen::Index, 4> input_shape,
+                         const float* filter, Eigen::Index out_channels,
+                         std::array<Eigen::Index, 4> paddings, float* output,
+                         std::array<Eigen::Index, 4> output_shape,
+                         std::unique_ptr<OutputKernel> output_kernel,
+                         llvm::unique_function<void()> done) {
+  using Index = Eigen::Index;
+  using PackedFilter = std::vector<RCReference<PackedMatMulRhs<float>>>;
+  using internal::kWinogradTileSize;
+
+  // Number of tiles transformed together by a task. Transformed inputs and
+  // outputs of a block of tiles should fit into the L2 cache.
+  static constexpr Index kTilesPerBlock = 32;
+
+  const Index ic = input_shape[3];
+  const Index oc = out_channels;
+
+  // Transformed filter matrices are packed once, and shared by all tasks.
+  auto packed_filter = std::make_unique<PackedFilter>();
+  {
+    std::vector<float> transformed(kWinogradTileSize * ic * oc);
+    internal::WinogradFilterTransform(filter, ic, oc, transformed.data());
+    for (Index k = 0; k < kWinogradTileSize; ++k) {
+      const float* matrix = transformed.data() + k * ic * oc;
+      packed_filter->push_back(
+          TakeRef(new PackedMatMulRhs<float>(matrix, ic, oc)));
+    }
+  }
+
+  const Index tiles_h = Eigen::divup(output_shape[1], Index{2});
+  const Index tiles_w = Eigen::divup(output_shape[2], Index{2});
+  const Index num_tiles = output_shape[0] * tiles_h * tiles_w;
+
+  auto compute = [=, packed_filter = packed_filter.get(),
+                  output_kernel = output_kernel.get()](size_t begin,
+                                                       size_t end) {
+    // Zeros for the input pixels in the padding area.
+    std::vector<float> zeros(ic, 0.0f);
+    // Transformed inputs and element-wise products of a block of tiles.
+    std::vector<float> v(kWinogradTileSize * kTilesPerBlock * ic);
+    std::vector<float> m(kWinogradTileSize * kTilesPerBlock * oc);
+    // Output pixels outside of the output bounds.
+    std::vector<float> discarded(oc);
+    // Packed blocks of the transformed inputs.
+    std::vector<float, Eigen::aligned_allocator<float>> scratch;
+
+    const Eigen::TensorContractionParams params{/*swapped_arguments=*/true};
+
+    for (Index block = begin; block < end; block += kTilesPerBlock) {
+      const Index block_size = std::min<Index>(kTilesPerBlock, end - block);
+
+      // Transform input tiles.
+      for (Index t = 0; t < block_size; ++t) {
+        const Index tile = block + t;
+        const Index batch = tile / (tiles_h * tiles_w);
+        const Index y = 2 * ((tile / tiles_w) % tiles_h) - paddings[0];
+        const Index x = 2 * (tile % tiles_w) - paddings[2];
+
+        const float* d[4][4];
+        for (int h = 0; h < 4; ++h) {
+          for (int w = 0; w < 4; ++w) {
+            const bool inside = y + h >= 0 && y + h < input_shape[1] &&
+                                x + w >= 0 && x + w < input_shape[2];
+            d[h][w] = inside ? input + ((batch * input_shape[1] + y + h) *
+                                            input_shape[2] +
+                                        x + w) *
+                                           ic
+                             : zeros.data();
+          }
+        }
+        internal::WinogradInputTransform(d, ic, v.data() + t * ic,
+                                         kTilesPerBlock * ic);
+      }
+
+      // Element-wise products of all tiles and channels as 16 matrix
+      // multiplications.
+      for (Index k = 0; k < kWinogradTileSize; ++k) {
+        (*packed_filter)[k]->Multiply(v.data() + k * kTilesPerBlock * ic,
+                                      m.data() + k * kTilesPerBlock * oc, 0,
+                                      block_size, &scratch);
+      }
+
+      // Transform output tiles and apply the output kernel.
+      for (Index t = 0; t < block_size; ++t) {
+        const Index tile = block + t;
+        const Index batch = tile / (tiles_h * tiles_w);
+        const Index y = 2 * ((tile / tiles_w) % tiles_h);
+        const Index x = 2 * (tile % tiles_w);
+        const Index valid_w = std::min<Index>(2, output_shape[2] - x);
+
+        float* out[2][2];
+        for (int h = 0; h < 2; ++h) {
+          for (int w = 0; w < 2; ++w) {
+            const bool inside = y + h < output_shape[1] && w < valid_w;
+            out[h][w] = inside ? output + ((batch * output_shape[1] + y + h) *
+                                               output_shape[2] +
+                                           x + w) *
+                                              oc
+                               : discarded.data();
+          }
+        }
+        internal::WinogradOutputTransform(m.data() + t * oc,
+                                          kTilesPerBlock * oc, oc, out);
+
+        for (int h = 0; h < 2 && y + h < output_shape[1]; ++h) {
+          internal::ContractionOutputMapper<float> mapper(out[h][0], oc);
+          (*output_kernel)(mapper, params, Index{0}, Index{0}, oc, valid_w);
+        }
+      }
+    }
+  };
+
+  ParallelFor(host).Execute(
+      num_tiles, ParallelFor::BlockSizes::Min(kTilesPerBlock),
+      std::move(compute),
+      [packed_filter = std::move(packed_filter),
+       output_kernel = std::move(output_kernel),
+       done = std::move(done)]() mutable {
+        packed_filter.reset();
+        output_kernel.reset();
+        done();
+      });
+}
+
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_WINOGRAD_CONVOLUTION_H_
@@ -378,10 +378,16 @@ static Expected<TensorMetadata> TfTransposeOpMdImpl(const TensorMetadata& input,
 }
 
 static Expected<TensorMetadata> TfTransposeOpMd(const TensorMetadata& input,
-                                                const TensorMetadata& /*perm*/,
+                                                const TensorMetadata& perm,
                                                 const OpAttrsRef& attrs) {
-  static constexpr ssize_t default_perm[] = {0, 3, 1, 2};
-  return TfTransposeOpMdImpl(input, default_perm, attrs);
+  const ssize_t rank = ArrayRef<ssize_t>(kTfTransposeOperandPerm).size();
+  if (input.shape.GetRank() != rank || perm.shape.GetRank() != 1 ||
+      perm.shape.GetDimensionSize(0) != rank) {
+    return MakeStringError(
+        "tf.Transpose with a `perm` operand only supports the NHWC to NCHW "
+        "permutation, use a `perm` attribute for other permutations");
+  }
+  return TfTransposeOpMdImpl(input, kTfTransposeOperandPerm, attrs);
 }
 
 static Expected<TensorMetadata> TfTransposeOpFoldedMd(
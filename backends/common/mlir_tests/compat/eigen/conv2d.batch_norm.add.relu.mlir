@@ -0,0 +1,183 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Expected outputs are computed in double precision. A quarter of the shortcut
+// values are negative enough for Relu to clamp the sum to zero, so adding the
+// shortcut at the wrong output position changes the result. The 1x1 filter
+// selects the pointwise contraction, and the 3x3 filter with 64 channels
+// selects the Winograd convolution.
+
+// RUN: tfrt_translate --mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=always
+// RUN: tfrt_translate --mlir-to-bef %s | bef_executor --work_queue_type=mstd:4 | FileCheck %s --dump-input=always
+
+// CHECK-LABEL: --- Running 'test_conv2d_batch_norm_add_relu_in_1x9x9x8_f_1x1_c16_padding_valid'
+func @test_conv2d_batch_norm_add_relu_in_1x9x9x8_f_1x1_c16_padding_valid() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_batch_norm_add_relu_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 0
+  %filter_index   = hex.constant.i32 1
+  %scale_index    = hex.constant.i32 2
+  %offset_index   = hex.constant.i32 3
+  %mean_index     = hex.constant.i32 4
+  %var_index      = hex.constant.i32 5
+  %shortcut_index = hex.constant.i32 6
+  %expected_index = hex.constant.i32 7
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %offset = "btf.read_dense_tensor.f32.1"(%path, %offset_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %mean = "btf.read_dense_tensor.f32.1"(%path, %mean_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %var = "btf.read_dense_tensor.f32.1"(%path, %var_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %shortcut = "btf.read_dense_tensor.f32.4"(%path, %shortcut_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 9 : i64, 9 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.batch_norm.add.relu.f32"(%input, %filter, %scale,
+                                                %offset, %mean, %var,
+                                                %shortcut, %output, %ch0)
+    { epsilon = 0.01 : f32, padding = "valid",
+      strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_batch_norm_add_relu_in_1x33x31x64_f_3x3_c64_padding_same'
+func @test_conv2d_batch_norm_add_relu_in_1x33x31x64_f_3x3_c64_padding_same() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_batch_norm_add_relu_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 8
+  %filter_index   = hex.constant.i32 9
+  %scale_index    = hex.constant.i32 10
+  %offset_index   = hex.constant.i32 11
+  %mean_index     = hex.constant.i32 12
+  %var_index      = hex.constant.i32 13
+  %shortcut_index = hex.constant.i32 14
+  %expected_index = hex.constant.i32 15
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %offset = "btf.read_dense_tensor.f32.1"(%path, %offset_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %mean = "btf.read_dense_tensor.f32.1"(%path, %mean_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %var = "btf.read_dense_tensor.f32.1"(%path, %var_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %shortcut = "btf.read_dense_tensor.f32.4"(%path, %shortcut_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 33 : i64, 31 : i64, 64 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.batch_norm.add.relu.f32"(%input, %filter, %scale,
+                                                %offset, %mean, %var,
+                                                %shortcut, %output, %ch0)
+    { epsilon = 0.001 : f32, padding = "same",
+      strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_batch_norm_add_relu_shortcut_alias_error'
+func @test_conv2d_batch_norm_add_relu_shortcut_alias_error() {
+  %ch0 = hex.new.chain
+
+  %input = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 4 : i64, 4 : i64, 8 : i64] }
+    : () -> !t.tensor
+  %filter = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 8 : i64, 16 : i64] }
+    : () -> !t.tensor
+  %scale = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+  %offset = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+  %mean = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+  %var = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 4 : i64, 4 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  // expected-error @+1 {{shortcut must not alias output}}
+  "eigen.conv2d.batch_norm.add.relu.f32"(%input, %filter, %scale, %offset,
+                                         %mean, %var, %output, %output, %ch0)
+    { epsilon = 0.01 : f32, padding = "valid",
+      strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  hex.return
+}
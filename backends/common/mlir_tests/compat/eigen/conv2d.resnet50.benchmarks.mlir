@@ -0,0 +1,485 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=fail
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_conv1_in_8x224x224x3_f_7x7x64'
+func @BM_Conv2D_conv1_in_8x224x224x3_f_7x7x64() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 224, 224, 3].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 224 : i64, 224 : i64, 3 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [7, 7, 3, 64].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [7 : i64, 7 : i64, 3 : i64, 64 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [64].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [64 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 112, 112, 64].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 112 : i64, 112 : i64, 64 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_conv1_in_8x224x224x3_f_7x7x64"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "same",  strides = [2 : i64, 2 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res2_1x1_reduce_in_8x56x56x256_f_1x1x64'
+func @BM_Conv2D_res2_1x1_reduce_in_8x56x56x256_f_1x1x64() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 56, 56, 256].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 256 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [1, 1, 256, 64].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 256 : i64, 64 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [64].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [64 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 56, 56, 64].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 64 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res2_1x1_reduce_in_8x56x56x256_f_1x1x64"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "valid",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res2_3x3_in_8x56x56x64_f_3x3x64'
+func @BM_Conv2D_res2_3x3_in_8x56x56x64_f_3x3x64() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 56, 56, 64].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 64 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [3, 3, 64, 64].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [3 : i64, 3 : i64, 64 : i64, 64 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [64].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [64 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 56, 56, 64].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 64 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res2_3x3_in_8x56x56x64_f_3x3x64"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "same",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res2_1x1_expand_in_8x56x56x64_f_1x1x256'
+func @BM_Conv2D_res2_1x1_expand_in_8x56x56x64_f_1x1x256() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 56, 56, 64].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 64 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [1, 1, 64, 256].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 64 : i64, 256 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [256].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [256 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 56, 56, 256].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 56 : i64, 56 : i64, 256 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res2_1x1_expand_in_8x56x56x64_f_1x1x256"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "valid",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res3_3x3_in_8x28x28x128_f_3x3x128'
+func @BM_Conv2D_res3_3x3_in_8x28x28x128_f_3x3x128() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 28, 28, 128].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 28 : i64, 28 : i64, 128 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [3, 3, 128, 128].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [3 : i64, 3 : i64, 128 : i64, 128 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [128].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [128 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 28, 28, 128].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 28 : i64, 28 : i64, 128 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res3_3x3_in_8x28x28x128_f_3x3x128"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "same",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res3_1x1_expand_in_8x28x28x128_f_1x1x512'
+func @BM_Conv2D_res3_1x1_expand_in_8x28x28x128_f_1x1x512() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 28, 28, 128].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 28 : i64, 28 : i64, 128 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [1, 1, 128, 512].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 128 : i64, 512 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [512].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [512 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 28, 28, 512].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 28 : i64, 28 : i64, 512 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res3_1x1_expand_in_8x28x28x128_f_1x1x512"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "valid",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res4_3x3_in_8x14x14x256_f_3x3x256'
+func @BM_Conv2D_res4_3x3_in_8x14x14x256_f_3x3x256() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 14, 14, 256].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 14 : i64, 14 : i64, 256 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [3, 3, 256, 256].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [3 : i64, 3 : i64, 256 : i64, 256 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [256].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [256 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 14, 14, 256].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 14 : i64, 14 : i64, 256 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res4_3x3_in_8x14x14x256_f_3x3x256"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "same",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res4_1x1_expand_in_8x14x14x256_f_1x1x1024'
+func @BM_Conv2D_res4_1x1_expand_in_8x14x14x256_f_1x1x1024() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 14, 14, 256].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 14 : i64, 14 : i64, 256 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [1, 1, 256, 1024].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 256 : i64, 1024 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [1024].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [1024 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 14, 14, 1024].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 14 : i64, 14 : i64, 1024 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res4_1x1_expand_in_8x14x14x256_f_1x1x1024"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "valid",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res5_3x3_in_8x7x7x512_f_3x3x512'
+func @BM_Conv2D_res5_3x3_in_8x7x7x512_f_3x3x512() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 7, 7, 512].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 7 : i64, 7 : i64, 512 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [3, 3, 512, 512].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [3 : i64, 3 : i64, 512 : i64, 512 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [512].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [512 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 7, 7, 512].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 7 : i64, 7 : i64, 512 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res5_3x3_in_8x7x7x512_f_3x3x512"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "same",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Conv2D_res5_1x1_expand_in_8x7x7x512_f_1x1x2048'
+func @BM_Conv2D_res5_1x1_expand_in_8x7x7x512_f_1x1x2048() {
+  %ch0 = hex.new.chain
+
+  // in: [8, 7, 7, 512].
+  %in = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 7 : i64, 7 : i64, 512 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %in, %ch0 1.0 : f32
+
+  // kern: [1, 1, 512, 2048].
+  %kern = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 512 : i64, 2048 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %kern, %ch1 1.0 : f32
+
+  // bias: [2048].
+  %bias = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [2048 : i64] }
+    : () -> !t.tensor
+  %ch3 = dht.fill_tensor_with_constant.f32 %bias, %ch2 0.0 : f32
+
+  // out: [8, 7, 7, 2048].
+  %out = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [8 : i64, 7 : i64, 7 : i64, 2048 : i64] }
+    : () -> !t.tensor
+
+  tfrt_test.benchmark "BM_Conv2D_res5_1x1_expand_in_8x7x7x512_f_1x1x2048"(
+      %in   : !t.tensor,
+      %kern : !t.tensor,
+      %bias : !t.tensor,
+      %out  : !t.tensor,
+      %ch3  : !hex.chain
+  )
+  duration_secs = 5, max_count = 1000, num_warmup_runs = 10
+  {
+      %ch_out = "eigen.conv2d.bias.f32"(%in, %kern, %bias, %out, %ch3)
+       { padding = "valid",  strides = [1 : i64, 1 : i64] }
+       : (!t.tensor, !t.tensor, !t.tensor,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
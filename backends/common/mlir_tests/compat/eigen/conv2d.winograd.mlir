@@ -0,0 +1,96 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Conv2D shapes that select the Winograd algorithm (3x3 kernel, unit strides,
+// at least 64 input and output channels and 256 output tiles). Expected
+// outputs are computed with the SpatialConvolution algorithm. Odd output sizes
+// exercise partial output tiles, and "same" padding exercises padded tiles.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=always
+
+// CHECK-LABEL: --- Running 'test_conv2d_winograd_in_1x33x31x64_f_3x3_c64_padding_same'
+func @test_conv2d_winograd_in_1x33x31x64_f_3x3_c64_padding_same() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_winograd_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 0
+  %filter_index   = hex.constant.i32 1
+  %expected_index = hex.constant.i32 2
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 33 : i64, 31 : i64, 64 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.f32"(%input, %filter, %output, %ch0)
+    { padding = "same",  strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_winograd_in_2x25x27x64_f_3x3_c72_padding_valid'
+func @test_conv2d_winograd_in_2x25x27x64_f_3x3_c72_padding_valid() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_winograd_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 3
+  %filter_index   = hex.constant.i32 4
+  %expected_index = hex.constant.i32 5
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [2 : i64, 23 : i64, 25 : i64, 72 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.f32"(%input, %filter, %output, %ch0)
+    { padding = "valid",  strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
@@ -14,6 +14,238 @@
 
 // RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=fail
 
+// Small and medium sized matrices measure the crossover points between the
+// small matrix micro kernel, single threaded and multi threaded Eigen tensor
+// contraction (see SelectMatMulStrategy in small_matmul.h).
+
+// CHECK-LABEL: --- Running 'BM_MatMul_4x4x4_f32'
+func @BM_MatMul_4x4x4_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [4, 4].
+  %a = dht.create_uninitialized_tensor.f32.2 [4 : i64, 4 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [4, 4].
+  %b = dht.create_uninitialized_tensor.f32.2 [4 : i64, 4 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [4, 4].
+  %c = dht.create_uninitialized_tensor.f32.2 [4 : i64, 4 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_4x4x4_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_MatMul_16x16x16_f32'
+func @BM_MatMul_16x16x16_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [16, 16].
+  %a = dht.create_uninitialized_tensor.f32.2 [16 : i64, 16 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [16, 16].
+  %b = dht.create_uninitialized_tensor.f32.2 [16 : i64, 16 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [16, 16].
+  %c = dht.create_uninitialized_tensor.f32.2 [16 : i64, 16 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_16x16x16_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_MatMul_32x32x32_f32'
+func @BM_MatMul_32x32x32_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [32, 32].
+  %a = dht.create_uninitialized_tensor.f32.2 [32 : i64, 32 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [32, 32].
+  %b = dht.create_uninitialized_tensor.f32.2 [32 : i64, 32 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [32, 32].
+  %c = dht.create_uninitialized_tensor.f32.2 [32 : i64, 32 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_32x32x32_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_MatMul_64x64x64_f32'
+func @BM_MatMul_64x64x64_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [64, 64].
+  %a = dht.create_uninitialized_tensor.f32.2 [64 : i64, 64 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [64, 64].
+  %b = dht.create_uninitialized_tensor.f32.2 [64 : i64, 64 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [64, 64].
+  %c = dht.create_uninitialized_tensor.f32.2 [64 : i64, 64 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_64x64x64_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_MatMul_128x128x128_f32'
+func @BM_MatMul_128x128x128_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [128, 128].
+  %a = dht.create_uninitialized_tensor.f32.2 [128 : i64, 128 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [128, 128].
+  %b = dht.create_uninitialized_tensor.f32.2 [128 : i64, 128 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [128, 128].
+  %c = dht.create_uninitialized_tensor.f32.2 [128 : i64, 128 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_128x128x128_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 10000, num_warmup_runs = 100
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_MatMul_256x256x256_f32'
+func @BM_MatMul_256x256x256_f32() {
+  %ch0 = hex.new.chain
+
+  %zero = hex.constant.f32 0.0
+  %one = hex.constant.f32 1.0
+
+  // Shape: [256, 256].
+  %a = dht.create_uninitialized_tensor.f32.2 [256 : i64, 256 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  // Shape: [256, 256].
+  %b = dht.create_uninitialized_tensor.f32.2 [256 : i64, 256 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch0 1.0 : f32
+
+  // Shape: [256, 256].
+  %c = dht.create_uninitialized_tensor.f32.2 [256 : i64, 256 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_MatMul_256x256x256_f32"(
+      %zero : f32,
+      %one : f32,
+      %a : !t.tensor,
+      %b : !t.tensor,
+      %c : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 10000, num_warmup_runs = 100
+  {
+      %ch_out = "eigen.matmul.f32"(%one, %a, %b, %zero, %c, %ch3)
+       : (f32, !t.tensor, !t.tensor, f32,
+          !t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
 // CHECK-LABEL: --- Running 'BM_MatMul_512x512x512_f32'
 func @BM_MatMul_512x512x512_f32() {
   %ch0 = hex.new.chain
@@ -95,3 +95,91 @@ func @test_matmul_f32() {
 
   hex.return
 }
+
+// CHECK-LABEL: --- Running 'test_matmul_packed_f32'
+func @test_matmul_packed_f32() {
+  %ch0 = hex.new.chain
+
+  %a = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 3 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%a, %ch0)
+    { values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32, 5.0 : f32, 6.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %b = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [3 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch2 = "dht.set_tensor_with_constant_values.f32"(%b, %ch1)
+    { values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32, 5.0 : f32, 6.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %c = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+
+  %packed = "eigen.pack_matmul_rhs.f32"(%b, %ch2)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+  %ch3 = "eigen.matmul.packed.f32"(%a, %packed, %c, %ch2)
+    : (!t.tensor, !eigen.packed_matmul_rhs, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2], values = [2.200000e+01, 2.800000e+01, 4.900000e+01, 6.400000e+01]
+  %ch4 = dht.print_tensor %c, %ch3
+
+  // Packing the same weights again returns the cached panels.
+  %cached = "eigen.pack_matmul_rhs.f32"(%b, %ch4)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+  %ch5 = "dht.set_tensor_with_constant_values.f32"(%c, %ch4)
+    { values = [0.0 : f32, 0.0 : f32, 0.0 : f32, 0.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %ch6 = "eigen.matmul.packed.f32"(%a, %cached, %c, %ch5)
+    : (!t.tensor, !eigen.packed_matmul_rhs, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2], values = [2.200000e+01, 2.800000e+01, 4.900000e+01, 6.400000e+01]
+  dht.print_tensor %c, %ch6
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_matmul_packed_f32_shape_error'
+func @test_matmul_packed_f32_shape_error() {
+  %ch0 = hex.new.chain
+
+  %a = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch1 = dht.fill_tensor_with_constant.f32 %a, %ch0 1.0 : f32
+
+  %b = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [3 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch2 = dht.fill_tensor_with_constant.f32 %b, %ch1 1.0 : f32
+
+  %c = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+
+  %packed = "eigen.pack_matmul_rhs.f32"(%b, %ch2)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+
+  // expected-error @+1 {{MatMulPacked input tensors inner dimension mismatch: [2, 2] vs. 3}}
+  "eigen.matmul.packed.f32"(%a, %packed, %c, %ch2)
+    : (!t.tensor, !eigen.packed_matmul_rhs, !t.tensor, !hex.chain) -> !hex.chain
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_pack_matmul_rhs_f32_rank_error'
+func @test_pack_matmul_rhs_f32_rank_error() {
+  %ch0 = hex.new.chain
+
+  %b = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [3 : i64] }
+    : () -> !t.tensor
+
+  // expected-error @+1 {{PackMatMulRhs weights must be a 2-D tensor: [3]}}
+  "eigen.pack_matmul_rhs.f32"(%b, %ch0)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+
+  hex.return
+}
@@ -0,0 +1,235 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Expected outputs are computed in double precision. Average pooling with
+// "same" padding divides by the number of input elements inside the window,
+// which is smaller than the pool size at the borders. Max pooling inputs are
+// all negative, so that padding or a zero initial value would show up in the
+// output.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=always
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor --work_queue_type=mstd:4 | FileCheck %s --dump-input=always
+
+// CHECK-LABEL: --- Running 'test_avg_pooling2d_in_1x9x9x8_padding_same_p_3x3_s_2x2'
+func @test_avg_pooling2d_in_1x9x9x8_padding_same_p_3x3_s_2x2() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 0
+  %expected_index = hex.constant.i32 1
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 5 : i64, 5 : i64, 8 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.avg_pooling_2d.f32"(%input, %output, %ch0)
+    { padding = "same",
+       pool_size = [3 : i64, 3 : i64],
+       strides = [2 : i64, 2 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.3ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_avg_pooling2d_in_2x10x7x20_padding_same_p_2x3_s_1x1'
+func @test_avg_pooling2d_in_2x10x7x20_padding_same_p_2x3_s_1x1() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 2
+  %expected_index = hex.constant.i32 3
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [2 : i64, 10 : i64, 7 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.avg_pooling_2d.f32"(%input, %output, %ch0)
+    { padding = "same",
+       pool_size = [2 : i64, 3 : i64],
+       strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.3ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_avg_pooling2d_in_1x9x9x8_padding_valid_p_3x3_s_2x2'
+func @test_avg_pooling2d_in_1x9x9x8_padding_valid_p_3x3_s_2x2() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 4
+  %expected_index = hex.constant.i32 5
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 4 : i64, 4 : i64, 8 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.avg_pooling_2d.f32"(%input, %output, %ch0)
+    { padding = "valid",
+       pool_size = [3 : i64, 3 : i64],
+       strides = [2 : i64, 2 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.3ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_global_avg_pooling_in_2x7x7x33'
+func @test_global_avg_pooling_in_2x7x7x33() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 6
+  %expected_index = hex.constant.i32 7
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.2"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 33 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.global_avg_pooling.f32"(%input, %output, %ch0)
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.3ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_max_pooling2d_negative_in_1x9x9x8_padding_same_p_3x3_s_2x2'
+func @test_max_pooling2d_negative_in_1x9x9x8_padding_same_p_3x3_s_2x2() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 8
+  %expected_index = hex.constant.i32 9
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 5 : i64, 5 : i64, 8 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.max_pooling_2d.f32"(%input, %output, %ch0)
+    { padding = "same",
+       pool_size = [3 : i64, 3 : i64],
+       strides = [2 : i64, 2 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_max_pooling2d_negative_in_2x10x7x20_padding_valid_p_2x3_s_1x1'
+func @test_max_pooling2d_negative_in_2x10x7x20_padding_valid_p_2x3_s_1x1() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/pooling_f32.btf"
+  } : () -> !hex.string
+
+  %input_index    = hex.constant.i32 10
+  %expected_index = hex.constant.i32 11
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.f32.4"()
+    { shape = [2 : i64, 9 : i64, 5 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.max_pooling_2d.f32"(%input, %output, %ch0)
+    { padding = "valid",
+       pool_size = [2 : i64, 3 : i64],
+       strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch3 = "dht.tensor_allclose.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch3
+
+  hex.return
+}
@@ -0,0 +1,452 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Expected outputs are computed with a scalar reference implementation. The
+// second run forces the scalar micro kernel, so both SIMD and scalar kernels
+// are checked against the same outputs.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=always
+// RUN: tfrt_translate -mlir-to-bef %s | env TFRT_DISABLE_QUANTIZED_GEMM_SIMD=true bef_executor | FileCheck %s --dump-input=always
+
+// CHECK-LABEL: --- Running 'test_matmul_qi8'
+func @test_matmul_qi8() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_matmul_qi8.btf"
+  } : () -> !hex.string
+
+  %a_index = hex.constant.i32 0
+  %b_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 2
+  %scale_index = hex.constant.i32 3
+  %expected_index = hex.constant.i32 4
+
+  // Shape: [5, 7].
+  %a = "btf.read_dense_tensor.ui8.2"(%path, %a_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [7, 18].
+  %b = "btf.read_dense_tensor.i8.2"(%path, %b_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [5, 18].
+  %expected = "btf.read_dense_tensor.ui8.2"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %c = "dht.create_uninitialized_tensor.ui8.2"()
+    { shape = [5 : i64, 18 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.matmul.qi8"(%a, %b, %bias, %scale, %c, %ch0)
+    { input_zero_point = 3 : i32, output_zero_point = 100 : i32 }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %c, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_matmul_relu_qi8'
+func @test_matmul_relu_qi8() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_matmul_qi8.btf"
+  } : () -> !hex.string
+
+  %a_index = hex.constant.i32 0
+  %b_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 2
+  %scale_index = hex.constant.i32 3
+  %expected_index = hex.constant.i32 5
+
+  // Shape: [5, 7].
+  %a = "btf.read_dense_tensor.ui8.2"(%path, %a_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [7, 18].
+  %b = "btf.read_dense_tensor.i8.2"(%path, %b_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [5, 18].
+  %expected = "btf.read_dense_tensor.ui8.2"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %c = "dht.create_uninitialized_tensor.ui8.2"()
+    { shape = [5 : i64, 18 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.matmul.relu.qi8"(%a, %b, %bias, %scale, %c, %ch0)
+    { input_zero_point = 3 : i32, output_zero_point = 100 : i32 }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %c, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_matmul_packed_relu_qi8'
+func @test_matmul_packed_relu_qi8() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_matmul_qi8.btf"
+  } : () -> !hex.string
+
+  %a_index = hex.constant.i32 0
+  %b_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 2
+  %scale_index = hex.constant.i32 3
+  %expected_index = hex.constant.i32 5
+
+  // Shape: [5, 7].
+  %a = "btf.read_dense_tensor.ui8.2"(%path, %a_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [7, 18].
+  %b = "btf.read_dense_tensor.i8.2"(%path, %b_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [18].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [5, 18].
+  %expected = "btf.read_dense_tensor.ui8.2"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %c = "dht.create_uninitialized_tensor.ui8.2"()
+    { shape = [5 : i64, 18 : i64] }
+    : () -> !t.tensor
+
+  %packed = "eigen.pack_matmul_rhs.qi8"(%b, %ch0)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+
+  %ch1 = "eigen.matmul.packed.relu.qi8"(%a, %packed, %bias, %scale, %c, %ch0)
+    { input_zero_point = 3 : i32, output_zero_point = 100 : i32 }
+    : (!t.tensor, !eigen.packed_matmul_rhs, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %c, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_qi8_padding_same'
+func @test_conv2d_qi8_padding_same() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_conv2d_qi8.btf"
+  } : () -> !hex.string
+
+  %input_index = hex.constant.i32 0
+  %filter_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 3
+  %scale_index = hex.constant.i32 4
+  %expected_index = hex.constant.i32 5
+
+  // Shape: [2, 5, 5, 3].
+  %input = "btf.read_dense_tensor.ui8.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [3, 3, 3, 20].
+  %filter = "btf.read_dense_tensor.i8.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [2, 5, 5, 20].
+  %expected = "btf.read_dense_tensor.ui8.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.ui8.4"()
+    { shape = [2 : i64, 5 : i64, 5 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  // Padded values are filled with the input zero point, so they contribute
+  // zero to the real valued outputs.
+  %ch1 = "eigen.conv2d.qi8"(%input, %filter, %bias, %scale, %output, %ch0)
+    { input_zero_point = 7 : i32, output_zero_point = 128 : i32,
+      padding = "same", strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %output, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_relu_qi8_padding_same_s_2x2'
+func @test_conv2d_relu_qi8_padding_same_s_2x2() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_conv2d_qi8.btf"
+  } : () -> !hex.string
+
+  %input_index = hex.constant.i32 0
+  %filter_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 3
+  %scale_index = hex.constant.i32 4
+  %expected_index = hex.constant.i32 6
+
+  // Shape: [2, 5, 5, 3].
+  %input = "btf.read_dense_tensor.ui8.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [3, 3, 3, 20].
+  %filter = "btf.read_dense_tensor.i8.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [2, 3, 3, 20].
+  %expected = "btf.read_dense_tensor.ui8.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.ui8.4"()
+    { shape = [2 : i64, 3 : i64, 3 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.conv2d.relu.qi8"(%input, %filter, %bias, %scale, %output, %ch0)
+    { input_zero_point = 7 : i32, output_zero_point = 128 : i32,
+      padding = "same", strides = [2 : i64, 2 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %output, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_qi8_pointwise'
+func @test_conv2d_qi8_pointwise() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_conv2d_qi8.btf"
+  } : () -> !hex.string
+
+  %input_index = hex.constant.i32 0
+  %filter_index = hex.constant.i32 2
+  %bias_index = hex.constant.i32 3
+  %scale_index = hex.constant.i32 4
+  %expected_index = hex.constant.i32 7
+
+  // Shape: [2, 5, 5, 3].
+  %input = "btf.read_dense_tensor.ui8.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [1, 1, 3, 20].
+  %filter = "btf.read_dense_tensor.i8.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [20].
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // Shape: [2, 5, 5, 20].
+  %expected = "btf.read_dense_tensor.ui8.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output = "dht.create_uninitialized_tensor.ui8.4"()
+    { shape = [2 : i64, 5 : i64, 5 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.conv2d.qi8"(%input, %filter, %bias, %scale, %output, %ch0)
+    { input_zero_point = 7 : i32, output_zero_point = 128 : i32,
+      padding = "valid", strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp, %ch2 = dht.tensor_equal.ui8 %expected, %output, %ch1
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp, %ch2
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_conv2d_qi8_packed'
+func @test_conv2d_qi8_packed() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_conv2d_qi8.btf"
+  } : () -> !hex.string
+
+  %input_index = hex.constant.i32 0
+  %filter_index = hex.constant.i32 1
+  %bias_index = hex.constant.i32 3
+  %scale_index = hex.constant.i32 4
+  %expected_index = hex.constant.i32 5
+
+  %input = "btf.read_dense_tensor.ui8.4"(%path, %input_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %filter = "btf.read_dense_tensor.i8.4"(%path, %filter_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %bias = "btf.read_dense_tensor.i32.1"(%path, %bias_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected = "btf.read_dense_tensor.ui8.4"(%path, %expected_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %output0 = "dht.create_uninitialized_tensor.ui8.4"()
+    { shape = [2 : i64, 5 : i64, 5 : i64, 20 : i64] }
+    : () -> !t.tensor
+  %output1 = "dht.create_uninitialized_tensor.ui8.4"()
+    { shape = [2 : i64, 5 : i64, 5 : i64, 20 : i64] }
+    : () -> !t.tensor
+
+  // Both convolutions use the filter packed once.
+  %packed = "eigen.pack_conv2d_filter.qi8"(%filter, %ch0)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_conv2d_filter
+
+  %ch1 = "eigen.conv2d.packed.qi8"(%input, %packed, %bias, %scale, %output0,
+                                   %ch0)
+    { input_zero_point = 7 : i32, output_zero_point = 128 : i32,
+      padding = "same", strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !eigen.packed_conv2d_filter, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+  %ch2 = "eigen.conv2d.packed.qi8"(%input, %packed, %bias, %scale, %output1,
+                                   %ch1)
+    { input_zero_point = 7 : i32, output_zero_point = 128 : i32,
+      padding = "same", strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !eigen.packed_conv2d_filter, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  %cmp0, %ch3 = dht.tensor_equal.ui8 %expected, %output0, %ch2
+  // CHECK: int1 = 1
+  %ch4 = hex.print.i1 %cmp0, %ch3
+
+  %cmp1, %ch5 = dht.tensor_equal.ui8 %expected, %output1, %ch4
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp1, %ch5
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_matmul_packed_qi8_shape_error'
+func @test_matmul_packed_qi8_shape_error() {
+  %ch0 = hex.new.chain
+
+  %a = "dht.create_uninitialized_tensor.ui8.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %bias = "dht.create_uninitialized_tensor.i32.1"()
+    { shape = [18 : i64] }
+    : () -> !t.tensor
+  %scale = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [18 : i64] }
+    : () -> !t.tensor
+  %c = "dht.create_uninitialized_tensor.ui8.2"()
+    { shape = [2 : i64, 18 : i64] }
+    : () -> !t.tensor
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_matmul_qi8.btf"
+  } : () -> !hex.string
+  %b_index = hex.constant.i32 1
+
+  // Shape: [7, 18].
+  %b = "btf.read_dense_tensor.i8.2"(%path, %b_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %packed = "eigen.pack_matmul_rhs.qi8"(%b, %ch0)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_matmul_rhs
+
+  // expected-error @+1 {{MatMul input tensors inner dimension mismatch: [2, 2] vs. [7, 18]}}
+  "eigen.matmul.packed.qi8"(%a, %packed, %bias, %scale, %c, %ch0)
+    { input_zero_point = 0 : i32, output_zero_point = 0 : i32 }
+    : (!t.tensor, !eigen.packed_matmul_rhs, !t.tensor, !t.tensor,
+       !t.tensor, !hex.chain) -> !hex.chain
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_pack_conv2d_filter_qi8_rank_error'
+func @test_pack_conv2d_filter_qi8_rank_error() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+    value = "backends/common/mlir_tests/compat/eigen/test_data/quantized_matmul_qi8.btf"
+  } : () -> !hex.string
+  %b_index = hex.constant.i32 1
+
+  // Shape: [7, 18].
+  %filter = "btf.read_dense_tensor.i8.2"(%path, %b_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  // expected-error @+1 {{PackQuantizedConv2DFilter filter must be a 4-D tensor: [7, 18]}}
+  "eigen.pack_conv2d_filter.qi8"(%filter, %ch0)
+    : (!t.tensor, !hex.chain) -> !eigen.packed_conv2d_filter
+
+  hex.return
+}
@@ -25,6 +25,7 @@
 
 #include "mkldnn.h"  // from @mkl_dnn
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/common/compat/eigen/small_matmul.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
@@ -94,27 +95,14 @@ template <typename T>
 void MatMul2DKernel(T alpha, DHTIndexableView<T, 2> A, DHTIndexableView<T, 2> B,
                     T beta, MutableDHTIndexableView<T, 2>& C, bool transpose_a,
                     bool transpose_b) {
-  T zero = static_cast<T>(0);
   // TODO(zhangqiaorjc): Handle transpose.
   assert(transpose_a == false);
   assert(transpose_b == false);
-  size_t rows = C.FixedShape()[0];
-  size_t cols = C.FixedShape()[1];
-  size_t inner_dim = A.FixedShape()[1];
-  for (size_t i = 0; i < rows; ++i) {
-    for (size_t j = 0; j < cols; ++j) {
-      T sum = zero;
-      for (size_t k = 0; k < inner_dim; ++k) {
-        sum += A.ElementAt(i, k) * B.ElementAt(k, j);
-      }
-      // We need to handle beta=0 without using C as input since C is
-      // uninitialized to avoid msan errors.
-      if (beta == zero)
-        C.ElementAt(i, j) = alpha * sum;
-      else
-        C.ElementAt(i, j) = alpha * sum + beta * C.ElementAt(i, j);
-    }
-  }
+  const int64_t m = C.FixedShape()[0];
+  const int64_t n = C.FixedShape()[1];
+  const int64_t k = A.FixedShape()[1];
+  ::tfrt::compat::SmallMatMul<T>(alpha, A.data(), k, B.data(), n, beta,
+                                 C.data(), n, m, n, k);
 }
 
 template <>
@@ -142,6 +130,19 @@ inline void MatMul2DKernel<float>(float alpha, DHTIndexableView<float, 2> A,
   assert(shape_A[dim_pair[0]] == shape_B[dim_pair[1]] &&
          "matmul arguments have incompatible shapes");
 
+  // Small products are faster to compute inline than to dispatch to sgemm.
+  if (!transpose_a && !transpose_b) {
+    const int64_t m = shape_A[0];
+    const int64_t n = shape_B[1];
+    const int64_t k = shape_A[1];
+    if (::tfrt::compat::SelectMatMulStrategy(m, n, k) ==
+        ::tfrt::compat::MatMulStrategy::kSmall) {
+      ::tfrt::compat::SmallMatMul<float>(alpha, A.data(), k, B.data(), n, beta,
+                                         C.data(), n, m, n, k);
+      return;
+    }
+  }
+
   // m: Specifies the number of rows of the matrix op(a) and of the matrix c.
   // The value of m must be at least zero.
   //
@@ -0,0 +1,384 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- fused_elementwise.h --------------------------------------*- C++ -*-===//
+//
+// Elementwise expression fusion engine.
+//
+// A fused elementwise expression is a DAG of elementwise operations over input
+// tensors broadcasted to the output shape, and over scalar constants. It is
+// encoded as a flat bytecode of (opcode, lhs, rhs) instructions. Value ids
+// [0, num_inputs) refer to the inputs, the following num_constants ids refer
+// to the constants, and every instruction defines the next value id. The last
+// instruction defines the output. Unary instructions ignore the rhs operand.
+//
+// The expression is evaluated one tile of contiguous output elements at a
+// time, so intermediate values never leave the L1 cache, and every input
+// element is read and every output element is written exactly once.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_FUSED_ELEMENTWISE_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_FUSED_ELEMENTWISE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace cpu {
+
+// Opcode values are part of the bytecode encoding, do not renumber them.
+enum class FusedElementwiseOpcode : int32_t {
+  // Binary operations.
+  kAdd = 0,
+  kSub = 1,
+  kMul = 2,
+  kDiv = 3,
+  kMaximum = 4,
+  kMinimum = 5,
+  // Unary operations.
+  kNeg = 6,
+  kAbs = 7,
+  kRelu = 8,
+  kSquare = 9,
+  kSqrt = 10,
+  kRsqrt = 11,
+  kExp = 12,
+  kLog = 13,
+  kTanh = 14,
+  kSigmoid = 15,
+};
+
+constexpr int32_t kNumFusedElementwiseOpcodes = 16;
+
+inline bool IsBinary(FusedElementwiseOpcode opcode) {
+  return opcode < FusedElementwiseOpcode::kNeg;
+}
+
+template <typename T>
+class FusedElementwiseExpression {
+ public:
+  // Number of output elements evaluated by every pass over the bytecode.
+  static constexpr ssize_t kTileSize = 256;
+
+  // Validates the bytecode, and the broadcasting of the `inputs` shapes to the
+  // `output` shape. The output must not alias broadcasted inputs.
+  static Expected<FusedElementwiseExpression> Create(
+      ArrayRef<int32_t> program, ArrayRef<T> constants,
+      ArrayRef<const DenseHostTensor*> inputs, DenseHostTensor* output);
+
+  ssize_t NumElements() const { return num_elements_; }
+
+  // Evaluates output elements [begin, end).
+  void Evaluate(ssize_t begin, ssize_t end) const;
+
+ private:
+  struct Instruction {
+    FusedElementwiseOpcode opcode;
+    int32_t lhs;
+    int32_t rhs;
+  };
+
+  FusedElementwiseExpression() = default;
+
+  ssize_t Stride(size_t input, size_t dim) const {
+    return strides_[input * dims_.size() + dim];
+  }
+
+  static void EvaluateInstruction(const Instruction& instruction,
+                                  ArrayRef<const T*> values, T* result,
+                                  ssize_t size);
+
+  llvm::SmallVector<Instruction, 8> instructions_;
+  llvm::SmallVector<T, 4> constants_;
+  llvm::SmallVector<const T*, 4> inputs_;
+  T* output_ = nullptr;
+  ssize_t num_elements_ = 0;
+
+  // Output dimensions, after dropping unit dimensions and merging dimensions
+  // that are contiguous in all inputs, and the strides of every input along
+  // these dimensions (zero for broadcasted dimensions).
+  llvm::SmallVector<ssize_t, 4> dims_;
+  llvm::SmallVector<ssize_t, 16> strides_;
+};
+
+template <typename T>
+Expected<FusedElementwiseExpression<T>> FusedElementwiseExpression<T>::Create(
+    ArrayRef<int32_t> program, ArrayRef<T> constants,
+    ArrayRef<const DenseHostTensor*> inputs, DenseHostTensor* output) {
+  FusedElementwiseExpression expr;
+
+  if (program.empty() || program.size() % 3 != 0) {
+    return MakeStringError(
+        "fused elementwise program must be a non-empty list of (opcode, lhs, "
+        "rhs) triples, got ",
+        program.size(), " values");
+  }
+
+  // Validate the bytecode.
+  int32_t num_values = inputs.size() + constants.size();
+  for (size_t i = 0; i < program.size(); i += 3, ++num_values) {
+    const int32_t opcode = program[i];
+    if (opcode < 0 || opcode >= kNumFusedElementwiseOpcodes)
+      return MakeStringError("invalid fused elementwise opcode ", opcode);
+
+    Instruction instruction{static_cast<FusedElementwiseOpcode>(opcode),
+                            program[i + 1], program[i + 2]};
+    auto is_defined = [&](int32_t id) { return id >= 0 && id < num_values; };
+    if (!is_defined(instruction.lhs) ||
+        (IsBinary(instruction.opcode) && !is_defined(instruction.rhs))) {
+      return MakeStringError("fused elementwise instruction ", i / 3,
+                             " uses an undefined value");
+    }
+    expr.instructions_.push_back(instruction);
+  }
+  expr.constants_.assign(constants.begin(), constants.end());
+
+  // Compute the input strides in the output iteration space.
+  const TensorShape& output_shape = output->shape();
+  const int output_rank = output_shape.GetRank();
+  llvm::SmallVector<ssize_t, 4> output_dims(output_rank);
+  output_shape.GetDimensions(output_dims);
+
+  llvm::SmallVector<ssize_t, 16> strides(inputs.size() * output_rank, 0);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const DenseHostTensor* input = inputs[i];
+    if (input->dtype() != output->dtype())
+      return MakeStringError("fused elementwise input #", i, " has dtype ",
+                             input->dtype(), ", expected ", output->dtype());
+
+    const TensorShape& input_shape = input->shape();
+    const int input_rank = input_shape.GetRank();
+    if (input_rank > output_rank)
+      return MakeStringError("fused elementwise input #", i, " shape ",
+                             input_shape, " has higher rank than the output ",
+                             output_shape);
+
+    // Inputs are aligned with the innermost output dimensions.
+    ssize_t stride = 1;
+    for (int d = input_rank - 1; d >= 0; --d) {
+      const ssize_t dim = input_shape.GetDimensionSize(d);
+      const int output_dim = output_rank - input_rank + d;
+      if (dim != 1 && dim != output_dims[output_dim])
+        return MakeStringError("fused elementwise input #", i, " shape ",
+                               input_shape, " is not broadcastable to ",
+                               output_shape);
+      if (dim != 1) strides[i * output_rank + output_dim] = stride;
+      stride *= dim;
+    }
+    expr.inputs_.push_back(static_cast<const T*>(input->data()));
+  }
+
+  // Drop unit dimensions, and merge each dimension into the previous one if
+  // they are contiguous in all inputs.
+  llvm::SmallVector<ssize_t, 4> dims;
+  llvm::SmallVector<int, 4> dims_source;
+  for (int d = 0; d < output_rank; ++d) {
+    if (output_dims[d] == 1) continue;
+    bool contiguous = !dims.empty();
+    for (size_t i = 0; contiguous && i < inputs.size(); ++i) {
+      contiguous = strides[i * output_rank + dims_source.back()] ==
+                   strides[i * output_rank + d] * output_dims[d];
+    }
+    if (contiguous) {
+      dims.back() *= output_dims[d];
+      dims_source.back() = d;
+    } else {
+      dims.push_back(output_dims[d]);
+      dims_source.push_back(d);
+    }
+  }
+  if (dims.empty()) dims.push_back(1);
+
+  expr.dims_ = dims;
+  expr.strides_.resize(inputs.size() * dims.size(), 0);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    for (size_t d = 0; d < dims_source.size(); ++d) {
+      expr.strides_[i * dims.size() + d] =
+          strides[i * output_rank + dims_source[d]];
+    }
+  }
+
+  expr.output_ = static_cast<T*>(output->data());
+  expr.num_elements_ = output->NumElements();
+  return std::move(expr);
+}
+
+template <typename T>
+void FusedElementwiseExpression<T>::EvaluateInstruction(
+    const Instruction& instruction, ArrayRef<const T*> values, T* result,
+    ssize_t size) {
+  using Vector = Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+  using ConstVector =
+      Eigen::TensorMap<const Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+
+  Vector out(result, size);
+  ConstVector x(values[instruction.lhs], size);
+  ConstVector y(
+      IsBinary(instruction.opcode) ? values[instruction.rhs] : nullptr, size);
+
+  switch (instruction.opcode) {
+    case FusedElementwiseOpcode::kAdd:
+      out = x + y;
+      return;
+    case FusedElementwiseOpcode::kSub:
+      out = x - y;
+      return;
+    case FusedElementwiseOpcode::kMul:
+      out = x * y;
+      return;
+    case FusedElementwiseOpcode::kDiv:
+      out = x / y;
+      return;
+    case FusedElementwiseOpcode::kMaximum:
+      out = x.cwiseMax(y);
+      return;
+    case FusedElementwiseOpcode::kMinimum:
+      out = x.cwiseMin(y);
+      return;
+    case FusedElementwiseOpcode::kNeg:
+      out = -x;
+      return;
+    case FusedElementwiseOpcode::kAbs:
+      out = x.abs();
+      return;
+    case FusedElementwiseOpcode::kRelu:
+      out = x.cwiseMax(static_cast<T>(0));
+      return;
+    case FusedElementwiseOpcode::kSquare:
+      out = x.square();
+      return;
+    case FusedElementwiseOpcode::kSqrt:
+      out = x.sqrt();
+      return;
+    case FusedElementwiseOpcode::kRsqrt:
+      out = x.rsqrt();
+      return;
+    case FusedElementwiseOpcode::kExp:
+      out = x.exp();
+      return;
+    case FusedElementwiseOpcode::kLog:
+      out = x.log();
+      return;
+    case FusedElementwiseOpcode::kTanh:
+      out = x.tanh();
+      return;
+    case FusedElementwiseOpcode::kSigmoid:
+      out = x.sigmoid();
+      return;
+  }
+}
+
+template <typename T>
+void FusedElementwiseExpression<T>::Evaluate(ssize_t begin,
+                                             ssize_t end) const {
+  const size_t num_inputs = inputs_.size();
+  const size_t num_constants = constants_.size();
+  const size_t num_values = num_inputs + num_constants + instructions_.size();
+  const int rank = dims_.size();
+  const ssize_t inner_dim = dims_.back();
+  // Local copy, std::min takes its arguments by reference.
+  const ssize_t tile_size = kTileSize;
+
+  // Scratch tiles for inputs broadcasted along the innermost dimension, for
+  // constants and for intermediate values.
+  std::vector<T> scratch(num_values * kTileSize);
+  auto tile = [&](size_t value) { return scratch.data() + value * kTileSize; };
+
+  llvm::SmallVector<const T*, 16> values(num_values);
+  for (size_t c = 0; c < num_constants; ++c) {
+    T* constant = tile(num_inputs + c);
+    std::fill(constant, constant + kTileSize, constants_[c]);
+    values[num_inputs + c] = constant;
+  }
+
+  llvm::SmallVector<ssize_t, 4> offsets(num_inputs);
+  for (ssize_t pos = begin; pos < end;) {
+    // Compute input offsets of the first element of the innermost row.
+    ssize_t row = pos / inner_dim;
+    ssize_t col = pos % inner_dim;
+    const ssize_t row_end = std::min(end, pos - col + inner_dim);
+
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (int d = rank - 2; d >= 0; --d) {
+      const ssize_t index = row % dims_[d];
+      row /= dims_[d];
+      for (size_t i = 0; i < num_inputs; ++i)
+        offsets[i] += index * Stride(i, d);
+    }
+
+    // Inputs broadcasted along the innermost dimension are constant in a row.
+    for (size_t i = 0; i < num_inputs; ++i) {
+      if (Stride(i, rank - 1) != 0) continue;
+      T* broadcasted = tile(i);
+      std::fill(broadcasted,
+                broadcasted + std::min(tile_size, row_end - pos),
+                inputs_[i][offsets[i]]);
+      values[i] = broadcasted;
+    }
+
+    for (; pos < row_end; col += tile_size, pos += tile_size) {
+      const ssize_t size = std::min(tile_size, row_end - pos);
+      for (size_t i = 0; i < num_inputs; ++i) {
+        if (Stride(i, rank - 1) != 0) values[i] = inputs_[i] + offsets[i] + col;
+      }
+
+      // The last instruction writes directly to the output.
+      for (size_t k = 0; k < instructions_.size(); ++k) {
+        const size_t value = num_inputs + num_constants + k;
+        T* result =
+            k + 1 == instructions_.size() ? output_ + pos : tile(value);
+        EvaluateInstruction(instructions_[k], values, result, size);
+        values[value] = result;
+      }
+    }
+    pos = row_end;
+  }
+}
+
+// Evaluates the fused elementwise expression in parallel blocks of tiles in
+// the HostContext thread pool, and calls `done` when all blocks are completed.
+template <typename T>
+void AsyncFusedElementwise(HostContext* host,
+                           FusedElementwiseExpression<T> expr,
+                           llvm::unique_function<void()> done) {
+  // Every block evaluates at least a few tiles to amortize scheduling costs.
+  static constexpr size_t kMinBlockSize =
+      16 * FusedElementwiseExpression<T>::kTileSize;
+
+  const size_t num_elements = expr.NumElements();
+  auto compute = [expr = std::move(expr)](size_t begin, size_t end) {
+    expr.Evaluate(begin, end);
+  };
+
+  ParallelFor(host).Execute(num_elements,
+                            ParallelFor::BlockSizes::Min(kMinBlockSize),
+                            std::move(compute), std::move(done));
+}
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_FUSED_ELEMENTWISE_H_
@@ -0,0 +1,79 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- fused_elementwise_kernels.cc ---------------------------------------===//
+//
+// This file implements the cpu.fused_elementwise kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#include "fused_elementwise.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+
+// Evaluates the fused elementwise expression `program` over the `inputs`
+// broadcasted to the `output` shape. See fused_elementwise.h for the bytecode
+// encoding.
+//
+// Example (computes `output = relu(a * 2.0 + b)`):
+//   %ch1 = "cpu.fused_elementwise.f32"(%output, %ch0, %a, %b)
+//     { constants = [2.0 : f32], program = [2 : i32, 0 : i32, 2 : i32,
+//                                           0 : i32, 3 : i32, 1 : i32,
+//                                           8 : i32, 4 : i32, 0 : i32] }
+template <typename T>
+static void FusedElementwise(Argument<DenseHostTensor> output,
+                             Argument<Chain> chain_in,
+                             RepeatedArguments<DenseHostTensor> inputs,
+                             Result<Chain> chain_out,
+                             ArrayAttribute<T> constants,
+                             ArrayAttribute<int32_t> program,
+                             KernelErrorHandler handler,
+                             const ExecutionContext& exec_ctx,
+                             KernelFrame* frame) {
+  if (output->dtype() != GetDType<T>()) {
+    handler.ReportError("cpu.fused_elementwise output has dtype ",
+                        output->dtype(), ", expected ", GetDType<T>());
+    return;
+  }
+
+  llvm::SmallVector<const DenseHostTensor*, 4> input_tensors;
+  for (const DenseHostTensor& input : inputs) input_tensors.push_back(&input);
+
+  auto expr = FusedElementwiseExpression<T>::Create(
+      program.data(), constants.data(), input_tensors, &output.get());
+  TFRT_RETURN_IF_ERROR(handler, expr.takeError());
+
+  AsyncFusedElementwise<T>(
+      exec_ctx.host(), std::move(*expr),
+      [chain = chain_out.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
+}
+
+// This is the entrypoint to the library.
+void RegisterFusedElementwiseKernels(KernelRegistry* registry) {
+  registry->AddKernel("cpu.fused_elementwise.f32",
+                      TFRT_KERNEL(FusedElementwise<float>));
+  registry->AddKernel("cpu.fused_elementwise.f64",
+                      TFRT_KERNEL(FusedElementwise<double>));
+}
+
+}  // namespace cpu
+}  // namespace tfrt
@@ -18,14 +18,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "jpeg/jpeg_mem.h"
 #include "resize_bilinear_op.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor_view.h"
 #include "tfrt/tensor/dense_tensor_utils.h"
+#include "tfrt/tensor/string_host_tensor.h"
 
 namespace tfrt {
 namespace image {
@@ -60,46 +67,380 @@ static AsyncValueRef<DenseHostTensor> DecodeJpeg(
 }
 
 // TODO(donglin): allocate tensor buffer outside this kernel
-// Returns tf.compat.v1.image.resize(input, [height, width])
-static llvm::Expected<DenseHostTensor> ResizeBilinear(
-    const DenseHostTensor& input, int64_t height, int64_t width,
+// Returns tf.compat.v1.image.resize(input, [height, width]) for a uint8 input
+// of shape [height, width, channels] or [batch, height, width, channels]. The
+// output has the same rank as the input and dtype T (float or uint8). Output
+// rows are resized in parallel.
+template <typename T>
+static AsyncValueRef<DenseHostTensor> ResizeBilinear(
+    Argument<DenseHostTensor> input, int64_t height, int64_t width,
     const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  const TensorShape& shape = input.shape();
-  if (shape.GetRank() != 3) {
-    return MakeStringError("input tensor shape must be 3");
+  const TensorShape& shape = input->shape();
+  const int rank = shape.GetRank();
+  if (rank != 3 && rank != 4) {
+    return EmitErrorAsync(exec_ctx, "input tensor rank must be 3 or 4");
+  }
+  if (input->dtype().kind() != DType::UI8) {
+    return EmitErrorAsync(exec_ctx, "input tensor dtype must be ui8");
   }
 
-  ssize_t batch_size = 1;
-  ssize_t input_height = shape.GetDimensionSize(0);
-  ssize_t input_width = shape.GetDimensionSize(1);
-  ssize_t channels = shape.GetDimensionSize(2);
+  const int offset = rank - 3;
+  ssize_t batch_size = offset ? shape.GetDimensionSize(0) : 1;
+  ssize_t input_height = shape.GetDimensionSize(offset + 0);
+  ssize_t input_width = shape.GetDimensionSize(offset + 1);
+  ssize_t channels = shape.GetDimensionSize(offset + 2);
   float height_scale = input_height / static_cast<float>(height);
   float width_scale = input_width / static_cast<float>(width);
 
-  // Create the temporary output tensor with batch_size=1. This follows the same
+  // Create the output tensor with a batch dimension. This follows the same
   // logic in tf.image.resize which adds a batch dimension if the input image
-  // does not have the batch dimension. It is easier to port the code from TF
-  // to TFRT by following the same logic. And in the future we may also want
-  // this kernel to process input image with or without the batch dimension.
-  auto dht = DenseHostTensor::CreateUninitialized<float>(
+  // does not have the batch dimension.
+  auto dht = DenseHostTensor::CreateUninitialized<T>(
       TensorShape({batch_size, height, width, channels}), host);
+  if (!dht) {
+    return EmitErrorAsync(exec_ctx, "cannot allocate tensor");
+  }
+
+  auto result = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  auto output = std::make_unique<DenseHostTensor>(std::move(*dht));
+  auto* output_ptr = output.get();
+  ResizeImageInParallel(
+      input.get(), height_scale, width_scale, *output_ptr, host,
+      [input = input.ValueRef(), output = std::move(output),
+       result = result.CopyRef(), offset, height, width, channels]() {
+        if (offset) {
+          result.emplace(std::move(*output));
+          return;
+        }
+        // Remove the batch_size dimension of a single image.
+        TensorMetadata output_metadata(GetDType<T>(),
+                                       {height, width, channels});
+        result.emplace(output_metadata, output->ReleaseBuffer());
+      });
+
+  return result;
+}
+
+// Returns the largest DCT scaling denominator supported by libjpeg, that still
+// decodes an image of `image_height` x `image_width` pixels to at least
+// `height` x `width` pixels, so that the following bilinear resize only ever
+// downscales.
+static int ComputeJpegScalingRatio(int image_height, int image_width,
+                                   int64_t height, int64_t width) {
+  for (int ratio : {8, 4, 2}) {
+    // libjpeg rounds the scaled dimensions up.
+    if ((image_height + ratio - 1) / ratio >= height &&
+        (image_width + ratio - 1) / ratio >= width) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+// Decodes a jpeg image with 3 channels into the buffer returned by `allocate`,
+// scaling it down in the DCT domain as much as possible while keeping the
+// central `central_fraction` of the image at least `height` x `width` pixels
+// large.
+static Error DecodeJpegScaled(
+    string_view data, float central_fraction, int64_t height, int64_t width,
+    std::function<uint8_t*(int, int, int)> allocate) {
+  if (!data.startswith("\xff\xd8\xff")) {
+    return MakeStringError("image does not have jpeg format");
+  }
+
+  int image_height, image_width;
+  if (!jpeg::GetImageInfo(data.data(), data.size(), &image_width,
+                          &image_height, /*components=*/nullptr)) {
+    return MakeStringError("failed to read jpeg header");
+  }
+
+  jpeg::UncompressFlags flags;
+  flags.components = 3;
+  flags.dct_method = JDCT_IFAST;
+  flags.ratio = ComputeJpegScalingRatio(
+      static_cast<int>(image_height * central_fraction),
+      static_cast<int>(image_width * central_fraction), height, width);
+
+  uint8_t* decoded = jpeg::Uncompress(data.data(), data.size(), flags,
+                                      nullptr /* nwarn */, std::move(allocate));
+  if (!decoded) {
+    return MakeStringError("failed to decode jpeg image");
+  }
+  return Error::success();
+}
+
+// Decodes a jpeg image into a uint8 tensor with 3 channels, scaling it down in
+// the DCT domain as much as possible while keeping it at least `height` x
+// `width` pixels large.
+static llvm::Expected<DenseHostTensor> DecodeJpegForResize(string_view data,
+                                                           int64_t height,
+                                                           int64_t width,
+                                                           HostContext* host) {
+  llvm::Optional<DenseHostTensor> image;
+  if (auto error = DecodeJpegScaled(
+          data, /*central_fraction=*/1.0f, height, width,
+          [&image, host](int scaled_width, int scaled_height,
+                         int channels) -> uint8_t* {
+            image = DenseHostTensor::CreateUninitialized<uint8_t>(
+                TensorShape({scaled_height, scaled_width, channels}), host);
+            if (!image) return nullptr;
+            return static_cast<uint8_t*>(image->data());
+          })) {
+    return std::move(error);
+  }
+  return std::move(*image);
+}
+
+// Resizes a decoded [height, width, 3] uint8 `image` into the float `output`
+// of shape [1, output_height, output_width, 3].
+static void ResizeDecodedImage(const DenseHostTensor& image,
+                               DenseHostTensor& output) {
+  const TensorShape& image_shape = image.shape();
+  const TensorShape& output_shape = output.shape();
+  float height_scale = image_shape.GetDimensionSize(0) /
+                       static_cast<float>(output_shape.GetDimensionSize(1));
+  float width_scale = image_shape.GetDimensionSize(1) /
+                      static_cast<float>(output_shape.GetDimensionSize(2));
+  resize_image(image, height_scale, width_scale, output);
+}
+
+// Returns tf.compat.v1.image.resize(tf.image.decode_jpeg(data, channels=3),
+// [height, width]), except that the image is first scaled down by libjpeg in
+// the DCT domain, which skips most of the decoding work for large images.
+static llvm::Expected<DenseHostTensor> DecodeAndResizeJpeg(
+    const std::string& data, int64_t height, int64_t width,
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  auto image = DecodeJpegForResize(data, height, width, host);
+  if (!image) return image.takeError();
+
+  auto dht = DenseHostTensor::CreateUninitialized<float>(
+      TensorShape({1, height, width, 3}), host);
   if (!dht) {
     return MakeStringError("cannot allocate tensor");
   }
-  resize_image(input, height_scale, width_scale, *dht);
+  ResizeDecodedImage(*image, *dht);
 
   // Remove the batch_size dimension before returning the result.
-  TensorMetadata output_metadata(GetDType<float>(), {height, width, channels});
-  DenseHostTensor output(output_metadata, dht->ReleaseBuffer());
+  TensorMetadata output_metadata(GetDType<float>(), {height, width, 3});
+  return DenseHostTensor(output_metadata, dht->ReleaseBuffer());
+}
+
+// Returns a [1, height, width, channels] tensor that aliases the `index`-th
+// image of the float NHWC `batch` tensor.
+static DenseHostTensor GetImageOfBatch(const DenseHostTensor& batch,
+                                       ssize_t index) {
+  const TensorShape& shape = batch.shape();
+  const ssize_t height = shape.GetDimensionSize(1);
+  const ssize_t width = shape.GetDimensionSize(2);
+  const ssize_t channels = shape.GetDimensionSize(3);
+  const size_t size = height * width * channels * sizeof(float);
 
-  return output;
+  char* data = static_cast<char*>(const_cast<void*>(batch.data()));
+  auto buffer = HostBuffer::CreateFromExternal(
+      data + index * size, size,
+      [parent = batch.buffer().CopyRef()](void*, size_t) {});
+  return DenseHostTensor(
+      TensorMetadata(GetDType<float>(), {1, height, width, channels}),
+      std::move(buffer));
+}
+
+// Decodes and resizes a 1-D StringHostTensor of jpeg images into a float
+// tensor of shape [batch_size, height, width, 3]. Images are decoded in
+// parallel, each one directly into its slice of the preallocated batch.
+static AsyncValueRef<DenseHostTensor> DecodeAndResizeJpegBatch(
+    Argument<StringHostTensor> images, int64_t height, int64_t width,
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  if (images->shape().GetRank() != 1) {
+    return EmitErrorAsync(exec_ctx, "images must be a 1-D tensor");
+  }
+  const ssize_t batch_size = images->shape().GetDimensionSize(0);
+
+  auto batch = DenseHostTensor::CreateUninitialized<float>(
+      TensorShape({batch_size, height, width, 3}), host);
+  if (!batch) {
+    return EmitErrorAsync(exec_ctx, "cannot allocate tensor");
+  }
+
+  struct BatchContext {
+    BatchContext(AsyncValueRef<StringHostTensor> images, DenseHostTensor batch)
+        : images(std::move(images)), batch(std::move(batch)) {}
+
+    AsyncValueRef<StringHostTensor> images;
+    DenseHostTensor batch;
+    mutex mu;
+    // The first error encountered while decoding the batch.
+    llvm::Optional<std::string> error TFRT_GUARDED_BY(mu);
+  };
+  auto ctx =
+      std::make_unique<BatchContext>(images.ValueRef(), std::move(*batch));
+
+  auto result = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  auto* ctx_ptr = ctx.get();
+  ParallelFor(host).Execute(
+      batch_size, ParallelFor::BlockSizes::Min(1),
+      [ctx_ptr, height, width, host](size_t begin, size_t end) {
+        ArrayRef<std::string> images = ctx_ptr->images->strings();
+        for (size_t i = begin; i < end; ++i) {
+          auto image = DecodeJpegForResize(images[i], height, width, host);
+          if (!image) {
+            mutex_lock lock(ctx_ptr->mu);
+            if (!ctx_ptr->error) {
+              ctx_ptr->error = StrCat("failed to process image ", i, ": ",
+                                      toString(image.takeError()));
+            } else {
+              llvm::consumeError(image.takeError());
+            }
+            return;
+          }
+          DenseHostTensor output = GetImageOfBatch(ctx_ptr->batch, i);
+          ResizeDecodedImage(*image, output);
+        }
+      },
+      [ctx = std::move(ctx), result = result.CopyRef(), exec_ctx]() {
+        mutex_lock lock(ctx->mu);
+        if (ctx->error) {
+          result.SetError(EmitError(exec_ctx, *ctx->error));
+          return;
+        }
+        result.emplace(std::move(ctx->batch));
+      });
+
+  return result;
+}
+
+// Returns a float tensor of shape [batch_size, height, width, 3] with
+//
+//   (tf.compat.v1.image.resize(
+//        tf.image.central_crop(tf.image.decode_jpeg(data, channels=3),
+//                              central_fraction),
+//        [height, width]) - mean) / stddev
+//
+// for every jpeg image of the 1-D StringHostTensor `images`. `mean` and
+// `stddev` hold one value per channel, or are empty to skip normalization.
+//
+// All steps are fused: each image is decoded (scaled down in the DCT domain)
+// into a scratch buffer that is reused by the images of the same task, and
+// the crop window is resized, normalized and written to the batch output in a
+// single pass, without materializing any intermediate tensor.
+static AsyncValueRef<DenseHostTensor> PreprocessJpegBatch(
+    Argument<StringHostTensor> images, int64_t height, int64_t width,
+    Attribute<float> central_fraction, ArrayAttribute<float> mean,
+    ArrayAttribute<float> stddev, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  if (images->shape().GetRank() != 1) {
+    return EmitErrorAsync(exec_ctx, "images must be a 1-D tensor");
+  }
+  if (*central_fraction <= 0.0f || *central_fraction > 1.0f) {
+    return EmitErrorAsync(exec_ctx, "central_fraction must be in (0, 1]");
+  }
+  if ((mean.size() != 0 && mean.size() != 3) || stddev.size() != mean.size()) {
+    return EmitErrorAsync(
+        exec_ctx, "mean and stddev must both have 3 values or be empty");
+  }
+  for (float s : stddev.data()) {
+    if (s == 0.0f) return EmitErrorAsync(exec_ctx, "stddev must be non-zero");
+  }
+  const ssize_t batch_size = images->shape().GetDimensionSize(0);
+
+  auto batch = DenseHostTensor::CreateUninitialized<float>(
+      TensorShape({batch_size, height, width, 3}), host);
+  if (!batch) {
+    return EmitErrorAsync(exec_ctx, "cannot allocate tensor");
+  }
+
+  struct PreprocessContext {
+    PreprocessContext(AsyncValueRef<StringHostTensor> images,
+                      DenseHostTensor batch, ArrayRef<float> mean,
+                      ArrayRef<float> stddev)
+        : images(std::move(images)),
+          batch(std::move(batch)),
+          mean(mean.begin(), mean.end()),
+          stddev(stddev.begin(), stddev.end()) {}
+
+    AsyncValueRef<StringHostTensor> images;
+    DenseHostTensor batch;
+    SmallVector<float, 3> mean;
+    SmallVector<float, 3> stddev;
+    mutex mu;
+    // The first error encountered while preprocessing the batch.
+    llvm::Optional<std::string> error TFRT_GUARDED_BY(mu);
+  };
+  auto ctx = std::make_unique<PreprocessContext>(
+      images.ValueRef(), std::move(*batch), mean.data(), stddev.data());
+
+  auto result = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  auto* ctx_ptr = ctx.get();
+  const float fraction = *central_fraction;
+  ParallelFor(host).Execute(
+      batch_size, ParallelFor::BlockSizes::Min(1),
+      [ctx_ptr, height, width, fraction](size_t begin, size_t end) {
+        ArrayRef<std::string> images = ctx_ptr->images->strings();
+        float* output = static_cast<float*>(ctx_ptr->batch.data());
+        const ssize_t image_size = height * width * 3;
+
+        std::vector<uint8_t> scratch;
+        for (size_t i = begin; i < end; ++i) {
+          int scaled_height = 0, scaled_width = 0;
+          auto error = DecodeJpegScaled(
+              images[i], fraction, height, width,
+              [&](int w, int h, int channels) -> uint8_t* {
+                scaled_height = h;
+                scaled_width = w;
+                scratch.resize(static_cast<size_t>(h) * w * channels);
+                return scratch.data();
+              });
+          if (error) {
+            mutex_lock lock(ctx_ptr->mu);
+            if (!ctx_ptr->error) {
+              ctx_ptr->error = StrCat("failed to process image ", i, ": ",
+                                      toString(std::move(error)));
+            } else {
+              llvm::consumeError(std::move(error));
+            }
+            return;
+          }
+
+          // Same crop window as tf.image.central_crop.
+          const int crop_y =
+              static_cast<int>((scaled_height - scaled_height * fraction) / 2);
+          const int crop_x =
+              static_cast<int>((scaled_width - scaled_width * fraction) / 2);
+          const ssize_t row_stride = scaled_width * 3;
+          ResizeAndNormalizeImage(
+              scratch.data() + crop_y * row_stride + crop_x * 3,
+              scaled_height - 2 * crop_y, scaled_width - 2 * crop_x,
+              /*channels=*/3, row_stride, height, width, ctx_ptr->mean,
+              ctx_ptr->stddev, output + i * image_size);
+        }
+      },
+      [ctx = std::move(ctx), result = result.CopyRef(), exec_ctx]() {
+        mutex_lock lock(ctx->mu);
+        if (ctx->error) {
+          result.SetError(EmitError(exec_ctx, *ctx->error));
+          return;
+        }
+        result.emplace(std::move(ctx->batch));
+      });
+
+  return result;
 }
 
 // This is the entrypoint to the library.
 void RegisterImageKernels(KernelRegistry* registry) {
   registry->AddKernel("image.decode_jpeg", TFRT_KERNEL(DecodeJpeg));
-  registry->AddKernel("image.resize_bilinear", TFRT_KERNEL(ResizeBilinear));
+  registry->AddKernel("image.resize_bilinear",
+                      TFRT_KERNEL(ResizeBilinear<float>));
+  registry->AddKernel("image.resize_bilinear.ui8",
+                      TFRT_KERNEL(ResizeBilinear<uint8_t>));
+  registry->AddKernel("image.decode_and_resize_jpeg",
+                      TFRT_KERNEL(DecodeAndResizeJpeg));
+  registry->AddKernel("image.decode_and_resize_jpeg_batch",
+                      TFRT_KERNEL(DecodeAndResizeJpegBatch));
+  registry->AddKernel("image.preprocess_jpeg_batch",
+                      TFRT_KERNEL(PreprocessJpegBatch));
 }
 
 }  // namespace image
@@ -90,6 +90,12 @@ uint8_t* Uncompress(const void* srcdata, int datasize,
                     const UncompressFlags& flags, int64_t* nwarn,
                     std::function<uint8_t*(int, int, int)> allocate_output);
 
+// Reads the JPEG header of `srcdata` and returns the full resolution width,
+// height and number of components of the image, without decoding it. Any of
+// the output pointers may be null. Returns false if the header is invalid.
+bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
+                  int* components);
+
 }  // namespace jpeg
 }  // namespace image
 }  // namespace tfrt
@@ -16,27 +16,52 @@
 //
 // This file declaress the functions to resize image.
 //
+// Resizing is done in two separable passes. The horizontal pass interpolates
+// the two input rows that contribute to an output row along the width, and
+// the vertical pass blends the two horizontally interpolated rows. Both passes
+// use precomputed fixed-point interpolation tables, and the vertical pass,
+// which works on contiguous rows, is vectorized with AVX2 or NEON.
+//
 //===----------------------------------------------------------------------===//
 
 #include "resize_bilinear_op.h"
 
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "tfrt/host_context/parallel_for.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace tfrt {
 namespace image {
 namespace {
 
+// Interpolation weights are fixed-point numbers with kWeightBits fractional
+// bits. Horizontally interpolated values have kWeightBits fractional bits and
+// fit into int32 (255 << 11), and so do the vertically interpolated values
+// with 2 * kWeightBits fractional bits (255 << 22).
+constexpr int kWeightBits = 11;
+constexpr int32_t kWeightOne = 1 << kWeightBits;
+constexpr int kResultBits = 2 * kWeightBits;
+
 struct CachedInterpolation {
   ssize_t lower;  // Lower source index used in the interpolation
   ssize_t upper;  // Upper source index used in the interpolation
   // 1-D linear iterpolation scale (see:
-  // https://en.wikipedia.org/wiki/Bilinear_interpolation)
-  float lerp;
+  // https://en.wikipedia.org/wiki/Bilinear_interpolation) in fixed point.
+  int32_t lerp;
 };
 
 void compute_interpolation_weights(const ssize_t out_size,
                                    const ssize_t in_size, const float scale,
                                    CachedInterpolation* interpolation) {
-  interpolation[out_size].lower = 0;
-  interpolation[out_size].upper = 0;
   for (ssize_t i = out_size - 1; i >= 0; --i) {
     const float in = static_cast<float>(i) * scale;
     const float in_f = std::floor(in);
@@ -44,97 +69,311 @@ void compute_interpolation_weights(const ssize_t out_size,
         std::max(static_cast<ssize_t>(in_f), static_cast<ssize_t>(0));
     interpolation[i].upper =
         std::min(static_cast<ssize_t>(std::ceil(in)), in_size - 1);
-    interpolation[i].lerp = in - in_f;
+    interpolation[i].lerp =
+        static_cast<int32_t>(std::lround((in - in_f) * kWeightOne));
   }
 }
 
-float compute_lerp(const float top_left, const float top_right,
-                   const float bottom_left, const float bottom_right,
-                   const float x_lerp, const float y_lerp) {
-  const float top = top_left + (top_right - top_left) * x_lerp;
-  const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
-  return top + (bottom - top) * y_lerp;
+// Interpolation tables and shapes shared by all the resized rows.
+struct ResizeContext {
+  ResizeContext(const DenseHostTensor& input, const float height_scale,
+                const float width_scale, DenseHostTensor& output)
+      : input_data(static_cast<const uint8_t*>(input.data())),
+        output_data(output.data()),
+        output_dtype(output.dtype().kind()) {
+    const TensorShape& input_shape = input.shape();
+    const int offset = input_shape.GetRank() == 4 ? 1 : 0;
+    batch_size = offset ? input_shape.GetDimensionSize(0) : 1;
+    input_height = input_shape.GetDimensionSize(offset + 0);
+    input_width = input_shape.GetDimensionSize(offset + 1);
+    channels = input_shape.GetDimensionSize(offset + 2);
+    input_row_stride = input_width * channels;
+    input_image_stride = input_height * input_row_stride;
+
+    const TensorShape& output_shape = output.shape();
+    output_height = output_shape.GetDimensionSize(1);
+    output_width = output_shape.GetDimensionSize(2);
+
+    Initialize(height_scale, width_scale, /*mean=*/{}, /*stddev=*/{});
+  }
+
+  ResizeContext(const uint8_t* input, ssize_t input_height,
+                ssize_t input_width, ssize_t channels,
+                ssize_t input_row_stride, ssize_t output_height,
+                ssize_t output_width, ArrayRef<float> mean,
+                ArrayRef<float> stddev, float* output)
+      : input_data(input),
+        output_data(output),
+        output_dtype(DType::F32),
+        batch_size(1),
+        input_height(input_height),
+        input_width(input_width),
+        channels(channels),
+        input_row_stride(input_row_stride),
+        input_image_stride(input_height * input_row_stride),
+        output_height(output_height),
+        output_width(output_width) {
+    Initialize(input_height / static_cast<float>(output_height),
+               input_width / static_cast<float>(output_width), mean, stddev);
+  }
+
+  void Initialize(const float height_scale, const float width_scale,
+                  ArrayRef<float> mean, ArrayRef<float> stddev) {
+    ys.resize(output_height);
+    xs.resize(output_width);
+    compute_interpolation_weights(output_height, input_height, height_scale,
+                                  ys.data());
+    compute_interpolation_weights(output_width, input_width, width_scale,
+                                  xs.data());
+
+    // Scale x interpolation weights to avoid a multiplication during
+    // iteration.
+    for (auto& x : xs) {
+      x.lower *= channels;
+      x.upper *= channels;
+    }
+
+    if (output_dtype != DType::F32) return;
+
+    // Float outputs are computed as value * scale + bias, which converts the
+    // fixed-point values back to the 0-255 range and, if requested, applies
+    // the per-channel (value - mean) / stddev normalization in the same pass.
+    const ssize_t row_size = output_width * channels;
+    scales.resize(row_size);
+    biases.resize(row_size);
+    for (ssize_t i = 0; i < row_size; ++i) {
+      const ssize_t c = i % channels;
+      const float m = mean.empty() ? 0.0f : mean[c];
+      const float s = stddev.empty() ? 1.0f : stddev[c];
+      scales[i] = 1.0f / (s * (1 << kResultBits));
+      biases[i] = -m / s;
+    }
+  }
+
+  const uint8_t* input_data;
+  void* output_data;
+  DType::Kind output_dtype;
+
+  ssize_t batch_size;
+  ssize_t input_height;
+  ssize_t input_width;
+  ssize_t channels;
+  // Distances in elements between the starts of consecutive input rows and
+  // images. Rows can be longer than input_width * channels when the input is
+  // a crop window of a larger image.
+  ssize_t input_row_stride;
+  ssize_t input_image_stride;
+  ssize_t output_height;
+  ssize_t output_width;
+
+  std::vector<CachedInterpolation> ys;
+  std::vector<CachedInterpolation> xs;
+  std::vector<float> scales;
+  std::vector<float> biases;
+};
+
+// Interpolates the `input` row along the width into `output`.
+void InterpolateRow(const uint8_t* input, ArrayRef<CachedInterpolation> xs,
+                    ssize_t channels, int32_t* output) {
+  if (channels == 3) {
+    for (const CachedInterpolation& x : xs) {
+      const int32_t upper_weight = x.lerp;
+      const int32_t lower_weight = kWeightOne - x.lerp;
+      const uint8_t* lower = input + x.lower;
+      const uint8_t* upper = input + x.upper;
+      output[0] = lower[0] * lower_weight + upper[0] * upper_weight;
+      output[1] = lower[1] * lower_weight + upper[1] * upper_weight;
+      output[2] = lower[2] * lower_weight + upper[2] * upper_weight;
+      output += 3;
+    }
+    return;
+  }
+
+  for (const CachedInterpolation& x : xs) {
+    const int32_t upper_weight = x.lerp;
+    const int32_t lower_weight = kWeightOne - x.lerp;
+    for (ssize_t c = 0; c < channels; ++c) {
+      *output++ = input[x.lower + c] * lower_weight +
+                  input[x.upper + c] * upper_weight;
+    }
+  }
 }
-}  // namespace
 
-void resize_image(const DenseHostTensor& input, const float height_scale,
-                  const float width_scale, DenseHostTensor& output) {
-  const TensorShape& input_shape = input.shape();
-  ssize_t batch_size = 1;
-  ssize_t input_height = input_shape.GetDimensionSize(0);
-  ssize_t input_width = input_shape.GetDimensionSize(1);
-  ssize_t channels = input_shape.GetDimensionSize(2);
-
-  const TensorShape& output_shape = output.shape();
-  ssize_t output_height = output_shape.GetDimensionSize(1);
-  ssize_t output_width = output_shape.GetDimensionSize(2);
-
-  std::vector<CachedInterpolation> ys(output_height + 1);
-  std::vector<CachedInterpolation> xs(output_width + 1);
-
-  compute_interpolation_weights(output_height, input_height, height_scale,
-                                ys.data());
-  compute_interpolation_weights(output_width, input_width, width_scale,
-                                xs.data());
-
-  // Scale x interpolation weights to avoid a multiplication during iteration.
-  for (int i = 0; i < xs.size(); ++i) {
-    xs[i].lower *= channels;
-    xs[i].upper *= channels;
+inline void StoreResult(int32_t value, float scale, float bias,
+                        float* output) {
+  *output = value * scale + bias;
+}
+
+inline void StoreResult(int32_t value, float scale, float bias,
+                        uint8_t* output) {
+  *output = static_cast<uint8_t>((value + (1 << (kResultBits - 1))) >>
+                                 kResultBits);
+}
+
+// Blends the horizontally interpolated rows `top` and `bottom` of `size`
+// values with the vertical weight `lerp` into `output`. Float outputs are
+// scaled by `scales` and offset by `biases`, which are ignored for uint8.
+template <typename T>
+void InterpolateColumns(const int32_t* top, const int32_t* bottom,
+                        int32_t lerp, ssize_t size, const float* scales,
+                        const float* biases, T* output) {
+  const int32_t bottom_weight = lerp;
+  const int32_t top_weight = kWeightOne - lerp;
+  ssize_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256i top_weights = _mm256_set1_epi32(top_weight);
+  const __m256i bottom_weights = _mm256_set1_epi32(bottom_weight);
+  for (; i + 8 <= size; i += 8) {
+    const __m256i t =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + i));
+    const __m256i v = _mm256_add_epi32(_mm256_mullo_epi32(t, top_weights),
+                                       _mm256_mullo_epi32(b, bottom_weights));
+    if (std::is_same<T, float>::value) {
+      const __m256 result =
+          _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(v),
+                                      _mm256_loadu_ps(scales + i)),
+                        _mm256_loadu_ps(biases + i));
+      _mm256_storeu_ps(reinterpret_cast<float*>(output + i), result);
+    } else {
+      const __m256i rounded = _mm256_srai_epi32(
+          _mm256_add_epi32(v, _mm256_set1_epi32(1 << (kResultBits - 1))),
+          kResultBits);
+      const __m128i packed16 =
+          _mm_packs_epi32(_mm256_castsi256_si128(rounded),
+                          _mm256_extracti128_si256(rounded, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i),
+                       _mm_packus_epi16(packed16, packed16));
+    }
+  }
+#elif defined(__ARM_NEON)
+  const int32x4_t top_weights = vdupq_n_s32(top_weight);
+  const int32x4_t bottom_weights = vdupq_n_s32(bottom_weight);
+  for (; i + 8 <= size; i += 8) {
+    int32x4_t lo = vmulq_s32(vld1q_s32(top + i), top_weights);
+    int32x4_t hi = vmulq_s32(vld1q_s32(top + i + 4), top_weights);
+    lo = vmlaq_s32(lo, vld1q_s32(bottom + i), bottom_weights);
+    hi = vmlaq_s32(hi, vld1q_s32(bottom + i + 4), bottom_weights);
+    if (std::is_same<T, float>::value) {
+      float* out = reinterpret_cast<float*>(output + i);
+      vst1q_f32(out, vmlaq_f32(vld1q_f32(biases + i), vcvtq_f32_s32(lo),
+                               vld1q_f32(scales + i)));
+      vst1q_f32(out + 4,
+                vmlaq_f32(vld1q_f32(biases + i + 4), vcvtq_f32_s32(hi),
+                          vld1q_f32(scales + i + 4)));
+    } else {
+      const int16x8_t packed16 =
+          vcombine_s16(vmovn_s32(vrshrq_n_s32(lo, kResultBits)),
+                       vmovn_s32(vrshrq_n_s32(hi, kResultBits)));
+      vst1_u8(reinterpret_cast<uint8_t*>(output + i),
+              vqmovun_s16(packed16));
+    }
   }
+#endif
 
-  const ssize_t in_row_size = input_width * channels;
-  const ssize_t in_batch_num_values = input_height * in_row_size;
-  const ssize_t out_row_size = output_width * channels;
-  const uint8_t* input_b_ptr = static_cast<const uint8_t*>(input.data());
-  float* output_y_ptr = static_cast<float*>(output.data());
-
-  for (int b = 0; b < batch_size; ++b) {
-    for (ssize_t y = 0; y < output_height; ++y) {
-      const uint8_t* ys_input_lower_ptr =
-          input_b_ptr + ys[y].lower * in_row_size;
-      const uint8_t* ys_input_upper_ptr =
-          input_b_ptr + ys[y].upper * in_row_size;
-      const float ys_lerp = ys[y].lerp;
-      for (ssize_t x = 0; x < output_width; ++x) {
-        const ssize_t xs_lower = xs[x].lower;
-        const ssize_t xs_upper = xs[x].upper;
-        const float xs_lerp = xs[x].lerp;
-
-        // Read channel 0.
-        const float top_left0(ys_input_lower_ptr[xs_lower + 0]);
-        const float top_right0(ys_input_lower_ptr[xs_upper + 0]);
-        const float bottom_left0(ys_input_upper_ptr[xs_lower + 0]);
-        const float bottom_right0(ys_input_upper_ptr[xs_upper + 0]);
-
-        // Read channel 1.
-        const float top_left1(ys_input_lower_ptr[xs_lower + 1]);
-        const float top_right1(ys_input_lower_ptr[xs_upper + 1]);
-        const float bottom_left1(ys_input_upper_ptr[xs_lower + 1]);
-        const float bottom_right1(ys_input_upper_ptr[xs_upper + 1]);
-
-        // Read channel 2.
-        const float top_left2(ys_input_lower_ptr[xs_lower + 2]);
-        const float top_right2(ys_input_lower_ptr[xs_upper + 2]);
-        const float bottom_left2(ys_input_upper_ptr[xs_lower + 2]);
-        const float bottom_right2(ys_input_upper_ptr[xs_upper + 2]);
-
-        // Compute output.
-        output_y_ptr[x * channels + 0] =
-            compute_lerp(top_left0, top_right0, bottom_left0, bottom_right0,
-                         xs_lerp, ys_lerp);
-        output_y_ptr[x * channels + 1] =
-            compute_lerp(top_left1, top_right1, bottom_left1, bottom_right1,
-                         xs_lerp, ys_lerp);
-        output_y_ptr[x * channels + 2] =
-            compute_lerp(top_left2, top_right2, bottom_left2, bottom_right2,
-                         xs_lerp, ys_lerp);
-      }
-      output_y_ptr += out_row_size;
+  for (; i < size; ++i) {
+    const int32_t value = top[i] * top_weight + bottom[i] * bottom_weight;
+    if (std::is_same<T, float>::value) {
+      StoreResult(value, scales[i], biases[i], output + i);
+    } else {
+      StoreResult(value, 0.0f, 0.0f, output + i);
     }
-    input_b_ptr += in_batch_num_values;
   }
 }
 
+// Resizes the output rows [begin, end), where rows are numbered across all
+// the images of the batch.
+template <typename T>
+void ResizeRows(const ResizeContext& ctx, ssize_t begin, ssize_t end) {
+  const ssize_t out_row_size = ctx.output_width * ctx.channels;
+  const uint8_t* input = ctx.input_data;
+  T* output = static_cast<T*>(ctx.output_data);
+
+  // Horizontally interpolated input rows. Consecutive output rows often use
+  // the same input rows, so the last two interpolated rows are cached.
+  std::vector<int32_t> rows[2] = {std::vector<int32_t>(out_row_size),
+                                  std::vector<int32_t>(out_row_size)};
+  ssize_t cached_rows[2] = {-1, -1};
+  int next_slot = 0;
+
+  auto get_row = [&](ssize_t row) -> const int32_t* {
+    for (int slot = 0; slot < 2; ++slot) {
+      if (cached_rows[slot] == row) return rows[slot].data();
+    }
+    const int slot = next_slot;
+    next_slot ^= 1;
+    const ssize_t b = row / ctx.input_height;
+    const ssize_t y = row % ctx.input_height;
+    InterpolateRow(
+        input + b * ctx.input_image_stride + y * ctx.input_row_stride,
+        ctx.xs, ctx.channels, rows[slot].data());
+    cached_rows[slot] = row;
+    return rows[slot].data();
+  };
+
+  for (ssize_t row = begin; row < end; ++row) {
+    const ssize_t b = row / ctx.output_height;
+    const CachedInterpolation& y = ctx.ys[row % ctx.output_height];
+    const int32_t* top = get_row(b * ctx.input_height + y.lower);
+    const int32_t* bottom = get_row(b * ctx.input_height + y.upper);
+    InterpolateColumns(top, bottom, y.lerp, out_row_size, ctx.scales.data(),
+                       ctx.biases.data(), output + row * out_row_size);
+  }
+}
+
+void ResizeRows(const ResizeContext& ctx, ssize_t begin, ssize_t end) {
+  if (ctx.output_dtype == DType::UI8) {
+    ResizeRows<uint8_t>(ctx, begin, end);
+  } else {
+    assert(ctx.output_dtype == DType::F32);
+    ResizeRows<float>(ctx, begin, end);
+  }
+}
+
+}  // namespace
+
+void resize_image(const DenseHostTensor& input, const float height_scale,
+                  const float width_scale, DenseHostTensor& output) {
+  ResizeContext ctx(input, height_scale, width_scale, output);
+  ResizeRows(ctx, 0, ctx.batch_size * ctx.output_height);
+}
+
+void ResizeAndNormalizeImage(const uint8_t* input, ssize_t input_height,
+                             ssize_t input_width, ssize_t channels,
+                             ssize_t input_row_stride, ssize_t output_height,
+                             ssize_t output_width, ArrayRef<float> mean,
+                             ArrayRef<float> stddev, float* output) {
+  ResizeContext ctx(input, input_height, input_width, channels,
+                    input_row_stride, output_height, output_width, mean,
+                    stddev, output);
+  ResizeRows<float>(ctx, 0, output_height);
+}
+
+void ResizeImageInParallel(const DenseHostTensor& input,
+                           const float height_scale, const float width_scale,
+                           DenseHostTensor& output, HostContext* host,
+                           llvm::unique_function<void()> on_done) {
+  auto ctx = std::make_unique<ResizeContext>(input, height_scale, width_scale,
+                                             output);
+  const ssize_t num_rows = ctx->batch_size * ctx->output_height;
+
+  // Each task resizes at least ~64KB of output values, to amortize the
+  // scheduling overhead and the horizontal interpolation of the first rows.
+  const ssize_t row_size = ctx->output_width * ctx->channels;
+  const size_t min_block_size =
+      std::max<ssize_t>(1, (64 * 1024) / std::max<ssize_t>(1, row_size));
+
+  auto* ctx_ptr = ctx.get();
+  ParallelFor(host).Execute(
+      num_rows, ParallelFor::BlockSizes::Min(min_block_size),
+      [ctx_ptr](size_t begin, size_t end) { ResizeRows(*ctx_ptr, begin, end); },
+      [ctx = std::move(ctx), on_done = std::move(on_done)]() mutable {
+        ctx.reset();
+        on_done();
+      });
+}
+
 }  // namespace image
 }  // namespace tfrt
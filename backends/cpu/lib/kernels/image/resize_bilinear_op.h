@@ -24,6 +24,7 @@
 #define TFRT_BACKENDS_CPU_LIB_KERNELS_IMAGE_RESIZE_BILINEAR_OP_H_
 
 #include "jpeg/jpeg_mem.h"
+#include "llvm/ADT/FunctionExtras.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/error_util.h"
@@ -34,9 +35,38 @@
 namespace tfrt {
 namespace image {
 
+// Resizes `input` uint8 images with bilinear interpolation into `output`,
+// following the tf.compat.v1.image.resize semantics. `input` has shape
+// [batch, height, width, channels] or [height, width, channels] (a batch of
+// one image). `output` has shape [batch, out_height, out_width, channels] and
+// dtype f32 or ui8.
+//
+// Interpolation uses fixed-point weights with 11 fractional bits, so results
+// can differ from the exact float computation by a small fraction of one
+// intensity level.
 void resize_image(const DenseHostTensor& input, const float height_scale,
                   const float width_scale, DenseHostTensor& output);
 
+// Resizes a single uint8 image of `input_height` x `input_width` pixels with
+// `channels` channels into `output` of `output_height` x `output_width`
+// pixels, and normalizes every output value v of channel c to
+// (v - mean[c]) / stddev[c]. Consecutive input rows start `input_row_stride`
+// elements apart, so `input` can be a crop window of a larger image. Empty
+// `mean` and `stddev` leave the values in the 0-255 range.
+void ResizeAndNormalizeImage(const uint8_t* input, ssize_t input_height,
+                             ssize_t input_width, ssize_t channels,
+                             ssize_t input_row_stride, ssize_t output_height,
+                             ssize_t output_width, ArrayRef<float> mean,
+                             ArrayRef<float> stddev, float* output);
+
+// Same as resize_image(), but splits the output rows into blocks that are
+// resized in parallel by the `host` worker threads. Calls `on_done` when the
+// output is ready. `input` and `output` must stay alive until then.
+void ResizeImageInParallel(const DenseHostTensor& input,
+                           const float height_scale, const float width_scale,
+                           DenseHostTensor& output, HostContext* host,
+                           llvm::unique_function<void()> on_done);
+
 }  // namespace image
 }  // namespace tfrt
 
@@ -0,0 +1,362 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- example_parser.cc --------------------------------------------------===//
+//
+// This file implements ExampleParser.
+//
+// The parsed messages are (see example.proto):
+//
+//   Example   { Features features = 1; }
+//   Features  { map<string, Feature> feature = 1; }
+//   Feature   { oneof kind { BytesList = 1; FloatList = 2; Int64List = 3; } }
+//   BytesList { repeated bytes value = 1; }
+//   FloatList { repeated float value = 1 [packed = true]; }
+//   Int64List { repeated int64 value = 1 [packed = true]; }
+//
+// Map entries are encoded as messages { string key = 1; Feature value = 2; }.
+//
+//===----------------------------------------------------------------------===//
+
+#include "example_parser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/support/error_util.h"
+
+namespace tfrt {
+namespace proto {
+
+namespace {
+
+enum class WireType : uint32_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5,
+};
+
+// WireReader reads protobuf wire format primitives from a byte buffer. All
+// methods return false if the buffer is truncated or malformed.
+class WireReader {
+ public:
+  explicit WireReader(string_view data)
+      : ptr_(data.bytes_begin()), end_(data.bytes_end()) {}
+
+  bool empty() const { return ptr_ == end_; }
+
+  bool ReadVarint(uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && ptr_ < end_; shift += 7) {
+      const uint8_t byte = *ptr_++;
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadTag(uint32_t* field, WireType* wire_type) {
+    uint64_t tag;
+    if (!ReadVarint(&tag)) return false;
+    *field = static_cast<uint32_t>(tag >> 3);
+    *wire_type = static_cast<WireType>(tag & 0x7);
+    return true;
+  }
+
+  bool ReadLengthDelimited(string_view* value) {
+    uint64_t size;
+    if (!ReadVarint(&size) || size > static_cast<uint64_t>(end_ - ptr_)) {
+      return false;
+    }
+    *value = string_view(reinterpret_cast<const char*>(ptr_), size);
+    ptr_ += size;
+    return true;
+  }
+
+  bool ReadFixed32(uint32_t* value) {
+    if (static_cast<size_t>(end_ - ptr_) < sizeof(uint32_t)) return false;
+    std::memcpy(value, ptr_, sizeof(uint32_t));
+    ptr_ += sizeof(uint32_t);
+    return true;
+  }
+
+  bool Skip(WireType wire_type) {
+    switch (wire_type) {
+      case WireType::kVarint: {
+        uint64_t value;
+        return ReadVarint(&value);
+      }
+      case WireType::kFixed64:
+        return Advance(sizeof(uint64_t));
+      case WireType::kLengthDelimited: {
+        string_view value;
+        return ReadLengthDelimited(&value);
+      }
+      case WireType::kFixed32:
+        return Advance(sizeof(uint32_t));
+    }
+    // Groups are not used by example.proto.
+    return false;
+  }
+
+ private:
+  bool Advance(size_t n) {
+    if (static_cast<size_t>(end_ - ptr_) < n) return false;
+    ptr_ += n;
+    return true;
+  }
+
+  const uint8_t* ptr_;
+  const uint8_t* end_;
+};
+
+Error MalformedRecordError() {
+  return MakeStringError("failed to parse example.proto from string");
+}
+
+string_view FeatureKindName(FeatureKind kind) {
+  switch (kind) {
+    case FeatureKind::kBytes:
+      return "bytes";
+    case FeatureKind::kFloat:
+      return "float";
+    case FeatureKind::kInt64:
+      return "int64";
+  }
+  llvm_unreachable("unknown feature kind");
+}
+
+// Decodes the values of a BytesList, FloatList or Int64List `list` into row
+// `row` of `buffer`, and returns the number of decoded values in
+// `num_values`. Values beyond the spec size are counted but not stored.
+bool ParseValueList(string_view list, const FeatureSpec& spec, size_t row,
+                    const FeatureBuffer& buffer, int64_t* num_values) {
+  const int64_t capacity = spec.num_values;
+  const size_t offset = row * capacity;
+  int64_t count = 0;
+
+  WireReader reader(list);
+  while (!reader.empty()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) return false;
+    if (field != 1) {
+      if (!reader.Skip(wire_type)) return false;
+      continue;
+    }
+
+    switch (spec.kind) {
+      case FeatureKind::kBytes: {
+        string_view value;
+        if (wire_type != WireType::kLengthDelimited ||
+            !reader.ReadLengthDelimited(&value)) {
+          return false;
+        }
+        if (count < capacity) {
+          buffer.bytes_values[offset + count].assign(value.data(),
+                                                     value.size());
+        }
+        ++count;
+        break;
+      }
+      case FeatureKind::kFloat: {
+        if (wire_type == WireType::kFixed32) {
+          uint32_t bits;
+          if (!reader.ReadFixed32(&bits)) return false;
+          if (count < capacity) {
+            std::memcpy(&buffer.float_values[offset + count], &bits,
+                        sizeof(float));
+          }
+          ++count;
+          break;
+        }
+        // Packed floats are stored as a contiguous little-endian array.
+        string_view packed;
+        if (wire_type != WireType::kLengthDelimited ||
+            !reader.ReadLengthDelimited(&packed) ||
+            packed.size() % sizeof(float) != 0) {
+          return false;
+        }
+        const int64_t num_packed = packed.size() / sizeof(float);
+        const int64_t num_stored =
+            std::max<int64_t>(0, std::min(num_packed, capacity - count));
+        if (num_stored > 0) {
+          std::memcpy(&buffer.float_values[offset + count], packed.data(),
+                      num_stored * sizeof(float));
+        }
+        count += num_packed;
+        break;
+      }
+      case FeatureKind::kInt64: {
+        if (wire_type == WireType::kVarint) {
+          uint64_t value;
+          if (!reader.ReadVarint(&value)) return false;
+          if (count < capacity) {
+            buffer.int64_values[offset + count] = static_cast<int64_t>(value);
+          }
+          ++count;
+          break;
+        }
+        string_view packed;
+        if (wire_type != WireType::kLengthDelimited ||
+            !reader.ReadLengthDelimited(&packed)) {
+          return false;
+        }
+        WireReader packed_reader(packed);
+        while (!packed_reader.empty()) {
+          uint64_t value;
+          if (!packed_reader.ReadVarint(&value)) return false;
+          if (count < capacity) {
+            buffer.int64_values[offset + count] = static_cast<int64_t>(value);
+          }
+          ++count;
+        }
+        break;
+      }
+    }
+  }
+
+  *num_values = count;
+  return true;
+}
+
+}  // namespace
+
+Expected<FeatureKind> ParseFeatureKind(string_view name) {
+  if (name == "bytes") return FeatureKind::kBytes;
+  if (name == "float") return FeatureKind::kFloat;
+  if (name == "int64") return FeatureKind::kInt64;
+  return MakeStringError("unsupported feature kind ", name,
+                         ", expected bytes, float or int64");
+}
+
+ExampleParser::ExampleParser(ArrayRef<FeatureSpec> specs) : specs_(specs) {
+  for (size_t i = 0; i < specs_.size(); ++i) {
+    feature_index_[specs_[i].key] = i;
+  }
+}
+
+Error ExampleParser::Parse(string_view serialized, size_t row,
+                           ArrayRef<FeatureBuffer> buffers) const {
+  assert(buffers.size() == specs_.size());
+  SmallVector<bool, 8> found(specs_.size(), false);
+
+  // Parses a single map entry of Features. Returns false if malformed.
+  auto parse_entry = [&](string_view entry) -> Expected<bool> {
+    string_view key, feature;
+    WireReader entry_reader(entry);
+    while (!entry_reader.empty()) {
+      uint32_t field;
+      WireType wire_type;
+      if (!entry_reader.ReadTag(&field, &wire_type)) return false;
+      if (field == 1 && wire_type == WireType::kLengthDelimited) {
+        if (!entry_reader.ReadLengthDelimited(&key)) return false;
+      } else if (field == 2 && wire_type == WireType::kLengthDelimited) {
+        if (!entry_reader.ReadLengthDelimited(&feature)) return false;
+      } else if (!entry_reader.Skip(wire_type)) {
+        return false;
+      }
+    }
+
+    auto it = feature_index_.find(key);
+    if (it == feature_index_.end()) return true;
+    const size_t index = it->second;
+    const FeatureSpec& spec = specs_[index];
+
+    // A later entry with the same key overrides the previous one, as in the
+    // protobuf map semantics.
+    found[index] = true;
+    int64_t num_values = 0;
+    WireReader feature_reader(feature);
+    while (!feature_reader.empty()) {
+      uint32_t field;
+      WireType wire_type;
+      if (!feature_reader.ReadTag(&field, &wire_type)) return false;
+      if (field < 1 || field > 3 || wire_type != WireType::kLengthDelimited) {
+        if (!feature_reader.Skip(wire_type)) return false;
+        continue;
+      }
+      string_view list;
+      if (!feature_reader.ReadLengthDelimited(&list)) return false;
+      if (static_cast<FeatureKind>(field) != spec.kind) {
+        return MakeStringError(
+            "feature ", spec.key, " has kind ",
+            FeatureKindName(static_cast<FeatureKind>(field)),
+            ", but the spec expects ", FeatureKindName(spec.kind));
+      }
+      if (!ParseValueList(list, spec, row, buffers[index], &num_values)) {
+        return false;
+      }
+    }
+
+    if (num_values != spec.num_values) {
+      return MakeStringError("feature ", spec.key, " has ", num_values,
+                             " values, but the spec expects ",
+                             spec.num_values);
+    }
+    return true;
+  };
+
+  WireReader example_reader(serialized);
+  while (!example_reader.empty()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!example_reader.ReadTag(&field, &wire_type)) {
+      return MalformedRecordError();
+    }
+    if (field != 1 || wire_type != WireType::kLengthDelimited) {
+      if (!example_reader.Skip(wire_type)) return MalformedRecordError();
+      continue;
+    }
+
+    // Example.features. Repeated occurrences of a message field are merged.
+    string_view features;
+    if (!example_reader.ReadLengthDelimited(&features)) {
+      return MalformedRecordError();
+    }
+    WireReader features_reader(features);
+    while (!features_reader.empty()) {
+      if (!features_reader.ReadTag(&field, &wire_type)) {
+        return MalformedRecordError();
+      }
+      if (field != 1 || wire_type != WireType::kLengthDelimited) {
+        if (!features_reader.Skip(wire_type)) return MalformedRecordError();
+        continue;
+      }
+      string_view entry;
+      if (!features_reader.ReadLengthDelimited(&entry)) {
+        return MalformedRecordError();
+      }
+      auto parsed = parse_entry(entry);
+      if (!parsed) return parsed.takeError();
+      if (!*parsed) return MalformedRecordError();
+    }
+  }
+
+  for (size_t i = 0; i < specs_.size(); ++i) {
+    if (!found[i]) {
+      return MakeStringError("key ", specs_[i].key,
+                             " is not found in the proto");
+    }
+  }
+  return Error::success();
+}
+
+}  // namespace proto
+}  // namespace tfrt
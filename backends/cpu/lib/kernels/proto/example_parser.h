@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- example_parser.h -----------------------------------------*- C++ -*-===//
+//
+// This file declares ExampleParser, which decodes serialized
+// tfrt.proto.Example messages directly from the protobuf wire format into
+// caller provided columnar buffers, without materializing the messages.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_PROTO_EXAMPLE_PARSER_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_PROTO_EXAMPLE_PARSER_H_
+
+#include <string>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace proto {
+
+// The kind of the values of a feature, i.e. the set member of the Feature
+// oneof in example.proto.
+enum class FeatureKind { kBytes = 1, kFloat = 2, kInt64 = 3 };
+
+// Parses a feature kind from its name in example.proto: "bytes", "float" or
+// "int64".
+Expected<FeatureKind> ParseFeatureKind(string_view name);
+
+// A feature that must be present in every parsed Example with exactly
+// `num_values` values of kind `kind`.
+struct FeatureSpec {
+  std::string key;
+  FeatureKind kind;
+  int64_t num_values;
+};
+
+// Row-major output buffer of a feature with `num_values` columns. Only the
+// member that corresponds to the kind of the feature is used.
+struct FeatureBuffer {
+  std::string* bytes_values = nullptr;
+  float* float_values = nullptr;
+  int64_t* int64_values = nullptr;
+};
+
+// ExampleParser decodes the features listed in a fixed feature spec from
+// serialized Examples. Features that are not in the spec are skipped without
+// being decoded. Parse() is thread safe, so a single parser can be shared by
+// concurrent tasks that parse different records of a batch.
+class ExampleParser {
+ public:
+  explicit ExampleParser(ArrayRef<FeatureSpec> specs);
+
+  // Decodes `serialized` and writes the values of the i-th feature of the spec
+  // to row `row` of `buffers[i]`. Returns an error if the record is malformed,
+  // or if a feature is missing or does not match its spec.
+  Error Parse(string_view serialized, size_t row,
+              ArrayRef<FeatureBuffer> buffers) const;
+
+ private:
+  ArrayRef<FeatureSpec> specs_;
+  // Maps feature keys to their index in `specs_`.
+  llvm::StringMap<size_t> feature_index_;
+};
+
+}  // namespace proto
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_PROTO_EXAMPLE_PARSER_H_
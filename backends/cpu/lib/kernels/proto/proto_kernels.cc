@@ -18,10 +18,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <memory>
+#include <vector>
+
+#include "example_parser.h"
 #include "tfrt/cpu/kernels/proto/example.proto.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/string_host_tensor.h"
 
 namespace tfrt {
 namespace proto {
@@ -61,6 +69,177 @@ static llvm::Expected<int64_t> GetInt64FieldFromExample(
   return int64_list.value(0);
 }
 
+// Reads the feature spec of proto.parse_example_batch. Each element of
+// `feature_spec` is an aggregate ["key", "kind", num_values : i64], where kind
+// is one of "bytes", "float" or "int64".
+static llvm::Expected<std::vector<FeatureSpec>> ReadFeatureSpec(
+    AggregateAttr feature_spec) {
+  std::vector<FeatureSpec> specs;
+  specs.reserve(feature_spec.GetNumElements());
+  for (int i = 0, e = feature_spec.GetNumElements(); i < e; ++i) {
+    auto spec = feature_spec.GetAttributeOfType<AggregateAttr>(i);
+    if (spec.GetNumElements() != 3) {
+      return MakeStringError(
+          "feature spec must be [key, kind, num_values], but has ",
+          spec.GetNumElements(), " elements");
+    }
+    auto kind =
+        ParseFeatureKind(spec.GetAttributeOfType<StringAttr>(1).GetValue());
+    if (!kind) return kind.takeError();
+    const int64_t num_values = spec.GetAttributeOfType<I64Attr>(2).GetValue();
+    if (num_values < 0) {
+      return MakeStringError("num_values must be non-negative, but got ",
+                             num_values);
+    }
+    specs.push_back(FeatureSpec{
+        spec.GetAttributeOfType<StringAttr>(0).GetValue().str(), *kind,
+        num_values});
+  }
+  return std::move(specs);
+}
+
+namespace {
+// ParseExampleBatchContext owns the state of a batch parse that has to stay
+// alive while the records are parsed in parallel.
+struct ParseExampleBatchContext {
+  AsyncValueRef<StringHostTensor> serialized;
+  std::vector<FeatureSpec> specs;
+  std::unique_ptr<ExampleParser> parser;
+
+  // Output tensors, one per feature. Only the tensor that matches the feature
+  // kind is set.
+  SmallVector<Optional<DenseHostTensor>, 4> dense_outputs;
+  SmallVector<Optional<StringHostTensor>, 4> string_outputs;
+  std::vector<FeatureBuffer> buffers;
+
+  // The first error encountered while parsing the batch.
+  mutex mu;
+  Optional<std::string> error TFRT_GUARDED_BY(mu);
+};
+}  // namespace
+
+// Parses a 1-D StringHostTensor of serialized Example records into one
+// columnar tensor per feature of `feature_spec`. The i-th result has shape
+// [batch_size, num_values] and holds the values of the i-th feature: a
+// DenseHostTensor of i64 or f32 for int64 and float features, and a
+// StringHostTensor for bytes features. Records are decoded directly from the
+// wire format in parallel, without constructing Example messages.
+static void ParseExampleBatch(Argument<StringHostTensor> serialized,
+                              RemainingResults results,
+                              AggregateAttr feature_spec,
+                              const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  auto set_error = [&](llvm::Error error) {
+    auto diag = EmitErrorAsync(exec_ctx, std::move(error));
+    for (size_t i = 0; i < results.size(); ++i) results[i] = diag.CopyRef();
+  };
+
+  auto specs = ReadFeatureSpec(feature_spec);
+  if (!specs) return set_error(specs.takeError());
+  if (specs->size() != results.size()) {
+    return set_error(MakeStringError("feature spec has ", specs->size(),
+                                     " features, but the kernel has ",
+                                     results.size(), " results"));
+  }
+  if (serialized->shape().GetRank() != 1) {
+    return set_error(MakeStringError(
+        "serialized records must be a 1-D tensor, but got shape ",
+        serialized->shape()));
+  }
+  const ssize_t batch_size = serialized->shape().GetDimensionSize(0);
+
+  auto ctx = std::make_unique<ParseExampleBatchContext>();
+  ctx->serialized = serialized.ValueRef();
+  ctx->specs = std::move(*specs);
+  ctx->dense_outputs.resize(ctx->specs.size());
+  ctx->string_outputs.resize(ctx->specs.size());
+  ctx->buffers.resize(ctx->specs.size());
+
+  // Preallocate all output tensors, so that the parallel tasks write every
+  // record straight into its row.
+  for (size_t i = 0; i < ctx->specs.size(); ++i) {
+    const FeatureSpec& spec = ctx->specs[i];
+    const ssize_t dims[] = {batch_size, spec.num_values};
+    if (spec.kind == FeatureKind::kBytes) {
+      ctx->string_outputs[i] = StringHostTensor::CreateUninitialized(
+          TensorMetadata(DType(DType::String), dims), host);
+      if (!ctx->string_outputs[i]) {
+        return set_error(MakeStringError("failed to allocate output tensor"));
+      }
+      ctx->buffers[i].bytes_values = ctx->string_outputs[i]->strings().data();
+      continue;
+    }
+
+    const DType dtype = spec.kind == FeatureKind::kFloat ? DType(DType::F32)
+                                                         : DType(DType::I64);
+    ctx->dense_outputs[i] =
+        DenseHostTensor::CreateUninitialized(TensorMetadata(dtype, dims), host);
+    if (!ctx->dense_outputs[i]) {
+      return set_error(MakeStringError("failed to allocate output tensor"));
+    }
+    if (spec.kind == FeatureKind::kFloat) {
+      ctx->buffers[i].float_values =
+          static_cast<float*>(ctx->dense_outputs[i]->data());
+    } else {
+      ctx->buffers[i].int64_values =
+          static_cast<int64_t*>(ctx->dense_outputs[i]->data());
+    }
+  }
+  ctx->parser = std::make_unique<ExampleParser>(ctx->specs);
+
+  SmallVector<RCReference<AsyncValue>, 4> outputs;
+  for (size_t i = 0; i < ctx->specs.size(); ++i) {
+    if (ctx->specs[i].kind == FeatureKind::kBytes) {
+      outputs.push_back(results.AllocateAt<StringHostTensor>(i).CopyRef());
+    } else {
+      outputs.push_back(results.AllocateAt<DenseHostTensor>(i).CopyRef());
+    }
+  }
+
+  // Parsing a record is cheap relative to the task scheduling overhead, so
+  // each task parses a block of records.
+  static constexpr size_t kMinRecordsPerTask = 64;
+
+  auto* ctx_ptr = ctx.get();
+  ParallelFor(host).Execute(
+      batch_size, ParallelFor::BlockSizes::Min(kMinRecordsPerTask),
+      [ctx_ptr](size_t begin, size_t end) {
+        ArrayRef<std::string> records = ctx_ptr->serialized->strings();
+        for (size_t i = begin; i < end; ++i) {
+          if (auto error =
+                  ctx_ptr->parser->Parse(records[i], i, ctx_ptr->buffers)) {
+            mutex_lock lock(ctx_ptr->mu);
+            if (!ctx_ptr->error) {
+              ctx_ptr->error = StrCat("failed to parse record ", i, ": ",
+                                      toString(std::move(error)));
+            } else {
+              llvm::consumeError(std::move(error));
+            }
+            return;
+          }
+        }
+      },
+      [ctx = std::move(ctx), outputs = std::move(outputs), exec_ctx]() {
+        {
+          mutex_lock lock(ctx->mu);
+          if (ctx->error) {
+            auto diag = EmitError(exec_ctx, *ctx->error);
+            for (auto& output : outputs) output->SetError(diag);
+            return;
+          }
+        }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+          if (ctx->specs[i].kind == FeatureKind::kBytes) {
+            outputs[i]->emplace<StringHostTensor>(
+                std::move(*ctx->string_outputs[i]));
+          } else {
+            outputs[i]->emplace<DenseHostTensor>(
+                std::move(*ctx->dense_outputs[i]));
+          }
+        }
+      });
+}
+
 // This is the entrypoint to the library.
 void RegisterProtoKernels(KernelRegistry* registry) {
   registry->AddKernel("proto.parse_example_from_bytes",
@@ -69,6 +248,8 @@ void RegisterProtoKernels(KernelRegistry* registry) {
                       TFRT_KERNEL(GetBytesFieldFromExample));
   registry->AddKernel("proto.get_int64_field_from_example",
                       TFRT_KERNEL(GetInt64FieldFromExample));
+  registry->AddKernel("proto.parse_example_batch",
+                      TFRT_KERNEL(ParseExampleBatch));
 }
 
 }  // namespace proto
@@ -19,8 +19,12 @@
 //===----------------------------------------------------------------------===//
 
 #include <cmath>
+#include <utility>
 
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/common/compat/eigen/pooling.h"
+#include "tfrt/common/compat/eigen/softmax.h"
+#include "tfrt/common/compat/eigen/transpose.h"
 #include "tfrt/cpu/ops/test/cpu_ops_and_kernels.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/string_util.h"
@@ -37,7 +41,8 @@ static void MaxPool2D(ArgumentView<MutableDHTIndexableView<T, 4>> input,
                       StringAttribute padding,
                       ArrayAttribute<uint32_t> pool_size,
                       ArrayAttribute<uint32_t> strides,
-                      KernelErrorHandler handler) {
+                      KernelErrorHandler handler,
+                      const ExecutionContext& exec_ctx, KernelFrame* frame) {
   // shape_input has format (batch_size, height, width, channel_num)
   const auto& shape_input = input->FixedShape();
   // shape_output has format (batch_size, height, width, channel_num)
@@ -53,40 +58,14 @@ static void MaxPool2D(ArgumentView<MutableDHTIndexableView<T, 4>> input,
     return;
   }
 
-  // padding for upper, bottom, left and right
-  int padding_numbers[4] = {0, 0, 0, 0};
-
-  if (padding.str() == "same") {
-    int total_padding_height = pool_size[0] - strides[0];
-    if (shape_input[1] % strides[0] != 0) {
-      total_padding_height = pool_size[0] - (shape_input[1] % strides[0]);
-    }
-    int total_padding_width = pool_size[1] - strides[1];
-    if (shape_input[2] % strides[1] != 0) {
-      total_padding_width = pool_size[1] - (shape_input[2] % strides[1]);
-    }
-
-    padding_numbers[0] = static_cast<int>(total_padding_height / 2.0);
-    padding_numbers[1] = static_cast<int>(total_padding_height / 2.0 + 0.5);
-    padding_numbers[2] = static_cast<int>(total_padding_width / 2.0);
-    padding_numbers[3] = static_cast<int>(total_padding_width / 2.0 + 0.5);
-  } else if (padding.str() != "valid") {
-    handler.ReportError("MaxPool2D padding '", padding.str(),
-                        "' is not recognized");
-    return;
-  }
+  auto params = compat::ComputePool2DParams(
+      {shape_input[0], shape_input[1], shape_input[2], shape_input[3]},
+      {pool_size[0], pool_size[1]}, {strides[0], strides[1]}, padding.get());
+  TFRT_RETURN_IF_ERROR(handler, params.takeError());
 
+  const auto& expected = params->output_shape;
   typename MutableDHTIndexableView<T, 4>::FixedShapeType expected_output_shape(
-      {shape_input[0],
-       (shape_input[1] + padding_numbers[0] + padding_numbers[1] -
-        pool_size[0]) /
-               strides[0] +
-           1,
-       (shape_input[2] + padding_numbers[2] + padding_numbers[3] -
-        pool_size[1]) /
-               strides[1] +
-           1,
-       shape_input[3]});
+      {expected[0], expected[1], expected[2], expected[3]});
 
   if (shape_output != expected_output_shape) {
     handler.ReportError("MaxPool2D output shape ", shape_output,
@@ -95,28 +74,12 @@ static void MaxPool2D(ArgumentView<MutableDHTIndexableView<T, 4>> input,
     return;
   }
 
-  for (int i = 0, e = shape_output[0]; i < e; i++) {
-    for (int j = 0, e = shape_output[3]; j < e; j++) {
-      for (int k = 0, e = shape_output[1]; k < e; k++) {
-        for (int l = 0, e = shape_output[2]; l < e; l++) {
-          T value = std::numeric_limits<T>::min();
-          for (int x = 0, e = pool_size[0]; x < e; x++) {
-            for (int y = 0; y < pool_size[1]; y++) {
-              int pos_1 = k * strides[0] + x - padding_numbers[0];
-              int pos_2 = l * strides[1] + y - padding_numbers[2];
-              if (pos_1 < 0 || pos_1 >= shape_input[1] || pos_2 < 0 ||
-                  pos_2 >= shape_input[2])
-                continue;
-              value = std::max(value, input->ElementAt(i, pos_1, pos_2, j));
-            }
-          }
-          output->ElementAt(i, k, l, j) = value;
-        }
-      }
-    }
-  }
-
-  chain_out.Set(chain_in);
+  compat::AsyncPool2D<T>(
+      exec_ctx.host(), compat::PoolingType::kMax, *params, input->data(),
+      output->data(),
+      [chain = chain_out.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
 }
 
 template <typename T>
@@ -124,7 +87,8 @@ static void GlobalAveragePool(
     ArgumentView<MutableDHTIndexableView<T, 4>> input,
     ArgumentView<MutableDHTIndexableView<T, 2>> output,
     Argument<Chain> chain_in, Result<Chain> chain_out,
-    KernelErrorHandler handler) {
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx,
+    KernelFrame* frame) {
   // shape_input has format (batch_size, height, width, in_channel_num)
   const auto& shape_input = input->FixedShape();
   // shape_output has format (batch_size, in_channel_num)
@@ -140,21 +104,13 @@ static void GlobalAveragePool(
     return;
   }
 
-  for (int i = 0, e = shape_input[0]; i < e; i++) {
-    for (int j = 0, e = shape_input[3]; j < e; j++) {
-      T sum(0);
-      int count = 0;
-      for (int k = 0, e = shape_input[1]; k < e; k++) {
-        for (int l = 0, e = shape_input[2]; l < e; l++) {
-          sum += input->ElementAt(i, k, l, j);
-          count++;
-        }
-      }
-      output->ElementAt(i, j) = sum / count;
-    }
-  }
-
-  chain_out.Set(chain_in);
+  compat::AsyncGlobalAveragePool<T>(
+      exec_ctx.host(),
+      {shape_input[0], shape_input[1], shape_input[2], shape_input[3]},
+      input->data(), output->data(),
+      [chain = chain_out.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
 }
 
 template <typename T>
@@ -228,26 +184,61 @@ static void ZeroPadding(ArgumentView<MutableDHTIndexableView<T, 4>> input,
   chain_out.Set(chain_in);
 }
 
+// Returns the number of rows and columns of the tensor viewed as a matrix
+// with the innermost dimension as columns.
+static std::pair<int64_t, int64_t> InnermostDimAsColumns(
+    const TensorShape& shape) {
+  const int64_t cols =
+      shape.GetRank() == 0 ? 1 : shape.GetDimensionSize(shape.GetRank() - 1);
+  return {cols == 0 ? 0 : shape.GetNumElements() / cols, cols};
+}
+
+// Computes softmax or log-softmax in place along the innermost dimension.
+template <compat::SoftmaxType type>
 static void SoftMaxInPlace(ArgumentView<MutableDHTArrayView<float>> A,
                            Argument<Chain> in_chain, Result<Chain> out_chain,
                            KernelErrorHandler handler,
-                           const ExecutionContext& exec_ctx) {
-  float max_value = std::numeric_limits<float>::min();
-  for (const auto value : A->Elements()) {
-    max_value = std::max(max_value, value);
-  }
+                           const ExecutionContext& exec_ctx,
+                           KernelFrame* frame) {
+  const auto shape = InnermostDimAsColumns(A->Shape());
+  compat::AsyncSoftmax<float>(
+      exec_ctx.host(), type, A->data(), A->data(), shape.first, shape.second,
+      [chain = out_chain.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
+}
 
-  float sum = 0;
-  for (auto& value : A->Elements()) {
-    value = exp(value);
-    sum += value;
+// Computes the softmax cross-entropy `loss` of every row of `logits` against
+// the `labels` probabilities, and the gradient of the loss with respect to the
+// logits into `backprop`.
+static void SoftMaxCrossEntropy(
+    ArgumentView<MutableDHTArrayView<float>> logits,
+    ArgumentView<MutableDHTArrayView<float>> labels,
+    ArgumentView<MutableDHTArrayView<float>> loss,
+    ArgumentView<MutableDHTArrayView<float>> backprop, Argument<Chain> in_chain,
+    Result<Chain> out_chain, KernelErrorHandler handler,
+    const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  const auto shape = InnermostDimAsColumns(logits->Shape());
+
+  if (labels->Shape() != logits->Shape() ||
+      backprop->Shape() != logits->Shape()) {
+    handler.ReportError("SoftMaxCrossEntropy labels shape ", labels->Shape(),
+                        " and backprop shape ", backprop->Shape(),
+                        " must match the logits shape ", logits->Shape());
+    return;
   }
-
-  for (auto& value : A->Elements()) {
-    value /= sum;
+  if (loss->NumElements() != shape.first) {
+    handler.ReportError("SoftMaxCrossEntropy loss shape ", loss->Shape(),
+                        " does not match the number of rows ", shape.first);
+    return;
   }
 
-  out_chain.Set(in_chain);
+  compat::AsyncSoftmaxCrossEntropy<float>(
+      exec_ctx.host(), logits->data(), labels->data(), loss->data(),
+      backprop->data(), shape.first, shape.second,
+      [chain = out_chain.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
 }
 
 // Computes output = output - gradient * lr.
@@ -277,28 +268,62 @@ static AsyncValueRef<Chain> ElementwiseSubtractInPlace(
                                      exec_ctx);
 }
 
+// Permutes the dimensions of `input` into `output`: output dimension `i` is
+// the input dimension `perm[i]`.
 template <typename T>
-static void TensorTranspose(ArgumentView<MutableDHTIndexableView<T, 2>> input,
-                            ArgumentView<MutableDHTIndexableView<T, 2>> output,
-                            Argument<Chain> in_chain, Result<Chain> out_chain,
-                            KernelErrorHandler handler,
-                            const ExecutionContext& exec_ctx) {
-  const auto& shape_output = output->FixedShape();
-  const auto& shape_input = input->FixedShape();
-
-  if (shape_output[1] != shape_input[0] || shape_output[0] != shape_input[1]) {
-    handler.ReportError("TensorTranspose output shape ", shape_output,
-                        " does not match the input shape ", shape_input);
+static void TransposeImpl(const DHTArrayView<T>& input,
+                          MutableDHTArrayView<T>& output,
+                          ArrayRef<ssize_t> perm, Result<Chain> out_chain,
+                          KernelErrorHandler handler,
+                          const ExecutionContext& exec_ctx,
+                          KernelFrame* frame) {
+  const TensorShape& input_shape = input.Shape();
+  const TensorShape& output_shape = output.Shape();
+
+  TFRT_RETURN_IF_ERROR(handler, compat::ValidateTransposePermutation(
+                                    perm, input_shape.GetRank()));
+
+  llvm::SmallVector<ssize_t, 4> input_dims;
+  input_shape.GetDimensions(&input_dims);
+
+  llvm::SmallVector<ssize_t, 4> transposed_dims;
+  for (ssize_t dim : perm) transposed_dims.push_back(input_dims[dim]);
+
+  if (output_shape != TensorShape(transposed_dims)) {
+    handler.ReportError("Transpose output shape ", output_shape,
+                        " does not match the transposed input shape ",
+                        TensorShape(transposed_dims));
     return;
   }
 
-  for (int i = 0, end = shape_output[0]; i < end; i++) {
-    for (int j = 0, end = shape_output[1]; j < end; j++) {
-      output->ElementAt(i, j) = input->ElementAt(j, i);
-    }
-  }
+  compat::AsyncTranspose<T>(
+      exec_ctx.host(), compat::PlanTranspose(input_dims, perm), input.data(),
+      output.data(),
+      [chain = out_chain.Allocate(), frame = RAIIKernelFrame(*frame)]() {
+        chain.emplace();
+      });
+}
+
+template <typename T>
+static void Transpose(ArgumentView<MutableDHTArrayView<T>> input,
+                      ArgumentView<MutableDHTArrayView<T>> output,
+                      Argument<Chain> in_chain, Result<Chain> out_chain,
+                      ArrayAttribute<ssize_t> perm, KernelErrorHandler handler,
+                      const ExecutionContext& exec_ctx, KernelFrame* frame) {
+  TransposeImpl<T>(*input, *output, perm.data(), out_chain, handler, exec_ctx,
+                   frame);
+}
 
-  out_chain.Set(in_chain);
+template <typename T>
+static void TensorTranspose(ArgumentView<MutableDHTIndexableView<T, 2>> input,
+                            ArgumentView<MutableDHTIndexableView<T, 2>> output,
+                            Argument<Chain> in_chain, Result<Chain> out_chain,
+                            KernelErrorHandler handler,
+                            const ExecutionContext& exec_ctx,
+                            KernelFrame* frame) {
+  static constexpr ssize_t kPerm[] = {1, 0};
+  TransposeImpl<T>(*input, *output, kPerm, out_chain, handler, exec_ctx,
+                   frame);
 }
 
 static void MeanAxisZero(ArgumentView<MutableDHTIndexableView<float, 2>> input,
@@ -361,14 +386,24 @@ void RegisterResNetTensorKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_test.flatten.f32", TFRT_KERNEL(Flatten<float>));
   registry->AddKernel("tfrt_test.zero_padding.f32",
                       TFRT_KERNEL(ZeroPadding<float>));
-  registry->AddKernel("tfrt_test.softmax_inplace.f32",
-                      TFRT_KERNEL(SoftMaxInPlace));
+  registry->AddKernel(
+      "tfrt_test.softmax_inplace.f32",
+      TFRT_KERNEL(SoftMaxInPlace<compat::SoftmaxType::kSoftmax>));
+  registry->AddKernel(
+      "tfrt_test.log_softmax_inplace.f32",
+      TFRT_KERNEL(SoftMaxInPlace<compat::SoftmaxType::kLogSoftmax>));
+  registry->AddKernel("tfrt_test.softmax_cross_entropy.f32",
+                      TFRT_KERNEL(SoftMaxCrossEntropy));
   registry->AddKernel("tfrt_test.gradient_descent.f32",
                       TFRT_KERNEL(GradientDescent));
   registry->AddKernel("tfrt_test.subtract_inplace.f32",
                       TFRT_KERNEL(ElementwiseSubtractInPlace<float>));
   registry->AddKernel("tfrt_test.tensor_transpose.f32",
                       TFRT_KERNEL(TensorTranspose<float>));
+  registry->AddKernel("tfrt_test.transpose.f32",
+                      TFRT_KERNEL(Transpose<float>));
+  registry->AddKernel("tfrt_test.transpose.i32",
+                      TFRT_KERNEL(Transpose<int32_t>));
   registry->AddKernel("tfrt_test.mean_axis_zero.f32",
                       TFRT_KERNEL(MeanAxisZero));
   registry->AddKernel("tfrt_test.broadcast_2d.f32", TFRT_KERNEL(Broadcast2D));
@@ -22,6 +22,7 @@
 
 #include "../../kernels/cpu_kernels.h"
 #include "tfrt/common/compat/eigen/eigen_dtype.h"
+#include "tfrt/common/compat/eigen/transpose.h"
 #include "tfrt/common/ops/tf/metadata_functions.h"
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_utils.h"
@@ -29,6 +30,7 @@
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/support/string_util.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor_view.h"
 #include "tfrt/tensor/tensor_serialize_utils.h"
@@ -157,6 +159,126 @@ static AsyncValueRef<DenseHostTensor> TfReluOp(
   return B_tensor;
 }
 
+//===----------------------------------------------------------------------===//
+// tf.Transpose op
+//===----------------------------------------------------------------------===//
+
+// Permutes the dimensions of `input`: output dimension `i` is the input
+// dimension `perm[i]`. If the permutation only moves dimensions of size one,
+// the result shares the input buffer.
+static AsyncValueRef<DenseHostTensor> TfTransposeOpImpl(
+    const DenseHostTensor& input, ArrayRef<ssize_t> perm,
+    const TensorMetadata& dest_md, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+
+  if (auto error = compat::ValidateTransposePermutation(
+          perm, input.shape().GetRank())) {
+    return EmitErrorAsync(exec_ctx, std::move(error));
+  }
+
+  llvm::SmallVector<ssize_t, 4> input_dims;
+  input.shape().GetDimensions(&input_dims);
+
+  llvm::SmallVector<ssize_t, 4> output_dims;
+  for (ssize_t dim : perm) output_dims.push_back(input_dims[dim]);
+  if (dest_md.shape != TensorShape(output_dims)) {
+    return EmitErrorAsync(
+        exec_ctx, StrCat("transpose result shape ", dest_md.shape,
+                         " does not match the permuted input shape ",
+                         TensorShape(output_dims)));
+  }
+
+  auto plan = compat::PlanTranspose(input_dims, perm);
+  if (plan.IsIdentity()) {
+    return host->MakeAvailableAsyncValueRef<DenseHostTensor>(
+        dest_md, input.buffer().CopyRef());
+  }
+
+  auto dest = DenseHostTensor::CreateUninitialized(dest_md, host);
+  if (!dest) {
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
+  }
+  void* dest_data = dest->data();
+
+  auto result = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  auto done = [input = input.CopyRef(), dest = std::move(dest).getValue(),
+               result = result.CopyRef()]() mutable {
+    result.emplace(std::move(dest));
+  };
+
+  switch (input.dtype().kind()) {
+    default:
+      return EmitErrorAsync(exec_ctx, "unsupported dtype for transpose");
+#define DTYPE_NUMERIC(ENUM)                                                    \
+  case DType::ENUM: {                                                          \
+    using T = EigenTypeForDTypeKind<DType::ENUM>;                              \
+    compat::AsyncTranspose<T>(host, plan, static_cast<const T*>(input.data()), \
+                              static_cast<T*>(dest_data), std::move(done));    \
+    break;                                                                     \
+  }
+#include "tfrt/tensor/dtype.def"  // NOLINT
+  }
+
+  return result;
+}
+
+// tf.Transpose with the permutation in the `perm` tensor.
+static AsyncValueRef<DenseHostTensor> TfTransposeOp(
+    const DenseHostTensor& input, const DenseHostTensor& perm,
+    const TensorMetadata& dest_md, const ExecutionContext& exec_ctx) {
+  llvm::SmallVector<ssize_t, 4> perm_values;
+  switch (perm.dtype().kind()) {
+    case DType::I32: {
+      auto values = DHTArrayView<int32_t>(&perm).Elements();
+      perm_values.assign(values.begin(), values.end());
+      break;
+    }
+    case DType::I64: {
+      auto values = DHTArrayView<int64_t>(&perm).Elements();
+      perm_values.assign(values.begin(), values.end());
+      break;
+    }
+    default:
+      return EmitErrorAsync(exec_ctx, "unsupported dtype for transpose perm");
+  }
+
+  // The result metadata is computed for the only supported permutation.
+  if (ArrayRef<ssize_t>(perm_values) !=
+      ArrayRef<ssize_t>(kTfTransposeOperandPerm)) {
+    return EmitErrorAsync(
+        exec_ctx, StrCat("tf.Transpose with a `perm` operand only supports the "
+                         "NHWC to NCHW permutation, got [",
+                         Join(perm_values, ", "), "]"));
+  }
+
+  return TfTransposeOpImpl(input, perm_values, dest_md, exec_ctx);
+}
+
+// tf.Transpose with the permutation folded into the `perm` attribute.
+static AsyncValueRef<DenseHostTensor> TfTransposeFoldedOp(
+    const DenseHostTensor& input, const OpAttrsRef& attrs,
+    const TensorMetadata& dest_md, const ExecutionContext& exec_ctx) {
+  DenseView perm_view = CreateDenseView(attrs.GetAsserting<DenseAttr>("perm"));
+
+  llvm::SmallVector<ssize_t, 4> perm_values;
+  switch (perm_view.dtype().kind()) {
+    case DType::I32: {
+      auto values = perm_view.GetFlat<int32_t>();
+      perm_values.assign(values.begin(), values.end());
+      break;
+    }
+    case DType::I64: {
+      auto values = perm_view.GetFlat<int64_t>();
+      perm_values.assign(values.begin(), values.end());
+      break;
+    }
+    default:
+      return EmitErrorAsync(exec_ctx, "unsupported dtype for transpose perm");
+  }
+
+  return TfTransposeOpImpl(input, perm_values, dest_md, exec_ctx);
+}
+
 }  // namespace
 
 void RegisterTfCpuOps(CpuOpRegistry* op_registry) {
@@ -172,6 +294,10 @@ void RegisterTfCpuOps(CpuOpRegistry* op_registry) {
                      CpuOpFlags::NoSideEffects, {"transpose_a", "transpose_b"});
   op_registry->AddOp("tf.Relu", TFRT_CPU_OP(TfReluOp),
                      CpuOpFlags::NoSideEffects);
+  op_registry->AddOp("tf.Transpose", TFRT_CPU_OP(TfTransposeOp),
+                     CpuOpFlags::NoSideEffects);
+  op_registry->AddOp("_tf.Transpose", TFRT_CPU_OP(TfTransposeFoldedOp),
+                     CpuOpFlags::NoSideEffects, {"perm"});
 }
 
 }  // namespace tfrt
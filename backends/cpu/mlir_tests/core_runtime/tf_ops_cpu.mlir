@@ -26,3 +26,81 @@ func @const_f32() -> !hex.chain {
   %ch_print_cpu = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print"(%cpu_handle_result) : 0
   hex.return %ch_print_cpu : !hex.chain
 }
+
+// CHECK: --- Running 'transpose_f32'
+func @transpose_f32() -> !hex.chain {
+  %ch0 = hex.new.chain
+  %cpu = corert.get_device "cpu"
+
+  %input = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<2x3xf32>, dtype = f32} : 1
+  %result = corert.executeop(%cpu)
+    "_tf.Transpose"(%input) {perm = dense<[1, 0]> : tensor<2xi32>} : 1
+
+  // CHECK: DenseHostTensor dtype = F32, shape = [3, 2], values = [1.000000e+00, 4.000000e+00, 2.000000e+00, 5.000000e+00, 3.000000e+00, 6.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print"(%result) : 0
+  hex.return %ch_print_cpu : !hex.chain
+}
+
+// CHECK: --- Running 'transpose_unit_dims_f32'
+func @transpose_unit_dims_f32() -> !hex.chain {
+  %ch0 = hex.new.chain
+  %cpu = corert.get_device "cpu"
+
+  %input = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[[[1.0, 2.0, 3.0]], [[4.0, 5.0, 6.0]]]> : tensor<2x1x3xf32>, dtype = f32} : 1
+  %result = corert.executeop(%cpu)
+    "_tf.Transpose"(%input) {perm = dense<[1, 0, 2]> : tensor<3xi64>} : 1
+
+  // CHECK: DenseHostTensor dtype = F32, shape = [1, 2, 3], values = [1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00, 5.000000e+00, 6.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print"(%result) : 0
+  hex.return %ch_print_cpu : !hex.chain
+}
+
+// CHECK: --- Running 'transpose_nhwc_to_nchw_f32'
+func @transpose_nhwc_to_nchw_f32() -> !hex.chain {
+  %ch0 = hex.new.chain
+  %cpu = corert.get_device "cpu"
+
+  %input = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[[[[1.0, 2.0, 3.0, 4.0], [5.0, 6.0, 7.0, 8.0], [9.0, 10.0, 11.0, 12.0]], [[13.0, 14.0, 15.0, 16.0], [17.0, 18.0, 19.0, 20.0], [21.0, 22.0, 23.0, 24.0]]]]> : tensor<1x2x3x4xf32>, dtype = f32} : 1
+  %perm = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[0, 3, 1, 2]> : tensor<4xi32>, dtype = i32} : 1
+  %result = corert.executeop(%cpu) "tf.Transpose"(%input, %perm) : 1
+
+  // CHECK: DenseHostTensor dtype = F32, shape = [1, 4, 2, 3], values = [1.000000e+00, 5.000000e+00, 9.000000e+00, 1.300000e+01, 1.700000e+01, 2.100000e+01, 2.000000e+00, 6.000000e+00, 1.000000e+01, 1.400000e+01, 1.800000e+01, 2.200000e+01, 3.000000e+00, 7.000000e+00, 1.100000e+01, 1.500000e+01, 1.900000e+01, 2.300000e+01, 4.000000e+00, 8.000000e+00, 1.200000e+01, 1.600000e+01, 2.000000e+01, 2.400000e+01]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch0) "tfrt_test.print"(%result) : 0
+  hex.return %ch_print_cpu : !hex.chain
+}
+
+// CHECK: --- Running 'transpose_perm_operand_error'
+func @transpose_perm_operand_error() {
+  %ch0 = hex.new.chain
+  %cpu = corert.get_device "cpu"
+
+  %input = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[[[[1.0, 2.0, 3.0, 4.0], [5.0, 6.0, 7.0, 8.0], [9.0, 10.0, 11.0, 12.0]], [[13.0, 14.0, 15.0, 16.0], [17.0, 18.0, 19.0, 20.0], [21.0, 22.0, 23.0, 24.0]]]]> : tensor<1x2x3x4xf32>, dtype = f32} : 1
+  %perm = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[0, 2, 3, 1]> : tensor<4xi32>, dtype = i32} : 1
+
+  // expected-error @+1 {{tf.Transpose with a `perm` operand only supports the NHWC to NCHW permutation, got [0, 2, 3, 1]}}
+  %result = corert.executeop(%cpu) "tf.Transpose"(%input, %perm) : 1
+
+  hex.return
+}
+
+// CHECK: --- Running 'transpose_perm_operand_rank_error'
+func @transpose_perm_operand_rank_error() {
+  %ch0 = hex.new.chain
+  %cpu = corert.get_device "cpu"
+
+  %input = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]]> : tensor<2x3xf32>, dtype = f32} : 1
+  %perm = corert.executeop(%cpu)
+    "tf.Const"() {value = dense<[1, 0]> : tensor<2xi32>, dtype = i32} : 1
+
+  // expected-error @+1 {{tf.Transpose with a `perm` operand only supports the NHWC to NCHW permutation, use a `perm` attribute for other permutations}}
+  %result = corert.executeop(%cpu) "tf.Transpose"(%input, %perm) : 1
+
+  hex.return
+}
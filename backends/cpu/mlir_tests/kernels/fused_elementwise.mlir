@@ -0,0 +1,79 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor 2>&1 | FileCheck %s --dump-input=fail
+
+// CHECK-LABEL: --- Running 'fused_elementwise_f32'
+func @fused_elementwise_f32() {
+  %ch0 = hex.new.chain
+
+  %a = "dht.create_uninitialized_tensor.f32.2"() { shape = [2 : i64, 3 : i64] } :
+    () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%a, %ch0)
+    { values = [1.0 : f32, -2.0 : f32, 3.0 : f32, -4.0 : f32, 5.0 : f32, -6.0 : f32] } :
+    (!t.tensor, !hex.chain) -> !hex.chain
+
+  %b = "dht.create_uninitialized_tensor.f32.1"() { shape = [3 : i64] } :
+    () -> !t.tensor
+  %ch2 = "dht.set_tensor_with_constant_values.f32"(%b, %ch1)
+    { values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } :
+    (!t.tensor, !hex.chain) -> !hex.chain
+
+  %c = "dht.create_uninitialized_tensor.f32.2"() { shape = [2 : i64, 1 : i64] } :
+    () -> !t.tensor
+  %ch3 = "dht.set_tensor_with_constant_values.f32"(%c, %ch2)
+    { values = [1.0 : f32, 2.0 : f32] } :
+    (!t.tensor, !hex.chain) -> !hex.chain
+
+  %out = "dht.create_uninitialized_tensor.f32.2"() { shape = [2 : i64, 3 : i64] } :
+    () -> !t.tensor
+
+  // out = relu(a * 2.0 + b)
+  %ch4 = "cpu.fused_elementwise.f32"(%out, %ch3, %a, %b)
+    { constants = [2.0 : f32],
+      program = [2 : i32, 0 : i32, 2 : i32,
+                 0 : i32, 3 : i32, 1 : i32,
+                 8 : i32, 4 : i32, 0 : i32] } :
+    (!t.tensor, !hex.chain, !t.tensor, !t.tensor) -> !hex.chain
+
+  // CHECK: shape = [2, 3], values = [3.000000e+00, 0.000000e+00, 9.000000e+00, 0.000000e+00, 1.200000e+01, 0.000000e+00]
+  %ch5 = dht.print_tensor %out, %ch4
+
+  // out = a - c
+  %ch6 = "cpu.fused_elementwise.f32"(%out, %ch5, %a, %c)
+    { constants = [], program = [1 : i32, 0 : i32, 1 : i32] } :
+    (!t.tensor, !hex.chain, !t.tensor, !t.tensor) -> !hex.chain
+
+  // CHECK: shape = [2, 3], values = [0.000000e+00, -3.000000e+00, 2.000000e+00, -6.000000e+00, 3.000000e+00, -8.000000e+00]
+  %ch7 = dht.print_tensor %out, %ch6
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'fused_elementwise_not_broadcastable'
+func @fused_elementwise_not_broadcastable() {
+  %ch0 = hex.new.chain
+
+  %a = "dht.create_uninitialized_tensor.f32.1"() { shape = [3 : i64] } :
+    () -> !t.tensor
+  %out = "dht.create_uninitialized_tensor.f32.1"() { shape = [2 : i64] } :
+    () -> !t.tensor
+
+  // expected-error @+1 {{runtime error: fused elementwise input #0 shape [3] is not broadcastable to [2]}}
+  %ch1 = "cpu.fused_elementwise.f32"(%out, %ch0, %a)
+    { constants = [], program = [6 : i32, 0 : i32, 0 : i32] } :
+    (!t.tensor, !hex.chain, !t.tensor) -> !hex.chain
+
+  hex.return
+}
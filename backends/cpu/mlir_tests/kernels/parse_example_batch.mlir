@@ -0,0 +1,110 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor 2>&1 | FileCheck %s --dump-input=fail
+
+// CHECK-LABEL: --- Running 'parse_example_batch'
+func @parse_example_batch() {
+  %ch0 = hex.new.chain
+
+  // Records 0 and 2 use packed int64 and float lists, and record 0 has an
+  // extra feature that is not in the spec. Record 1 lists the features in
+  // reverse order with unpacked lists and a negative int64 (a 10-byte varint).
+  %serialized = "sht.create_tensor"() { shape = [3], values = [
+      "\0A\5B\0A\0E\0A\05label\12\05\1A\03\0A\01\01\0A\0E\0A\03ids\12\07\1A\05\0A\03\07\AC\02\0A\17\0A\07weights\12\0C\12\0A\0A\08\00\00\00\3F\00\00\C0\3F\0A\0F\0A\04name\12\07\0A\05\0A\03cat\0A\0F\0A\06unused\12\05\1A\03\0A\01\2A",
+      "\0AQ\0A\0F\0A\04name\12\07\0A\05\0A\03dog\0A\17\0A\07weights\12\0C\12\0A\0D\00\00\00\C0\0D\00\00\80\3E\0A\16\0A\03ids\12\0F\1A\0D\08\FF\FF\FF\FF\FF\FF\FF\FF\FF\01\08\00\0A\0D\0A\05label\12\04\1A\02\08\00",
+      "\0AI\0A\0E\0A\05label\12\05\1A\03\0A\01\01\0A\0D\0A\03ids\12\06\1A\04\0A\02\02\03\0A\17\0A\07weights\12\0C\12\0A\0A\08\00\00\80\40\00\00\00A\0A\0F\0A\04name\12\07\0A\05\0A\03owl"
+  ] } : () -> !t.tensor
+
+  %label, %ids, %weights, %name = "proto.parse_example_batch"(%serialized)
+    { feature_spec = [["label", "int64", 1 : i64], ["ids", "int64", 2 : i64],
+                      ["weights", "float", 2 : i64], ["name", "bytes", 1 : i64]] }
+    : (!t.tensor) -> (!t.tensor, !t.tensor, !t.tensor, !t.tensor)
+
+  // CHECK: DenseHostTensor dtype = I64, shape = [3, 1], values = [1, 0, 1]
+  %ch1 = dht.print_tensor %label, %ch0
+  // CHECK: DenseHostTensor dtype = I64, shape = [3, 2], values = [7, 300, -1, 0, 2, 3]
+  %ch2 = dht.print_tensor %ids, %ch1
+  // CHECK: DenseHostTensor dtype = F32, shape = [3, 2], values = [5.000000e-01, 1.500000e+00, -2.000000e+00, 2.500000e-01, 4.000000e+00, 8.000000e+00]
+  %ch3 = dht.print_tensor %weights, %ch2
+  // CHECK: SHT shape = [3, 1], values = ["cat", "dog", "owl"]
+  %ch4 = dht.print_tensor %name, %ch3
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'parse_example_batch_truncated_record'
+func @parse_example_batch_truncated_record() {
+  // Record 1 is cut off in the middle of the name feature.
+  %serialized = "sht.create_tensor"() { shape = [2], values = [
+      "\0A\5B\0A\0E\0A\05label\12\05\1A\03\0A\01\01\0A\0E\0A\03ids\12\07\1A\05\0A\03\07\AC\02\0A\17\0A\07weights\12\0C\12\0A\0A\08\00\00\00\3F\00\00\C0\3F\0A\0F\0A\04name\12\07\0A\05\0A\03cat\0A\0F\0A\06unused\12\05\1A\03\0A\01\2A",
+      "\0AI\0A\0E\0A\05label\12\05\1A\03\0A\01\01\0A\0D\0A\03ids\12\06\1A\04\0A\02\02\03\0A\17\0A\07weights\12\0C\12\0A\0A\08\00\00\80\40\00\00\00A\0A\0F\0A\04name\12\07\0A\05\0A\03"
+  ] } : () -> !t.tensor
+
+  // expected-error @+1 {{runtime error: failed to parse record 1: failed to parse example.proto from string}}
+  %label, %ids, %weights, %name = "proto.parse_example_batch"(%serialized)
+    { feature_spec = [["label", "int64", 1 : i64], ["ids", "int64", 2 : i64],
+                      ["weights", "float", 2 : i64], ["name", "bytes", 1 : i64]] }
+    : (!t.tensor) -> (!t.tensor, !t.tensor, !t.tensor, !t.tensor)
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'parse_example_batch_missing_feature'
+func @parse_example_batch_missing_feature() {
+  // Record 0 only has the label feature.
+  %serialized = "sht.create_tensor"() { shape = [1], values = [
+      "\0A\10\0A\0E\0A\05label\12\05\1A\03\0A\01\05"
+  ] } : () -> !t.tensor
+
+  // expected-error @+1 {{runtime error: failed to parse record 0: key ids is not found in the proto}}
+  %label, %ids, %weights, %name = "proto.parse_example_batch"(%serialized)
+    { feature_spec = [["label", "int64", 1 : i64], ["ids", "int64", 2 : i64],
+                      ["weights", "float", 2 : i64], ["name", "bytes", 1 : i64]] }
+    : (!t.tensor) -> (!t.tensor, !t.tensor, !t.tensor, !t.tensor)
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'parse_example_batch_num_values_mismatch'
+func @parse_example_batch_num_values_mismatch() {
+  // Record 0 has three ids, but the spec expects two.
+  %serialized = "sht.create_tensor"() { shape = [1], values = [
+      "\0A\20\0A\0E\0A\05label\12\05\1A\03\0A\01\01\0A\0E\0A\03ids\12\07\1A\05\0A\03\01\02\03"
+  ] } : () -> !t.tensor
+
+  // expected-error @+1 {{runtime error: failed to parse record 0: feature ids has 3 values, but the spec expects 2}}
+  %label, %ids, %weights, %name = "proto.parse_example_batch"(%serialized)
+    { feature_spec = [["label", "int64", 1 : i64], ["ids", "int64", 2 : i64],
+                      ["weights", "float", 2 : i64], ["name", "bytes", 1 : i64]] }
+    : (!t.tensor) -> (!t.tensor, !t.tensor, !t.tensor, !t.tensor)
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'parse_example_batch_kind_mismatch'
+func @parse_example_batch_kind_mismatch() {
+  // Record 0 stores the label as a float list.
+  %serialized = "sht.create_tensor"() { shape = [1], values = [
+      "\0A\13\0A\11\0A\05label\12\08\12\06\0A\04\00\00\80\3F"
+  ] } : () -> !t.tensor
+
+  // expected-error @+1 {{runtime error: failed to parse record 0: feature label has kind float, but the spec expects int64}}
+  %label, %ids, %weights, %name = "proto.parse_example_batch"(%serialized)
+    { feature_spec = [["label", "int64", 1 : i64], ["ids", "int64", 2 : i64],
+                      ["weights", "float", 2 : i64], ["name", "bytes", 1 : i64]] }
+    : (!t.tensor) -> (!t.tensor, !t.tensor, !t.tensor, !t.tensor)
+
+  hex.return
+}
@@ -37,6 +37,211 @@ func @test_flatten_f32() {
 }
 
 
+// CHECK-LABEL: --- Running 'test_softmax_f32'
+func @test_softmax_f32() {
+  %ch0 = hex.new.chain
+
+  %t1 = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%t1, %ch0)
+    { values = [1.0 : f32, 1.0 : f32, 2.0 : f32, 2.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %ch2 = "tfrt_test.softmax_inplace.f32"(%t1, %ch1)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2], values = [5.000000e-01, 5.000000e-01, 5.000000e-01, 5.000000e-01]
+  %ch3 = dht.print_tensor %t1, %ch2
+
+  %ch4 = "tfrt_test.log_softmax_inplace.f32"(%t1, %ch3)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2], values = [-6.931472e-01, -6.931472e-01, -6.931472e-01, -6.931472e-01]
+  dht.print_tensor %t1, %ch4
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_softmax_cross_entropy_f32'
+func @test_softmax_cross_entropy_f32() {
+  %ch0 = hex.new.chain
+
+  %logits = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%logits, %ch0)
+    { values = [1.0 : f32, 1.0 : f32, 2.0 : f32, 2.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %labels = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch2 = "dht.set_tensor_with_constant_values.f32"(%labels, %ch1)
+    { values = [1.0 : f32, 0.0 : f32, 0.5 : f32, 0.5 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %loss = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [2 : i64] }
+    : () -> !t.tensor
+  %backprop = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch3 = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                %backprop, %ch2)
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2], values = [6.931472e-01, 6.931472e-01]
+  %ch4 = dht.print_tensor %loss, %ch3
+
+  // CHECK: shape = [2, 2], values = [-5.000000e-01, 5.000000e-01, 0.000000e+00, 0.000000e+00]
+  dht.print_tensor %backprop, %ch4
+  hex.return
+}
+
+// Rows of 37 columns are longer than a few packets and end with a partial
+// packet. 257 rows of 10 columns use the short rows path with a partial chunk
+// of rows. Expected values are computed in double precision.
+// CHECK-LABEL: --- Running 'test_softmax_f32_3x37'
+func @test_softmax_f32_3x37() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/cpu/mlir_tests/resnet/test_data/softmax.btf"
+  } : () -> !hex.string
+
+  %logits_index = hex.constant.i32 0
+  %labels_index = hex.constant.i32 1
+  %expected_softmax_index = hex.constant.i32 2
+  %expected_log_softmax_index = hex.constant.i32 3
+  %expected_loss_index = hex.constant.i32 4
+  %expected_backprop_index = hex.constant.i32 5
+
+  %softmax = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %log_softmax = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %logits = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %labels = "btf.read_dense_tensor.f32.2"(%path, %labels_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_softmax = "btf.read_dense_tensor.f32.2"(%path, %expected_softmax_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_log_softmax = "btf.read_dense_tensor.f32.2"(%path, %expected_log_softmax_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_loss = "btf.read_dense_tensor.f32.1"(%path, %expected_loss_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_backprop = "btf.read_dense_tensor.f32.2"(%path, %expected_backprop_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %ch1 = "tfrt_test.softmax_inplace.f32"(%softmax, %ch0)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %cmp1, %ch2 = "dht.tensor_allclose.1000ulp.f32"(%expected_softmax, %softmax, %ch1)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch3 = hex.print.i1 %cmp1, %ch2
+
+  %ch4 = "tfrt_test.log_softmax_inplace.f32"(%log_softmax, %ch3)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %cmp2, %ch5 = "dht.tensor_allclose.1000ulp.f32"(%expected_log_softmax, %log_softmax, %ch4)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch6 = hex.print.i1 %cmp2, %ch5
+
+  %loss = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [3 : i64] }
+    : () -> !t.tensor
+  %backprop = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [3 : i64, 37 : i64] }
+    : () -> !t.tensor
+  %ch7 = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                %backprop, %ch6)
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+  %cmp3, %ch8 = "dht.tensor_allclose.1000ulp.f32"(%expected_loss, %loss, %ch7)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch9 = hex.print.i1 %cmp3, %ch8
+
+  %cmp4, %ch10 = "dht.tensor_allclose.1000ulp.f32"(%expected_backprop, %backprop, %ch9)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp4, %ch10
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_softmax_f32_257x10'
+func @test_softmax_f32_257x10() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/cpu/mlir_tests/resnet/test_data/softmax.btf"
+  } : () -> !hex.string
+
+  %logits_index = hex.constant.i32 6
+  %labels_index = hex.constant.i32 7
+  %expected_softmax_index = hex.constant.i32 8
+  %expected_log_softmax_index = hex.constant.i32 9
+  %expected_loss_index = hex.constant.i32 10
+  %expected_backprop_index = hex.constant.i32 11
+
+  %softmax = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %log_softmax = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %logits = "btf.read_dense_tensor.f32.2"(%path, %logits_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %labels = "btf.read_dense_tensor.f32.2"(%path, %labels_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_softmax = "btf.read_dense_tensor.f32.2"(%path, %expected_softmax_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_log_softmax = "btf.read_dense_tensor.f32.2"(%path, %expected_log_softmax_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_loss = "btf.read_dense_tensor.f32.1"(%path, %expected_loss_index)
+    : (!hex.string, i32) -> (!t.tensor)
+  %expected_backprop = "btf.read_dense_tensor.f32.2"(%path, %expected_backprop_index)
+    : (!hex.string, i32) -> (!t.tensor)
+
+  %ch1 = "tfrt_test.softmax_inplace.f32"(%softmax, %ch0)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %cmp1, %ch2 = "dht.tensor_allclose.1000ulp.f32"(%expected_softmax, %softmax, %ch1)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch3 = hex.print.i1 %cmp1, %ch2
+
+  %ch4 = "tfrt_test.log_softmax_inplace.f32"(%log_softmax, %ch3)
+    : (!t.tensor, !hex.chain) -> !hex.chain
+  %cmp2, %ch5 = "dht.tensor_allclose.1000ulp.f32"(%expected_log_softmax, %log_softmax, %ch4)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch6 = hex.print.i1 %cmp2, %ch5
+
+  %loss = "dht.create_uninitialized_tensor.f32.1"()
+    { shape = [257 : i64] }
+    : () -> !t.tensor
+  %backprop = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [257 : i64, 10 : i64] }
+    : () -> !t.tensor
+  %ch7 = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                %backprop, %ch6)
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+  %cmp3, %ch8 = "dht.tensor_allclose.1000ulp.f32"(%expected_loss, %loss, %ch7)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  %ch9 = hex.print.i1 %cmp3, %ch8
+
+  %cmp4, %ch10 = "dht.tensor_allclose.1000ulp.f32"(%expected_backprop, %backprop, %ch9)
+    : (!t.tensor, !t.tensor, !hex.chain) -> (i1, !hex.chain)
+
+  // CHECK: int1 = 1
+  hex.print.i1 %cmp4, %ch10
+  hex.return
+}
+
 // CHECK-LABEL: --- Running 'test_max_pool_2d_f32_padding_error'
 func @test_max_pool_2d_f32_padding_error() {
   %ch0 = hex.new.chain
@@ -74,3 +279,91 @@ func @test_max_pool_2d_f32_shape_error() {
 
   hex.return
 }
+
+// CHECK-LABEL: --- Running 'test_tensor_transpose_f32'
+func @test_tensor_transpose_f32() {
+  %ch0 = hex.new.chain
+
+  %input = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 3 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%input, %ch0)
+    { values = [0.0 : f32, 1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32, 5.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %output = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [3 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch2 = "tfrt_test.tensor_transpose.f32"(%input, %output, %ch1)
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [3, 2], values = [0.000000e+00, 3.000000e+00, 1.000000e+00, 4.000000e+00, 2.000000e+00, 5.000000e+00]
+  dht.print_tensor %output, %ch2
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_transpose_f32'
+func @test_transpose_f32() {
+  %ch0 = hex.new.chain
+
+  %input = "dht.create_uninitialized_tensor.f32.3"()
+    { shape = [2 : i64, 3 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.f32"(%input, %ch0)
+    { values = [0.0 : f32, 1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32, 5.0 : f32,
+                6.0 : f32, 7.0 : f32, 8.0 : f32, 9.0 : f32, 10.0 : f32, 11.0 : f32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %output = "dht.create_uninitialized_tensor.f32.3"()
+    { shape = [2 : i64, 2 : i64, 3 : i64] }
+    : () -> !t.tensor
+  %ch2 = "tfrt_test.transpose.f32"(%input, %output, %ch1)
+    { perm = [2 : i64, 0 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2, 3], values = [0.000000e+00, 2.000000e+00, 4.000000e+00, 6.000000e+00, 8.000000e+00, 1.000000e+01, 1.000000e+00, 3.000000e+00, 5.000000e+00, 7.000000e+00, 9.000000e+00, 1.100000e+01]
+  dht.print_tensor %output, %ch2
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_transpose_i32_keeps_innermost_dim'
+func @test_transpose_i32_keeps_innermost_dim() {
+  %ch0 = hex.new.chain
+
+  %input = "dht.create_uninitialized_tensor.i32.3"()
+    { shape = [2 : i64, 2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch1 = "dht.set_tensor_with_constant_values.i32"(%input, %ch0)
+    { values = [0 : i32, 1 : i32, 2 : i32, 3 : i32, 4 : i32, 5 : i32, 6 : i32, 7 : i32] }
+    : (!t.tensor, !hex.chain) -> !hex.chain
+
+  %output = "dht.create_uninitialized_tensor.i32.3"()
+    { shape = [2 : i64, 2 : i64, 2 : i64] }
+    : () -> !t.tensor
+  %ch2 = "tfrt_test.transpose.i32"(%input, %output, %ch1)
+    { perm = [1 : i64, 0 : i64, 2 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  // CHECK: shape = [2, 2, 2], values = [0, 1, 4, 5, 2, 3, 6, 7]
+  dht.print_tensor %output, %ch2
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'test_transpose_f32_perm_error'
+func @test_transpose_f32_perm_error() {
+  %ch0 = hex.new.chain
+
+  %input = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [2 : i64, 3 : i64] }
+    : () -> !t.tensor
+  %output = "dht.create_uninitialized_tensor.f32.2"()
+    { shape = [3 : i64, 2 : i64] }
+    : () -> !t.tensor
+
+  // expected-error @+1 {{transpose permutation is not a permutation of the input dimensions}}
+  "tfrt_test.transpose.f32"(%input, %output, %ch0)
+    { perm = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !hex.chain) -> !hex.chain
+
+  hex.return
+}
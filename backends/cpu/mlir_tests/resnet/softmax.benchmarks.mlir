@@ -0,0 +1,302 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=fail
+
+// Softmax and softmax cross-entropy on the (batch, classes) shapes of the
+// MNIST and ResNet models.
+
+// CHECK-LABEL: --- Running 'BM_Softmax_1x10_f32'
+func @BM_Softmax_1x10_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [1, 10].
+  %logits = dht.create_uninitialized_tensor.f32.2 [1 : i64, 10 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_Softmax_1x10_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Softmax_32x10_f32'
+func @BM_Softmax_32x10_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 10].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 10 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_Softmax_32x10_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Softmax_32x1000_f32'
+func @BM_Softmax_32x1000_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 1000].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 1000 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_Softmax_32x1000_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_Softmax_256x1000_f32'
+func @BM_Softmax_256x1000_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [256, 1000].
+  %logits = dht.create_uninitialized_tensor.f32.2 [256 : i64, 1000 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_Softmax_256x1000_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_LogSoftmax_32x10_f32'
+func @BM_LogSoftmax_32x10_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 10].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 10 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_LogSoftmax_32x10_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.log_softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_LogSoftmax_32x1000_f32'
+func @BM_LogSoftmax_32x1000_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 1000].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 1000 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  tfrt_test.benchmark "BM_LogSoftmax_32x1000_f32"(
+      %logits : !t.tensor,
+      %ch1 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.log_softmax_inplace.f32"(%logits, %ch1)
+       : (!t.tensor, !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_SoftmaxCrossEntropy_1x10_f32'
+func @BM_SoftmaxCrossEntropy_1x10_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [1, 10].
+  %logits = dht.create_uninitialized_tensor.f32.2 [1 : i64, 10 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  // Shape: [1, 10].
+  %labels = dht.create_uninitialized_tensor.f32.2 [1 : i64, 10 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %labels, %ch0 0.1 : f32
+
+  // Shape: [1].
+  %loss = dht.create_uninitialized_tensor.f32.1 [1 : i64]
+
+  // Shape: [1, 10].
+  %backprop = dht.create_uninitialized_tensor.f32.2 [1 : i64, 10 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_SoftmaxCrossEntropy_1x10_f32"(
+      %logits : !t.tensor,
+      %labels : !t.tensor,
+      %loss : !t.tensor,
+      %backprop : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                       %backprop, %ch3)
+       : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+          !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_SoftmaxCrossEntropy_32x10_f32'
+func @BM_SoftmaxCrossEntropy_32x10_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 10].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 10 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  // Shape: [32, 10].
+  %labels = dht.create_uninitialized_tensor.f32.2 [32 : i64, 10 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %labels, %ch0 0.1 : f32
+
+  // Shape: [32].
+  %loss = dht.create_uninitialized_tensor.f32.1 [32 : i64]
+
+  // Shape: [32, 10].
+  %backprop = dht.create_uninitialized_tensor.f32.2 [32 : i64, 10 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_SoftmaxCrossEntropy_32x10_f32"(
+      %logits : !t.tensor,
+      %labels : !t.tensor,
+      %loss : !t.tensor,
+      %backprop : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                       %backprop, %ch3)
+       : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+          !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_SoftmaxCrossEntropy_32x1000_f32'
+func @BM_SoftmaxCrossEntropy_32x1000_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [32, 1000].
+  %logits = dht.create_uninitialized_tensor.f32.2 [32 : i64, 1000 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  // Shape: [32, 1000].
+  %labels = dht.create_uninitialized_tensor.f32.2 [32 : i64, 1000 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %labels, %ch0 0.1 : f32
+
+  // Shape: [32].
+  %loss = dht.create_uninitialized_tensor.f32.1 [32 : i64]
+
+  // Shape: [32, 1000].
+  %backprop = dht.create_uninitialized_tensor.f32.2 [32 : i64, 1000 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_SoftmaxCrossEntropy_32x1000_f32"(
+      %logits : !t.tensor,
+      %labels : !t.tensor,
+      %loss : !t.tensor,
+      %backprop : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                       %backprop, %ch3)
+       : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+          !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'BM_SoftmaxCrossEntropy_256x1000_f32'
+func @BM_SoftmaxCrossEntropy_256x1000_f32() {
+  %ch0 = hex.new.chain
+
+  // Shape: [256, 1000].
+  %logits = dht.create_uninitialized_tensor.f32.2 [256 : i64, 1000 : i64]
+  %ch1 = dht.fill_tensor_with_constant.f32 %logits, %ch0 1.0 : f32
+
+  // Shape: [256, 1000].
+  %labels = dht.create_uninitialized_tensor.f32.2 [256 : i64, 1000 : i64]
+  %ch2 = dht.fill_tensor_with_constant.f32 %labels, %ch0 0.1 : f32
+
+  // Shape: [256].
+  %loss = dht.create_uninitialized_tensor.f32.1 [256 : i64]
+
+  // Shape: [256, 1000].
+  %backprop = dht.create_uninitialized_tensor.f32.2 [256 : i64, 1000 : i64]
+  %ch3 = hex.merge.chains %ch1, %ch2
+
+  tfrt_test.benchmark "BM_SoftmaxCrossEntropy_256x1000_f32"(
+      %logits : !t.tensor,
+      %labels : !t.tensor,
+      %loss : !t.tensor,
+      %backprop : !t.tensor,
+      %ch3 : !hex.chain)
+  duration_secs = 5, max_count = 100000, num_warmup_runs = 1000
+  {
+      %ch_out = "tfrt_test.softmax_cross_entropy.f32"(%logits, %labels, %loss,
+                                                       %backprop, %ch3)
+       : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+          !hex.chain) -> !hex.chain
+
+      hex.return %ch_out : !hex.chain
+  }
+
+  hex.return
+}
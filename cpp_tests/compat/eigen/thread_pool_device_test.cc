@@ -0,0 +1,154 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- thread_pool_device_test.cc -------------------------------*- C++ -*-===//
+//
+// Unit test for the Eigen allocator that wraps HostContext.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/common/compat/eigen/thread_pool_device.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+
+namespace tfrt {
+namespace compat {
+namespace {
+
+// Counts the allocations and the allocated bytes of the wrapped allocator.
+class CountingAllocator : public HostAllocator {
+ public:
+  explicit CountingAllocator(std::unique_ptr<HostAllocator> allocator)
+      : allocator_(std::move(allocator)) {}
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    num_allocations_.fetch_add(1);
+    allocated_bytes_.fetch_add(size);
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    allocated_bytes_.fetch_sub(size);
+    allocator_->DeallocateBytes(ptr, size);
+  }
+
+  int num_allocations() const { return num_allocations_.load(); }
+  size_t allocated_bytes() const { return allocated_bytes_.load(); }
+
+ private:
+  std::unique_ptr<HostAllocator> allocator_;
+  std::atomic<int> num_allocations_{0};
+  std::atomic<size_t> allocated_bytes_{0};
+};
+
+class EigenAllocatorTest : public ::testing::Test {
+ protected:
+  EigenAllocatorTest() {
+    auto allocator =
+        std::make_unique<CountingAllocator>(CreateMallocAllocator());
+    allocator_ = allocator.get();
+    host_ = std::make_unique<HostContext>([](const DecodedDiagnostic&) {},
+                                          std::move(allocator),
+                                          CreateMultiThreadedWorkQueue(2, 2));
+  }
+
+  CountingAllocator* allocator_;
+  std::unique_ptr<HostContext> host_;
+};
+
+constexpr size_t kMiB = 1024 * 1024;
+
+TEST_F(EigenAllocatorTest, ReusesFreedBuffers) {
+  EigenHostContext eigen(host_.get());
+  const Eigen::ThreadPoolDevice& device = eigen.Device();
+
+  void* buffer = device.allocate(kMiB);
+  device.deallocate(buffer);
+  const int num_allocations = allocator_->num_allocations();
+
+  // A request of the same or a slightly smaller size reuses the buffer.
+  void* reused = device.allocate(kMiB - 128);
+  EXPECT_EQ(reused, buffer);
+  EXPECT_EQ(allocator_->num_allocations(), num_allocations);
+
+  // The buffer is in use, so the next request allocates a new buffer.
+  void* other = device.allocate(kMiB);
+  EXPECT_NE(other, reused);
+  EXPECT_EQ(allocator_->num_allocations(), num_allocations + 1);
+
+  // A cached buffer more than twice larger than the request is not reused.
+  device.deallocate(other);
+  void* small = device.allocate(kMiB / 4);
+  EXPECT_NE(small, other);
+  EXPECT_EQ(allocator_->num_allocations(), num_allocations + 2);
+
+  device.deallocate(small);
+  device.deallocate(reused);
+}
+
+TEST_F(EigenAllocatorTest, BoundsCachedBytes) {
+  constexpr size_t kMaxCachedBytes =
+      EigenHostContext::kMaxAllocatorCachedBytes;
+  constexpr size_t kBufferSize = 4 * kMiB;
+  constexpr int kNumThreads = 8;
+  constexpr int kNumBuffers = 4;
+
+  EigenHostContext eigen(host_.get());
+  const Eigen::ThreadPoolDevice& device = eigen.Device();
+  const size_t allocated_bytes = allocator_->allocated_bytes();
+
+  // Threads use different caches, but all of them share the cached bytes
+  // budget, so buffers that do not fit are released when freed.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      std::vector<void*> buffers;
+      for (int j = 0; j < kNumBuffers; ++j)
+        buffers.push_back(device.allocate(kBufferSize));
+      for (void* buffer : buffers) device.deallocate(buffer);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Every cached buffer has a small header.
+  const size_t max_cached_buffers = kMaxCachedBytes / kBufferSize;
+  EXPECT_LE(allocator_->allocated_bytes() - allocated_bytes,
+            kMaxCachedBytes + max_cached_buffers * 1024);
+}
+
+TEST_F(EigenAllocatorTest, ReleasesCachedBuffers) {
+  const size_t allocated_bytes = allocator_->allocated_bytes();
+  {
+    EigenHostContext eigen(host_.get());
+    const Eigen::ThreadPoolDevice& device = eigen.Device();
+    void* buffer = device.allocate(kMiB);
+    device.deallocate(buffer);
+    EXPECT_GE(allocator_->allocated_bytes() - allocated_bytes, kMiB);
+  }
+  EXPECT_EQ(allocator_->allocated_bytes(), allocated_bytes);
+}
+
+}  // namespace
+}  // namespace compat
+}  // namespace tfrt
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- concurrent_work_queue_test.cc ----------------------------*- C++ -*-===//
+//
+// Unit test for TFRT concurrent work queues.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/host_context/concurrent_work_queue.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/mutex.h"
+
+namespace tfrt {
+
+std::unique_ptr<HostContext> CreateTestHostContext(
+    std::unique_ptr<ConcurrentWorkQueue> work_queue) {
+  return std::make_unique<HostContext>([](const DecodedDiagnostic&) {},
+                                       CreateMallocAllocator(),
+                                       std::move(work_queue));
+}
+
+TEST(ConcurrentWorkQueueTest, MultiThreadedWorkerThreadId) {
+  auto host = CreateTestHostContext(CreateMultiThreadedWorkQueue(4, 4));
+
+  // Host thread is not a worker thread.
+  ASSERT_EQ(host->GetCurrentWorkerThreadId(), -1);
+
+  const int num_tasks = 100;
+  latch barrier(num_tasks);
+  mutex mu;
+  std::vector<int> thread_ids;
+
+  for (int i = 0; i < num_tasks; ++i) {
+    host->EnqueueWork([&]() {
+      const int thread_id = host->GetCurrentWorkerThreadId();
+      {
+        mutex_lock lock(mu);
+        thread_ids.push_back(thread_id);
+      }
+      barrier.count_down();
+    });
+  }
+
+  barrier.wait();
+
+  ASSERT_EQ(thread_ids.size(), num_tasks);
+  for (int thread_id : thread_ids) {
+    ASSERT_GE(thread_id, 0);
+    ASSERT_LT(thread_id, host->GetNumWorkerThreads());
+  }
+}
+
+TEST(ConcurrentWorkQueueTest, BlockingWorkIsNotWorkerThread) {
+  auto host = CreateTestHostContext(CreateMultiThreadedWorkQueue(4, 4));
+
+  latch barrier(1);
+  int thread_id = 0;
+
+  bool enqueued = host->EnqueueBlockingWork([&]() {
+    thread_id = host->GetCurrentWorkerThreadId();
+    barrier.count_down();
+  });
+  ASSERT_TRUE(enqueued);
+
+  barrier.wait();
+  ASSERT_EQ(thread_id, -1);
+}
+
+TEST(ConcurrentWorkQueueTest, SingleThreadedWorkerThreadId) {
+  auto host = CreateTestHostContext(CreateSingleThreadedWorkQueue());
+
+  int thread_id = 0;
+  host->EnqueueWork([&]() { thread_id = host->GetCurrentWorkerThreadId(); });
+  host->Quiesce();
+
+  ASSERT_EQ(thread_id, -1);
+}
+
+}  // namespace tfrt
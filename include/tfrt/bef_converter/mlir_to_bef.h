@@ -36,10 +36,16 @@ namespace tfrt {
 // compatible program to the BinaryExecutableFormat (BEF) format, which is the
 // low level format that the executor takes.
 //
+// If `inline_call_threshold` is non-zero, hex.call ops whose callee has at most
+// that many kernels are replaced by the callee body before conversion. This
+// modifies `module`. Inlined kernels no longer wait for all the call arguments
+// to be available.
+//
 // On error, this emits the error message through the MLIR error handler, and
 // returns an empty std:vector.
 std::vector<uint8_t> ConvertMLIRToBEF(mlir::ModuleOp module,
-                                      bool disable_optional_sections);
+                                      bool disable_optional_sections,
+                                      unsigned inline_call_threshold = 0);
 
 }  // namespace tfrt
 
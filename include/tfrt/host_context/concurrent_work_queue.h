@@ -113,6 +113,13 @@ class ConcurrentWorkQueue {
   // TODO(clattner): this is a terrible name.
   virtual int GetParallelismLevel() const = 0;
 
+  // Return the index of the caller thread in the [0, GetParallelismLevel())
+  // range if it is one of the non-blocking worker threads managed by this work
+  // queue, and -1 otherwise (e.g. for the host donor thread and the threads
+  // running blocking work). Indices are stable for the work queue lifetime, and
+  // can be used to index per thread data.
+  virtual int GetCurrentWorkerThreadId() const { return -1; }
+
   ConcurrentWorkQueue() = default;
 
  private:
@@ -215,6 +215,11 @@ class HostContext {
   // created to handle blocking work (enqueued by EnqueueBlockingWork).
   int GetNumWorkerThreads() const;
 
+  // Returns the index of the caller thread in the [0, GetNumWorkerThreads())
+  // range if it is one of the worker threads in the work_queue managed by this
+  // CPU device, and -1 otherwise.
+  int GetCurrentWorkerThreadId() const;
+
   // Run the specified function when the specified set of AsyncValue's are all
   // resolved.  This is a set-version of "AndThen".
   void RunWhenReady(ArrayRef<AsyncValue*> values,
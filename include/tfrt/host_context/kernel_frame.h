@@ -24,6 +24,7 @@
 #ifndef TFRT_HOST_CONTEXT_KERNEL_CONTEXT_H_
 #define TFRT_HOST_CONTEXT_KERNEL_CONTEXT_H_
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -84,17 +85,15 @@ class KernelFrame {
 
   // Get all attributes.
   ArrayRef<const void*> GetAttributes() const {
-    if (async_value_or_attrs_.empty()) return {};
+    if (num_attributes_ == 0) return {};
 
     return llvm::makeArrayRef(
         &async_value_or_attrs_[num_arguments_ + num_results_].attr,
-        GetNumAttributes());
+        num_attributes_);
   }
 
   // Get the number of attributes.
-  int GetNumAttributes() const {
-    return async_value_or_attrs_.size() - num_arguments_ - num_results_;
-  }
+  int GetNumAttributes() const { return num_attributes_; }
 
   // Get the attribute at the given index as type T.
   // TODO(jingdong): Disable const char*.
@@ -217,11 +216,22 @@ class KernelFrame {
                    int num_results) const;
 
  protected:
+  // The frame contents are owned by the caller and reused for the next kernel,
+  // so a copy must not outlive the kernel call. Use RAIIKernelFrame to keep the
+  // frame contents in asynchronous work.
+  KernelFrame(const KernelFrame&) = default;
+  KernelFrame& operator=(const KernelFrame&) = default;
+
   union AsyncValueOrAttribute {
     AsyncValue* async_value;
     const void* attr;
   };
 
+  // Get the number of arguments, results and attributes.
+  int GetFrameSize() const {
+    return num_arguments_ + std::max(num_results_, 0) + num_attributes_;
+  }
+
   ArrayRef<AsyncValue*> GetAsyncValues(size_t from, size_t length) const {
     assert((from + length) <= (num_arguments_ + num_results_));
 
@@ -241,13 +251,14 @@ class KernelFrame {
                                      length);
   }
 
-  // This SmallVector stores the kernel argument AsyncValues, result
-  // AsyncValues, and attributes in order.
-  SmallVector<AsyncValueOrAttribute, 8> async_value_or_attrs_;
+  // This points to the kernel argument AsyncValues, result AsyncValues, and
+  // attributes in order. The storage is owned by the subclass.
+  AsyncValueOrAttribute* async_value_or_attrs_ = nullptr;
   int num_arguments_ = 0;
   // num_results is set to -1 so we can check that AddAttribute() is called
   // after SetNumResults.
   int num_results_ = -1;
+  int num_attributes_ = 0;
   ArrayRef<uint8_t> attribute_section_;
   ExecutionContext exec_ctx_;
 };
@@ -256,14 +267,23 @@ class KernelFrame {
 // object without exposing the builder methods to the kernel implementation.
 //
 // As an optimization, KernelFrame stores arguments, attributes, and results in
-// a single SmallVector. As a result, to initialize a KernelFrame, this class
+// a single buffer. The buffer is sized once with the largest frame the builder
+// will be used for (see the max_frame_size constructor argument), so adding
+// values does not check for growth. To initialize a KernelFrame, this class
 // requires that the client performs the following actions in order:
 // 1. Adds the arguments (using AddArg()),
 // 2. Set the number of results (using SetNumResults())
 // 3. Add the attributes (using AddAttribute())
 class KernelFrameBuilder : public KernelFrame {
  public:
-  explicit KernelFrameBuilder(HostContext* host) : KernelFrame{host} {}
+  KernelFrameBuilder(HostContext* host, size_t max_frame_size)
+      : KernelFrame{host} {
+    storage_.resize(max_frame_size);
+    async_value_or_attrs_ = storage_.data();
+  }
+
+  KernelFrameBuilder(const KernelFrameBuilder&) = delete;
+  KernelFrameBuilder& operator=(const KernelFrameBuilder&) = delete;
 
   // Get result AsyncValue at the given index.
   AsyncValue* GetResultAt(int index) const { return GetResults()[index]; }
@@ -276,27 +296,27 @@ class KernelFrameBuilder : public KernelFrame {
   void AddArg(AsyncValue* async_value) {
     assert(num_results_ == -1 &&
            "Must call AddArg before calling SetNumResults");
-    AsyncValueOrAttribute value;
-    value.async_value = async_value;
-    async_value_or_attrs_.push_back(value);
-    ++num_arguments_;
+    assert(static_cast<size_t>(num_arguments_) < storage_.size() &&
+           "KernelFrame is too small");
+    async_value_or_attrs_[num_arguments_++].async_value = async_value;
   }
 
   // Add a new attribute to the KernelFrame.
   void AddAttribute(const void* attr) {
     assert(num_results_ != -1 &&
            "Must call SetNumResults before calling AddAttribute");
-    AsyncValueOrAttribute value;
-    value.attr = attr;
-    async_value_or_attrs_.push_back(value);
+    assert(static_cast<size_t>(GetFrameSize()) < storage_.size() &&
+           "KernelFrame is too small");
+    async_value_or_attrs_[GetFrameSize()].attr = attr;
+    ++num_attributes_;
   }
 
   // Set the number of results expected.
   void SetNumResults(size_t n) {
-    assert(num_arguments_ == async_value_or_attrs_.size());
     assert(num_results_ == -1);
+    assert(num_arguments_ + n <= storage_.size() && "KernelFrame is too small");
     num_results_ = n;
-    async_value_or_attrs_.resize(async_value_or_attrs_.size() + n);
+    for (auto& result : GetResults()) result = nullptr;
   }
 
   // Set the location.
@@ -306,33 +326,68 @@ class KernelFrameBuilder : public KernelFrame {
 
   // Clear all fields.
   void Reset() {
-    async_value_or_attrs_.clear();
     num_arguments_ = 0;
     num_results_ = -1;
+    num_attributes_ = 0;
   }
+
+ private:
+  SmallVector<AsyncValueOrAttribute, 16> storage_;
 };
 
 // RAIIKernelFrame is like KernelFrame, but adds a ref to each contained value
 // upon construction, and drops the refs on destruction. This is useful when
 // implementing async kernels.
+//
+// The frame contents are copied because the caller reuses its buffer for the
+// next kernel. Small frames are copied inline, larger ones to memory from the
+// HostContext allocator.
 class RAIIKernelFrame : public KernelFrame {
  public:
   RAIIKernelFrame() = delete;
   RAIIKernelFrame(const KernelFrame& frame) : KernelFrame(frame) {
+    CopyFrame();
     AddRefAll();
   }
 
   RAIIKernelFrame(const RAIIKernelFrame& that) : KernelFrame(that) {
+    CopyFrame();
     AddRefAll();
   }
-  RAIIKernelFrame(RAIIKernelFrame&& that) : KernelFrame(std::move(that)) {}
+  RAIIKernelFrame(RAIIKernelFrame&& that) : KernelFrame(that) {
+    if (that.async_value_or_attrs_ == that.inline_storage_) {
+      std::copy_n(that.inline_storage_, GetFrameSize(), inline_storage_);
+      async_value_or_attrs_ = inline_storage_;
+    }
+    that.async_value_or_attrs_ = nullptr;
+  }
+
+  RAIIKernelFrame& operator=(const RAIIKernelFrame&) = delete;
+  RAIIKernelFrame& operator=(RAIIKernelFrame&&) = delete;
 
   ~RAIIKernelFrame() {
-    // async_value_or_attrs_ is empty when this object has been moved from.
-    if (!async_value_or_attrs_.empty()) DropRefAll();
+    // async_value_or_attrs_ is null when this object has been moved from.
+    if (async_value_or_attrs_ == nullptr) return;
+    DropRefAll();
+    if (async_value_or_attrs_ != inline_storage_)
+      GetHostContext()->Deallocate(async_value_or_attrs_, GetFrameSize());
   }
 
  private:
+  static constexpr int kInlineFrameSize = 8;
+
+  // Copy the frame contents that async_value_or_attrs_ points to into storage
+  // owned by this object.
+  void CopyFrame() {
+    const AsyncValueOrAttribute* values = async_value_or_attrs_;
+    async_value_or_attrs_ =
+        GetFrameSize() <= kInlineFrameSize
+            ? inline_storage_
+            : GetHostContext()->Allocate<AsyncValueOrAttribute>(
+                  GetFrameSize());
+    std::copy_n(values, GetFrameSize(), async_value_or_attrs_);
+  }
+
   // Increment the refcounts of all arguments and results.
   void AddRefAll() const {
     for (auto* v : GetAsyncValues(0, num_arguments_ + num_results_)) {
@@ -346,6 +401,8 @@ class RAIIKernelFrame : public KernelFrame {
       v->DropRef();
     }
   }
+
+  AsyncValueOrAttribute inline_storage_[kInlineFrameSize];
 };
 
 // Implementation details
@@ -178,6 +178,11 @@ class BEFKernel {
     return result_table_[result_number];
   }
 
+  // Return the number of used_bys of each result.
+  ArrayRef<uint32_t> GetNumUsedBys() const {
+    return llvm::makeArrayRef(result_table_, header_->num_results);
+  }
+
   // Return num_entries kernel entries starting at offset.
   ArrayRef<uint32_t> GetKernelEntries(int offset, int num_entries) const {
     return llvm::makeArrayRef(body_start_ + offset, num_entries);
@@ -18,10 +18,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_frame.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/rc_array.h"
 #include "tfrt/support/ref_count.h"
 
@@ -303,6 +308,332 @@ static void HexRepeatI32(RemainingArguments args, RemainingResults results,
   }
 }
 
+// Runs `fn` on the `lhs` and `rhs` values and returns its results.
+static SmallVector<RCReference<AsyncValue>, 4> HexParallelForReduce(
+    const Function& fn, ArrayRef<RCReference<AsyncValue>> lhs,
+    ArrayRef<RCReference<AsyncValue>> rhs, HostContext* host) {
+  SmallVector<AsyncValue*, 8> args;
+  for (auto& value : lhs) args.push_back(value.get());
+  for (auto& value : rhs) args.push_back(value.get());
+
+  SmallVector<RCReference<AsyncValue>, 4> results;
+  results.resize(lhs.size());
+  fn.Execute(args, results, host);
+  return results;
+}
+
+// This is a helper function that runs all iterations of hex.parallel_for.i32
+// once the trip count is available.
+static void HexParallelForI32Impl(
+    int32_t count_value, HostContext* host,
+    RCReference<const Function> body_fn_ref,
+    RCReference<const Function> reduce_fn_ref, RCArray<AsyncValue> args,
+    SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs) {
+  const size_t num_results = result_refs.size();
+
+  // Special case: "parallel_for 0" just copies initial values to results.
+  if (count_value <= 0) {
+    for (size_t i = 0; i != num_results; ++i) {
+      result_refs[i]->ForwardTo(FormRef(args[i]));
+    }
+    return;
+  }
+
+  // Split iterations into a few blocks per worker thread to balance the load.
+  // Every block is reduced sequentially, and block results are reduced in the
+  // order of the blocks when all blocks are launched.
+  const size_t num_threads = std::max(1, host->GetNumWorkerThreads());
+  const size_t block_size =
+      std::max<size_t>(1, (count_value + 4 * num_threads - 1) /
+                              (4 * num_threads));
+  const size_t num_blocks = (count_value + block_size - 1) / block_size;
+
+  struct ParallelForContext {
+    RCReference<const Function> body_fn;
+    RCReference<const Function> reduce_fn;
+    RCArray<AsyncValue> args;
+    SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs;
+    std::vector<SmallVector<RCReference<AsyncValue>, 4>> block_results;
+  };
+
+  auto ctx = std::make_unique<ParallelForContext>(ParallelForContext{
+      std::move(body_fn_ref), std::move(reduce_fn_ref), std::move(args),
+      std::move(result_refs),
+      std::vector<SmallVector<RCReference<AsyncValue>, 4>>(num_blocks)});
+  ParallelForContext* ctx_ptr = ctx.get();
+
+  auto compute = [host, block_size, num_results, ctx = ctx_ptr](size_t begin,
+                                                                size_t end) {
+    // The body function takes the index and the loop invariant arguments.
+    SmallVector<AsyncValue*, 8> fn_args;
+    fn_args.push_back(nullptr);
+    for (auto* arg : ctx->args.values().drop_front(num_results)) {
+      fn_args.push_back(arg);
+    }
+
+    SmallVector<RCReference<AsyncValue>, 4> block_result;
+    SmallVector<RCReference<AsyncValue>, 4> results;
+    for (size_t i = begin; i < end; ++i) {
+      // Skip the remaining iterations if the host context is canceled.
+      if (host->GetCancelAsyncValue()) break;
+
+      auto index = host->MakeAvailableAsyncValueRef<int32_t>(i);
+      fn_args[0] = index.GetAsyncValue();
+
+      results.resize(num_results);
+      ctx->body_fn->Execute(fn_args, results, host);
+
+      if (block_result.empty()) {
+        block_result = std::move(results);
+      } else {
+        block_result =
+            HexParallelForReduce(*ctx->reduce_fn, block_result, results, host);
+      }
+      results.clear();
+    }
+
+    ctx->block_results[begin / block_size] = std::move(block_result);
+  };
+
+  auto on_done = [host, num_results, ctx = std::move(ctx)]() {
+    if (auto cancel_av = host->GetCancelAsyncValue()) {
+      for (auto& result : ctx->result_refs) {
+        result->ForwardTo(FormRef(cancel_av));
+      }
+      return;
+    }
+
+    SmallVector<RCReference<AsyncValue>, 4> results;
+    for (auto* init : ctx->args.values().take_front(num_results)) {
+      results.push_back(FormRef(init));
+    }
+    for (auto& block_result : ctx->block_results) {
+      if (num_results == 0) break;
+      results =
+          HexParallelForReduce(*ctx->reduce_fn, results, block_result, host);
+    }
+
+    for (size_t i = 0; i != num_results; ++i) {
+      ctx->result_refs[i]->ForwardTo(std::move(results[i]));
+    }
+  };
+
+  ParallelFor(host).Execute(count_value,
+                            ParallelFor::BlockSizes::Fixed(block_size),
+                            std::move(compute), std::move(on_done));
+}
+
+// hex.parallel_for.i32 runs a body function for every index in [0, N), where
+// the iterations are independent of each other, and reduces their results.
+//
+// Arguments: The first argument is the i32 trip count N. The next arguments
+// are the initial values of the results, one per result, and any additional
+// arguments are passed to every invocation of the body function.
+//
+// Attributes: The first attribute is the body_fn, which takes the i32 index
+// and the additional arguments and returns values with the result types. The
+// second attribute is the reduce_fn, which takes two sets of result values and
+// combines them. reduce_fn must be associative, and it may be omitted if
+// hex.parallel_for.i32 has no results.
+//
+// Iterations run in blocks of consecutive indices in the work queue. Results
+// are reduced in the order of the indices, starting from the initial values,
+// so they do not depend on the scheduling of the blocks. If the host context
+// is canceled, remaining iterations are skipped and all results are set to the
+// cancel async value.
+static void HexParallelForI32(RemainingArguments args,
+                              RemainingResults results,
+                              Attribute<Function> body_fn_const,
+                              RemainingAttributes reduce_fn_const,
+                              const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  assert(args.size() > results.size() && "missing initial result values");
+  assert((results.size() == 0 || reduce_fn_const.size() == 1) &&
+         "reduce_fn is required for hex.parallel_for.i32 with results");
+
+  RCReference<const Function> body_fn_ref = FormRef(&(*body_fn_const));
+  RCReference<const Function> reduce_fn_ref;
+  if (reduce_fn_const.size() > 0) {
+    reduce_fn_ref = FormRef(&(*reduce_fn_const.Get<Function>(0)));
+  }
+
+  assert(body_fn_ref->argument_types().size() ==
+             args.size() - results.size() &&
+         "argument count mismatch");
+  assert(body_fn_ref->result_types().size() == results.size() &&
+         "result count mismatch");
+
+  // Copy `args` and add a ref to each arg. These refs will be dropped when the
+  // RCArray is destroyed.
+  RCArray<AsyncValue> arg_refs(args.values());
+
+  // Define results as IndirectAsync values. The actual results are set when
+  // all iterations are reduced.
+  SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs;
+  result_refs.reserve(results.size());
+  for (int i = 0, e = results.size(); i != e; ++i) {
+    result_refs.push_back(results.AllocateIndirectResultAt(i));
+  }
+
+  auto parallel_for_impl =
+      [host](RCReference<const Function> body_fn_ref,
+             RCReference<const Function> reduce_fn_ref,
+             RCArray<AsyncValue> arg_refs,
+             SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs) {
+        auto* count = arg_refs[0];
+
+        // If we have an error, then we can force propagate errors to all the
+        // results.
+        if (count->IsError()) {
+          for (auto& result : result_refs) {
+            result->ForwardTo(FormRef(count));
+          }
+          return;
+        }
+
+        HexParallelForI32Impl(
+            count->get<int32_t>(), host, std::move(body_fn_ref),
+            std::move(reduce_fn_ref),
+            RCArray<AsyncValue>(arg_refs.values().drop_front()),
+            std::move(result_refs));
+      };
+
+  // Dispatch when the trip count becomes available.
+  AsyncValue* count = args[0];
+  if (count->IsAvailable()) {
+    parallel_for_impl(std::move(body_fn_ref), std::move(reduce_fn_ref),
+                      std::move(arg_refs), std::move(result_refs));
+  } else {
+    count->AndThen([parallel_for_impl, body_fn_ref = std::move(body_fn_ref),
+                    reduce_fn_ref = std::move(reduce_fn_ref),
+                    arg_refs = std::move(arg_refs),
+                    result_refs = std::move(result_refs)]() mutable {
+      parallel_for_impl(std::move(body_fn_ref), std::move(reduce_fn_ref),
+                        std::move(arg_refs), std::move(result_refs));
+    });
+  }
+}
+
+// This is a helper function that runs hex.while iterations while their
+// conditions are available, and sets up a callback to continue when the
+// condition of the next iteration is not yet available.
+static void HexWhileLoop(
+    HostContext* host, RCReference<const Function> cond_fn_ref,
+    RCReference<const Function> body_fn_ref,
+    SmallVector<RCReference<AsyncValue>, 4> values,
+    RCReference<AsyncValue> condition,
+    SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs) {
+  SmallVector<AsyncValue*, 8> args;
+  SmallVector<RCReference<AsyncValue>, 1> cond_results;
+
+  while (true) {
+    if (auto cancel_av = host->GetCancelAsyncValue()) {
+      for (auto& result : result_refs) {
+        result->ForwardTo(FormRef(cancel_av));
+      }
+      return;
+    }
+
+    // Wait for the condition, without waiting for the loop-carried values
+    // that the condition does not depend on.
+    if (!condition->IsAvailable()) {
+      AsyncValue* condition_ptr = condition.get();
+      condition_ptr->AndThen([host, cond_fn_ref = std::move(cond_fn_ref),
+                              body_fn_ref = std::move(body_fn_ref),
+                              values = std::move(values),
+                              condition = std::move(condition),
+                              result_refs = std::move(result_refs)]() mutable {
+        HexWhileLoop(host, std::move(cond_fn_ref), std::move(body_fn_ref),
+                     std::move(values), std::move(condition),
+                     std::move(result_refs));
+      });
+      return;
+    }
+
+    // If we have an error, then we can force propagate errors to all the
+    // results.
+    if (condition->IsError()) {
+      for (auto& result : result_refs) {
+        result->ForwardTo(condition.CopyRef());
+      }
+      return;
+    }
+
+    // The loop is done, return the last loop-carried values.
+    if (!condition->get<bool>()) {
+      for (int i = 0, e = result_refs.size(); i != e; ++i) {
+        result_refs[i]->ForwardTo(std::move(values[i]));
+      }
+      return;
+    }
+
+    // Run the body, and start evaluating the next condition right away. Both
+    // functions dispatch their kernels as soon as their inputs are ready, so
+    // the next condition is evaluated while the parts of the body that it
+    // does not depend on are still running. The values of the previous
+    // iteration are released as soon as the body holds its own references.
+    args.clear();
+    for (auto& value : values) args.push_back(value.get());
+    SmallVector<RCReference<AsyncValue>, 4> next_values;
+    next_values.resize(values.size());
+    body_fn_ref->Execute(args, next_values, host);
+    values = std::move(next_values);
+
+    args.clear();
+    for (auto& value : values) args.push_back(value.get());
+    cond_results.resize(1);
+    cond_fn_ref->Execute(args, cond_results, host);
+    condition = std::move(cond_results[0]);
+    cond_results.clear();
+  }
+}
+
+// hex.while runs a body function while a condition function returns true.
+//
+// Arguments: The initial loop-carried values, which are passed to the
+// condition and body functions, and returned when the condition is false.
+//
+// Attributes: The first attribute is the body_fn, which takes the loop-carried
+// values and returns their next values. The second attribute is the cond_fn,
+// which takes the loop-carried values and returns an i1.
+//
+// Iterations are dispatched without waiting for the loop-carried values: only
+// the condition must be available to start the next iteration.
+static void HexWhile(RemainingArguments args, RemainingResults results,
+                     Attribute<Function> body_fn_const,
+                     Attribute<Function> cond_fn_const,
+                     const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  assert(args.size() == results.size() && "argument/result count mismatch");
+
+  const Function* body_fn = &(*body_fn_const);
+  const Function* cond_fn = &(*cond_fn_const);
+  assert(body_fn->argument_types() == body_fn->result_types() &&
+         "Argument and result types of while body_fn must match");
+  assert(cond_fn->argument_types() == body_fn->argument_types() &&
+         cond_fn->result_types().size() == 1 &&
+         "cond_fn must take the loop-carried values and return an i1");
+
+  SmallVector<RCReference<AsyncValue>, 4> values;
+  values.reserve(args.size());
+  for (auto* arg : args.values()) values.push_back(FormRef(arg));
+
+  // Define results as IndirectAsync values. The actual results are set when
+  // the condition is false.
+  SmallVector<RCReference<IndirectAsyncValue>, 4> result_refs;
+  result_refs.reserve(results.size());
+  for (int i = 0, e = results.size(); i != e; ++i) {
+    result_refs.push_back(results.AllocateIndirectResultAt(i));
+  }
+
+  SmallVector<RCReference<AsyncValue>, 1> condition;
+  condition.resize(1);
+  cond_fn->Execute(args.values(), condition, host);
+
+  HexWhileLoop(host, FormRef(cond_fn), FormRef(body_fn), std::move(values),
+               std::move(condition[0]), std::move(result_refs));
+}
+
 // This kernel takes a Chain and an AsyncValue. Then it returns the same
 // AsyncValue. A function can use this kernel to return a value that depends on
 // a given chain.
@@ -319,6 +650,8 @@ void RegisterControlFlowKernels(KernelRegistry* registry) {
   registry->AddKernel("hex.merge.chains", TFRT_KERNEL(HexMergeChains));
   registry->AddKernel("hex.alias.value", TFRT_KERNEL(HexAliasValue));
   registry->AddKernel("hex.repeat.i32", TFRT_KERNEL(HexRepeatI32));
+  registry->AddKernel("hex.parallel_for.i32", TFRT_KERNEL(HexParallelForI32));
+  registry->AddKernel("hex.while", TFRT_KERNEL(HexWhile));
   registry->AddKernel("hex.call", TFRT_KERNEL(HexCall));
   registry->AddKernel("hex.if", TFRT_KERNEL(HexIf));
 }
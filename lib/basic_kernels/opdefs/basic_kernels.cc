@@ -471,6 +471,110 @@ static LogicalResult verify(RepeatI32Op op) {
   return checkHexReturn(op, &op.region(), op.getResultTypes());
 }
 
+//===----------------------------------------------------------------------===//
+// ParallelForI32Op
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verify(ParallelForI32Op op) {
+  // Verify the initial values of the results.
+  unsigned numResults = op.getNumResults();
+  if (op.getNumOperands() < numResults + 1)
+    return op.emitOpError("requires an initial value for every result");
+
+  SmallVector<Type, 4> resultTypes(op.getResultTypes().begin(),
+                                   op.getResultTypes().end());
+  for (unsigned i = 0; i != numResults; ++i)
+    if (op.getOperand(i + 1).getType() != resultTypes[i])
+      return op.emitOpError("initial value/result type mismatch");
+
+  auto module = op.getParentOfType<ModuleOp>();
+
+  // The body function takes the index and the remaining operands, and returns
+  // values with the result types.
+  auto bodyFn = module.lookupSymbol<FuncOp>(op.body_fn());
+  if (!bodyFn)
+    return op.emitOpError() << "'" << op.body_fn()
+                            << "' does not reference a valid function";
+
+  SmallVector<Type, 4> bodyInputs;
+  for (unsigned i = 0, e = op.getNumOperands(); i != e; ++i)
+    if (i == 0 || i > numResults)
+      bodyInputs.push_back(op.getOperand(i).getType());
+
+  auto bodyType = bodyFn.getType();
+  if (bodyType.getInputs() != llvm::makeArrayRef(bodyInputs))
+    return op.emitOpError("body_fn argument type mismatch");
+  if (bodyType.getResults() != llvm::makeArrayRef(resultTypes))
+    return op.emitOpError("body_fn result type mismatch");
+
+  // The reduce function combines two sets of result values.
+  auto reduceFnName = op.reduce_fn();
+  if (!reduceFnName) {
+    if (numResults != 0)
+      return op.emitOpError("requires a 'reduce_fn' to combine the results");
+    return success();
+  }
+
+  auto reduceFn = module.lookupSymbol<FuncOp>(*reduceFnName);
+  if (!reduceFn)
+    return op.emitOpError() << "'" << *reduceFnName
+                            << "' does not reference a valid function";
+
+  SmallVector<Type, 8> reduceInputs(resultTypes.begin(), resultTypes.end());
+  reduceInputs.append(resultTypes.begin(), resultTypes.end());
+
+  auto reduceType = reduceFn.getType();
+  if (reduceType.getInputs() != llvm::makeArrayRef(reduceInputs))
+    return op.emitOpError("reduce_fn argument type mismatch");
+  if (reduceType.getResults() != llvm::makeArrayRef(resultTypes))
+    return op.emitOpError("reduce_fn result type mismatch");
+
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// WhileOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verify(WhileOp op) {
+  // Verify that the operand and result types match.
+  if (op.getNumResults() != op.getNumOperands())
+    return op.emitOpError("incorrect number of operands");
+
+  SmallVector<Type, 4> types(op.getOperandTypes());
+  for (unsigned i = 0, e = op.getNumResults(); i != e; ++i)
+    if (op.getResult(i).getType() != types[i])
+      return op.emitOpError("operand/result type mismatch");
+
+  auto module = op.getParentOfType<ModuleOp>();
+
+  // The body function maps the loop-carried values to their next values.
+  auto bodyFn = module.lookupSymbol<FuncOp>(op.body_fn());
+  if (!bodyFn)
+    return op.emitOpError() << "'" << op.body_fn()
+                            << "' does not reference a valid function";
+
+  auto bodyType = bodyFn.getType();
+  if (bodyType.getInputs() != llvm::makeArrayRef(types) ||
+      bodyType.getResults() != llvm::makeArrayRef(types))
+    return op.emitOpError("body_fn type mismatch");
+
+  // The condition function takes the loop-carried values and returns an i1.
+  auto condFn = module.lookupSymbol<FuncOp>(op.cond_fn());
+  if (!condFn)
+    return op.emitOpError() << "'" << op.cond_fn()
+                            << "' does not reference a valid function";
+
+  auto condType = condFn.getType();
+  if (condType.getInputs() != llvm::makeArrayRef(types))
+    return op.emitOpError("cond_fn argument type mismatch");
+  if (condType.getNumResults() != 1 ||
+      !condType.getResult(0).isInteger(1))
+    return op.emitOpError("cond_fn must return a single i1");
+
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // ReturnOp
 //===----------------------------------------------------------------------===//
@@ -29,6 +29,7 @@
 
 #include <cstring>
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
@@ -37,6 +38,8 @@
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Block.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Module.h"
 #include "mlir/IR/Operation.h"
@@ -1765,6 +1768,63 @@ void BEFModuleEmitter::EmitRegisterTypes(const BEFEmitter& register_types) {
   EmitSection(BEFSectionID::kRegisterTypes, register_types);
 }
 
+// Return true if calls to `fn` can be replaced by its body: it must be a
+// single block BEF function with at most `max_kernels` kernels.
+static bool IsInlinableFunction(mlir::FuncOp fn, unsigned max_kernels) {
+  if (IsNativeFunc(fn) || fn.isExternal() || fn.getBlocks().size() != 1)
+    return false;
+
+  auto& block = fn.getBlocks().front();
+  if (!IsReturn(&block.back())) return false;
+
+  // The return op is not emitted as a kernel.
+  return block.getOperations().size() - 1 <= max_kernels;
+}
+
+// Replace the hex.call ops that call functions with at most `max_kernels`
+// kernels by a copy of the callee body. This saves setting up a new BEF
+// executor for every call of a small helper function.
+//
+// Calls in the inlined bodies are not inlined again, so recursive functions
+// are expanded at most once per call site.
+static void InlineSmallFunctionCalls(mlir::ModuleOp module,
+                                     unsigned max_kernels) {
+  llvm::SmallVector<mlir::Operation*, 16> calls;
+  module.walk([&](mlir::Operation* op) {
+    if (op->getName().getStringRef() == "hex.call") calls.push_back(op);
+  });
+
+  for (auto* call : calls) {
+    auto callee_attr = call->getAttrOfType<mlir::FlatSymbolRefAttr>("callee");
+    if (!callee_attr) continue;
+
+    auto callee = module.lookupSymbol<mlir::FuncOp>(callee_attr.getValue());
+    if (!callee || !IsInlinableFunction(callee, max_kernels)) continue;
+
+    // Cloning a function into itself would visit the cloned ops again.
+    if (call->getParentOfType<mlir::FuncOp>() == callee) continue;
+
+    auto& body = callee.getBlocks().front();
+    auto* return_op = &body.back();
+    if (body.getNumArguments() != call->getNumOperands() ||
+        return_op->getNumOperands() != call->getNumResults())
+      continue;
+
+    mlir::BlockAndValueMapping mapping;
+    for (auto it : llvm::zip(body.getArguments(), call->getOperands()))
+      mapping.map(std::get<0>(it), std::get<1>(it));
+
+    mlir::OpBuilder builder(call);
+    for (auto& op : body.without_terminator()) builder.clone(op, mapping);
+
+    for (auto it : llvm::zip(call->getResults(), return_op->getOperands()))
+      std::get<0>(it).replaceAllUsesWith(
+          mapping.lookupOrDefault(std::get<1>(it)));
+
+    call->erase();
+  }
+}
+
 // This function converts the specified MLIR module containing a host executor
 // compatible program to the BinaryExecutableFormat (BEF) format, which is the
 // low level format that the executor takes.
@@ -1772,7 +1832,11 @@ void BEFModuleEmitter::EmitRegisterTypes(const BEFEmitter& register_types) {
 // On error, this emits the error message through the MLIR error handler, and
 // returns an empty std:vector.
 std::vector<uint8_t> ConvertMLIRToBEF(mlir::ModuleOp module,
-                                      bool disable_optional_sections) {
+                                      bool disable_optional_sections,
+                                      unsigned inline_call_threshold) {
+  if (inline_call_threshold > 0)
+    InlineSmallFunctionCalls(module, inline_call_threshold);
+
   BEFModuleEmitter emitter(module);
 
   // Build the entities table.
@@ -30,13 +30,20 @@ static llvm::cl::opt<bool> disable_optional_sections(  // NOLINT
                    "types and attribute names."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned> inline_call_threshold(  // NOLINT
+    "inline-call-threshold",
+    llvm::cl::desc("Inline hex.call ops whose callee has at most this many "
+                   "kernels. Zero disables inlining."),
+    llvm::cl::init(0));
+
 namespace tfrt {
 namespace {
 
 mlir::LogicalResult ConvertMLIRToBEFTranslation(mlir::ModuleOp module,
                                                 llvm::raw_ostream& output) {
   std::vector<uint8_t> bef_file =
-      tfrt::ConvertMLIRToBEF(module, disable_optional_sections);
+      tfrt::ConvertMLIRToBEF(module, disable_optional_sections,
+                             inline_call_threshold);
   if (bef_file.empty()) return mlir::failure();
 
   // Success!
@@ -190,17 +190,17 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
 
  private:
   BEFExecutor(BEFFileImpl* bef_file, HostContext* host,
-              ArrayRef<uint32_t> kernels,
+              ArrayRef<DecodedKernel> kernels,
               HostArray<BEFFileImpl::KernelInfo> kernel_infos,
               HostArray<BEFFileImpl::RegisterInfo> register_infos,
-              bool has_arguments_pseudo_kernel);
+              size_t max_kernel_frame_size, bool has_arguments_pseudo_kernel);
   ~BEFExecutor();
 
  private:
   void DecrementArgumentsNotReadyCounts(SmallVectorImpl<unsigned>* kernel_ids);
   void ProcessArgumentsPseudoKernel(SmallVectorImpl<unsigned>* kernel_ids);
-  void ProcessUsedBys(const BEFKernel& kernel, int result_number,
-                      AsyncValue* result, int* entry_offset,
+  void ProcessUsedBys(const DecodedKernel& kernel, int result_number,
+                      AsyncValue* result, int* used_by_offset,
                       SmallVectorImpl<unsigned>* kernel_ids);
   void MaybeAddRefForResult(AsyncValue* result);
   HostContext* GetHost() const { return location_handler_->GetHost(); }
@@ -212,8 +212,9 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   /// running stuff.
   RCReference<BEFFileImpl> bef_file_;
 
-  // This ArrayRef contains kernel entries of all kernels of this function.
-  ArrayRef<uint32_t> kernels_;
+  // This ArrayRef contains the decoded kernels of this function, indexed by the
+  // kernel number.
+  ArrayRef<DecodedKernel> kernels_;
 
   /// This is an array of descriptors for all of the kernels in this function,
   /// indexed by the kernel number.
@@ -223,6 +224,10 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   /// register number.
   HostArray<BEFFileImpl::RegisterInfo> register_infos_;
 
+  // The largest number of arguments, results and attributes of any kernel in
+  // this function. This sizes the KernelFrame used to call the kernels.
+  size_t max_kernel_frame_size_;
+
   // Make sure location handler is alive as long as there is pending execution.
   RCReference<BEFLocationHandler> location_handler_;
 };
@@ -235,20 +240,22 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
 // users, it will be skipped. If the kernel immediately completed a result, then
 // we can mark all kernels using it as ready to go, otherwise we need to enqueue
 // them on their unavailable operands.
-void BEFExecutor::ProcessUsedBys(const BEFKernel& kernel, int result_number,
-                                 AsyncValue* result, int* entry_offset,
+void BEFExecutor::ProcessUsedBys(const DecodedKernel& kernel, int result_number,
+                                 AsyncValue* result, int* used_by_offset,
                                  SmallVectorImpl<unsigned>* kernel_ids) {
   // Find used_by entries for this result.
-  auto num_used_bys = kernel.num_used_bys(result_number);
+  assert(result_number < kernel.num_results);
+  auto num_used_bys = kernel.num_used_bys[result_number];
   // Skip current result if there is no user.
   if (num_used_bys == 0) {
     MaybeAddRefForResult(result);
     return;
   }
 
-  auto used_bys = kernel.GetKernelEntries(*entry_offset, num_used_bys);
-  // Move entry offset to used_bys for next result.
-  *entry_offset += num_used_bys;
+  auto used_bys =
+      llvm::makeArrayRef(kernel.used_bys + *used_by_offset, num_used_bys);
+  // Move used_by offset to used_bys for next result.
+  *used_by_offset += num_used_bys;
 
   assert(!used_bys.empty());
 
@@ -328,18 +335,15 @@ void BEFExecutor::ProcessArgumentsPseudoKernel(
   // Remove the first kernel that is argument pseudo kernel.
   kernel_ids->pop_back();
 
-  BEFKernel kernel(kernels_.data());
+  const DecodedKernel& kernel = kernels_[0];
 
-  assert(kernel.num_arguments() == 0);
-  assert(kernel.num_attributes() == 0);
-  assert(kernel.num_functions() == 0);
-  assert(kernel.num_results() != 0);
+  assert(kernel.num_arguments == 0);
+  assert(kernel.num_attributes == 0);
+  assert(kernel.num_results != 0);
 
-  // The kernel body of argument pseudo kernel contains only results and
-  // used_bys.
-  auto results = kernel.GetKernelEntries(0, kernel.num_results());
-  // Move offset to the start of used_bys.
-  int used_by_offset = results.size();
+  // The argument pseudo kernel has only results and used_bys.
+  auto results = kernel.GetResults();
+  int used_by_offset = 0;
   for (int result_number = 0; result_number < results.size(); ++result_number) {
     auto& result_register = register_infos_[results[result_number]];
     // TODO(chky): mlir_to_bef should not emit used args.
@@ -368,7 +372,7 @@ void BEFExecutor::MaybeAddRefForResult(AsyncValue* result) {
 /// from the end of the vector to the start - worklist style.
 void BEFExecutor::DecrementArgumentsNotReadyCounts(
     SmallVectorImpl<unsigned>* kernel_ids) {
-  KernelFrameBuilder kernel_frame(GetHost());
+  KernelFrameBuilder kernel_frame(GetHost(), max_kernel_frame_size_);
   kernel_frame.SetAttributeSection(bef_file_->attribute_section_);
 
   MutableArrayRef<BEFFileImpl::KernelInfo>& kernel_infos =
@@ -382,9 +386,7 @@ void BEFExecutor::DecrementArgumentsNotReadyCounts(
     // done with the kernel.
     if (kernel_infos[kernel_id].arguments_not_ready.fetch_sub(1) != 1) continue;
 
-    assert(kernel_infos[kernel_id].offset % kKernelEntryAlignment == 0);
-    BEFKernel kernel(kernels_.data() +
-                     kernel_infos[kernel_id].offset / kKernelEntryAlignment);
+    const DecodedKernel& kernel = kernels_[kernel_id];
 
     // Keep track of whether we saw any error arguments. If so, we propagate the
     // error to the results automatically. Initialize it with the cancel async
@@ -395,71 +397,41 @@ void BEFExecutor::DecrementArgumentsNotReadyCounts(
     // registers, result registers, and attributes should be passed.
     kernel_frame.Reset();
 
-    // Find the kernel implementation of this kernel.
-    KernelImplementation kernel_fn = bef_file_->kernels_[kernel.kernel_code()];
-    assert(kernel_fn != nullptr);
-
-    // Check the low bit of special_metadata, which indicates if the kernel
-    // is non-strict.
-    bool is_nonstrict_kernel =
-        static_cast<bool>(kernel.special_metadata() &
-                          static_cast<uint32_t>(SpecialAttribute::kNonStrict));
+    assert(kernel.implementation != nullptr);
     DEBUG_PRINT("Run %skernel %u %s\n",
-                is_nonstrict_kernel ? "non-strict " : "", kernel_id,
-                bef_file_->GetKernelName(kernel.kernel_code()));
+                kernel.is_nonstrict ? "non-strict " : "", kernel_id,
+                bef_file_->GetKernelName(kernel.kernel_code));
 
     // Set up operands.
-    int entry_offset = 0;
-    auto arguments =
-        kernel.GetKernelEntries(entry_offset, kernel.num_arguments());
-    for (auto reg_idx : arguments) {
+    for (auto reg_idx : kernel.GetArguments()) {
       BEFFileImpl::RegisterInfo& reg = register_infos_[reg_idx];
 
       // The argument register may not be available if this is a non-strict
       // kernel that is starting before all operands are available. In that
       // case, we use an IndirectAsyncValue so it can be resolved later.
       AsyncValue* value = GetOrCreateRegisterValue(&reg, GetHost());
-      // TODO(b/142757465): remove arguments_and_results_ vector in KernelFrame.
       kernel_frame.AddArg(value);
       if (value->IsError()) any_error_argument = value;
     }
 
-    // TODO(b/142757465): remove arguments_and_results_ vector in KernelFrame.
-    kernel_frame.SetNumResults(kernel.num_results());
-
-    // Set up attributes.
-    entry_offset += arguments.size();
-    auto attributes =
-        kernel.GetKernelEntries(entry_offset, kernel.num_attributes());
-    for (auto attribute_offset : attributes) {
-      // We pass the pointer here because this attribute could be an array of
-      // size 0.
-      kernel_frame.AddAttribute(bef_file_->attribute_section_.data() +
-                                attribute_offset);
-    }
+    kernel_frame.SetNumResults(kernel.num_results);
 
-    // Set up functions.
-    entry_offset += attributes.size();
-    auto functions =
-        kernel.GetKernelEntries(entry_offset, kernel.num_functions());
-    for (auto fn_idx : functions) {
-      // Functions are passed as their corresponding `Function`.
-      kernel_frame.AddAttribute(bef_file_->functions_[fn_idx].get());
-    }
+    // Set up attributes and functions.
+    for (const void* attribute : kernel.GetAttributes())
+      kernel_frame.AddAttribute(attribute);
 
     // If all arguments are good or if the kernel is non-strict, run the
     // function.
-    if (any_error_argument == nullptr || is_nonstrict_kernel) {
+    if (any_error_argument == nullptr || kernel.is_nonstrict) {
       // Get the location to pass down to the kernels so they can report an
       // error.
-      kernel_frame.SetLocation(
-          {location_handler_.get(), kernel.kernel_location()});
+      kernel_frame.SetLocation({location_handler_.get(), kernel.location});
 
-      // kernel_fn should populate results in kernel_frame with pointers to
-      // AsyncValue before it returns.
+      // The kernel implementation should populate results in kernel_frame with
+      // pointers to AsyncValue before it returns.
       {
-        TFRT_TRACE_KERNEL_SCOPE(bef_file_->GetKernelName(kernel.kernel_code()));
-        kernel_fn(&kernel_frame);
+        TFRT_TRACE_KERNEL_SCOPE(bef_file_->GetKernelName(kernel.kernel_code));
+        kernel.implementation(&kernel_frame);
       }
     } else {
       // Otherwise, automatically propagate errors to the result values.
@@ -478,11 +450,8 @@ void BEFExecutor::DecrementArgumentsNotReadyCounts(
     // result, then we can mark all kernels using it as ready to go, otherwise
     // we need to enqueue them on their unavailable operands.
 
-    // Move entry offset to start of results.
-    entry_offset += functions.size();
-    auto results = kernel.GetKernelEntries(entry_offset, kernel.num_results());
-    // Move entry offset to start of all used_bys.
-    entry_offset += results.size();
+    auto results = kernel.GetResults();
+    int used_by_offset = 0;
     for (int result_number = 0; result_number < results.size();
          ++result_number) {
       auto& result_register = register_infos_[results[result_number]];
@@ -507,7 +476,7 @@ void BEFExecutor::DecrementArgumentsNotReadyCounts(
       auto* register_value =
           SetRegisterValue(&result_register, result, &register_already_set);
       // Process users of this result.
-      ProcessUsedBys(kernel, result_number, register_value, &entry_offset,
+      ProcessUsedBys(kernel, result_number, register_value, &used_by_offset,
                      kernel_ids);
 
       // DropRef since we no longer need the IndirectAsyncValue in the register.
@@ -521,14 +490,16 @@ void BEFExecutor::DecrementArgumentsNotReadyCounts(
 //===----------------------------------------------------------------------===//
 
 BEFExecutor::BEFExecutor(BEFFileImpl* bef_file, HostContext* host,
-                         ArrayRef<uint32_t> kernels,
+                         ArrayRef<DecodedKernel> kernels,
                          HostArray<BEFFileImpl::KernelInfo> kernel_infos,
                          HostArray<BEFFileImpl::RegisterInfo> register_infos,
+                         size_t max_kernel_frame_size,
                          bool has_arguments_pseudo_kernel)
     : bef_file_(FormRef(bef_file)),
       kernels_(kernels),
       kernel_infos_(std::move(kernel_infos)),
       register_infos_(std::move(register_infos)),
+      max_kernel_frame_size_(max_kernel_frame_size),
       location_handler_(
           TakeRef(host->Construct<BEFLocationHandler>(host, bef_file))) {
   // Now that the executor object is all set up and ready to go, kick off the
@@ -598,10 +569,11 @@ void BEFExecutor::Execute(const BEFFunction& fn,
   HostArray<BEFFileImpl::KernelInfo> kernel_infos;
   SmallVector<size_t, 4> result_regs;
 
-  auto kernels = bef_file->ReadFunction(
+  auto kernel_entries = bef_file->ReadFunction(
       fn.function_offset(), fn.result_types(), &location_offset,
       &register_infos, &kernel_infos, &result_regs, host->allocator());
-  if (kernels.empty()) return;
+  if (kernel_entries.empty()) return;
+  assert(kernel_infos.size() == fn.kernels().size());
   assert(result_regs.size() == fn.result_types().size());
 
   MutableArrayRef<BEFFileImpl::RegisterInfo> register_array =
@@ -609,8 +581,9 @@ void BEFExecutor::Execute(const BEFFunction& fn,
   InitializeArgumentRegisters(arguments, register_array);
   auto* exec_ptr = host->Allocate<BEFExecutor>();
   auto* exec = new (exec_ptr)
-      BEFExecutor(bef_file, host, kernels, std::move(kernel_infos),
-                  std::move(register_infos), !arguments.empty());
+      BEFExecutor(bef_file, host, fn.kernels(), std::move(kernel_infos),
+                  std::move(register_infos), fn.max_kernel_frame_size(),
+                  !arguments.empty());
 
   // Populate the function result AsyncValues (results).
   //
@@ -21,6 +21,8 @@
 
 #include "tfrt/bef_executor/bef_file.h"
 
+#include <algorithm>
+
 #include "bef_file_impl.h"
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/host_context.h"
@@ -60,7 +62,7 @@ class BEFFileReader : public BEFReader {
   bool ReadNextSection();
   bool ReadKernelsSection(HostAllocator* host_allocator);
   bool ReadTypesSection();
-  bool ReadFunctionIndexSection();
+  bool ReadFunctionIndexSection(HostAllocator* host_allocator);
 
  private:
   bool ReadFunctionIndexSectionInternal(
@@ -68,6 +70,8 @@ class BEFFileReader : public BEFReader {
   bool ReadFormatVersionSection();
   bool DiagnoseUnknownKernel(size_t kernel_idx, const char* kernel_name,
                              HostAllocator* host_allocator);
+  bool DecodeFunction(const FunctionIndex& function_index,
+                      HostAllocator* host_allocator, BEFFunction* function);
 
   // These are things set up at construction time.
   KernelRegistry* registry_;
@@ -362,10 +366,121 @@ bool BEFFileReader::ReadFunctionIndexSectionInternal(
   return false;
 }
 
+// Decode the kernels of the specified function into the table that BEFExecutor
+// dispatches from, resolving kernel implementations, attributes and functions
+// once. Return false on success. Emit an error and return true on failure.
+bool BEFFileReader::DecodeFunction(const FunctionIndex& function_index,
+                                   HostAllocator* host_allocator,
+                                   BEFFunction* function) {
+  HostArray<BEFFileImpl::RegisterInfo> register_infos;
+  HostArray<BEFFileImpl::KernelInfo> kernel_infos;
+  SmallVector<size_t, 4> result_regs;
+  size_t location_offset;
+  auto kernel_entries = bef_file_->ReadFunction(
+      function_index.function_offset, function_index.results,
+      &location_offset, &register_infos, &kernel_infos, &result_regs,
+      host_allocator);
+  // ReadFunction returns a null ArrayRef on error, and an empty one for a
+  // function without kernels.
+  if (kernel_entries.data() == nullptr) return true;
+
+  auto get_kernel = [&](const BEFFileImpl::KernelInfo& kernel_info) {
+    assert(kernel_info.offset % kKernelEntryAlignment == 0);
+    return BEFKernel(kernel_entries.data() +
+                     kernel_info.offset / kKernelEntryAlignment);
+  };
+
+  MutableArrayRef<BEFFileImpl::KernelInfo>& kernel_infos_array =
+      kernel_infos.mutable_array();
+
+  // Reserve all the attributes first, the decoded kernels point into them.
+  size_t num_attributes = 0;
+  for (const auto& kernel_info : kernel_infos_array) {
+    BEFKernel kernel = get_kernel(kernel_info);
+    num_attributes += kernel.num_attributes() + kernel.num_functions();
+  }
+  std::vector<const void*> attributes;
+  attributes.reserve(num_attributes);
+
+  std::vector<DecodedKernel> kernels;
+  kernels.reserve(kernel_infos_array.size());
+  size_t max_kernel_frame_size = 0;
+
+  // Functions with arguments start with a pseudo kernel that provides them.
+  const bool has_arguments_pseudo_kernel = !function_index.arguments.empty();
+
+  for (const auto& kernel_info : kernel_infos_array) {
+    BEFKernel kernel = get_kernel(kernel_info);
+
+    DecodedKernel decoded;
+    // The arguments pseudo kernel is the first kernel, and it has no kernel
+    // code. Every other kernel must have a valid one.
+    if (has_arguments_pseudo_kernel && kernels.empty()) {
+      decoded.implementation = nullptr;
+    } else if (kernel.kernel_code() < bef_file_->kernels_.size()) {
+      decoded.implementation = bef_file_->kernels_[kernel.kernel_code()];
+    } else {
+      bef_file_->EmitFormatError("invalid kernel code in BEF file");
+      return true;
+    }
+    decoded.kernel_code = kernel.kernel_code();
+    decoded.location = kernel.kernel_location();
+    // The low bit of special_metadata indicates if the kernel is non-strict.
+    decoded.is_nonstrict =
+        static_cast<bool>(kernel.special_metadata() &
+                          static_cast<uint32_t>(SpecialAttribute::kNonStrict));
+
+    int entry_offset = 0;
+    decoded.num_arguments = kernel.num_arguments();
+    decoded.arguments =
+        kernel.GetKernelEntries(entry_offset, kernel.num_arguments()).data();
+    entry_offset += kernel.num_arguments();
+
+    decoded.num_attributes = kernel.num_attributes() + kernel.num_functions();
+    decoded.attributes = attributes.data() + attributes.size();
+    for (auto attribute_offset :
+         kernel.GetKernelEntries(entry_offset, kernel.num_attributes())) {
+      // We pass the pointer here because this attribute could be an array of
+      // size 0.
+      attributes.push_back(bef_file_->attribute_section_.data() +
+                           attribute_offset);
+    }
+    entry_offset += kernel.num_attributes();
+
+    for (auto fn_idx :
+         kernel.GetKernelEntries(entry_offset, kernel.num_functions())) {
+      if (fn_idx >= bef_file_->functions_.size()) {
+        bef_file_->EmitFormatError("invalid Function section in BEF file");
+        return true;
+      }
+      // Functions are passed as their corresponding `Function`.
+      attributes.push_back(bef_file_->functions_[fn_idx].get());
+    }
+    entry_offset += kernel.num_functions();
+
+    decoded.num_results = kernel.num_results();
+    decoded.num_used_bys = kernel.GetNumUsedBys().data();
+    decoded.results =
+        kernel.GetKernelEntries(entry_offset, kernel.num_results()).data();
+    decoded.used_bys = decoded.results + kernel.num_results();
+
+    max_kernel_frame_size =
+        std::max<size_t>(max_kernel_frame_size, decoded.num_arguments +
+                                                    decoded.num_results +
+                                                    decoded.num_attributes);
+    kernels.push_back(decoded);
+  }
+
+  assert(attributes.size() == num_attributes);
+  function->SetKernels(std::move(kernels), std::move(attributes),
+                       max_kernel_frame_size);
+  return false;
+}
+
 // Read the FunctionIndex section from a BEF file, building the functions_ table
 // and the function_symbol_table_, and returning false on success. Emit an error
 // and return true on failure.
-bool BEFFileReader::ReadFunctionIndexSection() {
+bool BEFFileReader::ReadFunctionIndexSection(HostAllocator* host_allocator) {
   auto format_error = [&]() -> bool {
     bef_file_->EmitFormatError("invalid FunctionIndex section in BEF file");
     return true;
@@ -410,6 +525,16 @@ bool BEFFileReader::ReadFunctionIndexSection() {
     }
   }
 
+  // Kernels refer to functions by index, so decode the BEF functions once all
+  // functions have been created.
+  for (size_t i = 0, e = function_indices.size(); i != e; ++i) {
+    if (function_indices[i].kind != FunctionKind::kBEFFunction) continue;
+    auto* bef_function =
+        static_cast<BEFFunction*>(bef_file_->functions_[i].get());
+    if (DecodeFunction(function_indices[i], host_allocator, bef_function))
+      return true;
+  }
+
   return false;
 }
 
@@ -442,7 +567,7 @@ RCReference<BEFFile> BEFFile::Open(ArrayRef<uint8_t> file,
   // Now that we've figured out the contents of the sections, resolve some
   // things.
   if (reader.ReadKernelsSection(host_allocator) || reader.ReadTypesSection() ||
-      reader.ReadFunctionIndexSection())
+      reader.ReadFunctionIndexSection(host_allocator))
     return {};
 
   // Now that we decoded the whole thing, return the BEFFile to the caller.
@@ -23,6 +23,8 @@
 #ifndef TFRT_LIB_BEF_EXECUTOR_BEF_FILE_IMPL_H_
 #define TFRT_LIB_BEF_EXECUTOR_BEF_FILE_IMPL_H_
 
+#include <vector>
+
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
@@ -38,6 +40,39 @@ namespace tfrt {
 class BEFFileImpl;
 class DecodedLocation;
 
+// A kernel of a BEF function, decoded when the BEF file is loaded. BEFExecutor
+// dispatches kernels from a table of these instead of decoding the kernel
+// entries in the BEF file every time a kernel runs.
+struct DecodedKernel {
+  // This is null for the arguments pseudo kernel.
+  KernelImplementation implementation;
+  // The argument registers, the result registers and the used_bys of all
+  // results. These point to the kernel entries in the BEF file.
+  const uint32_t* arguments;
+  const uint32_t* results;
+  const uint32_t* used_bys;
+  // The number of used_bys of each result.
+  const uint32_t* num_used_bys;
+  // The attributes followed by the functions, as passed in the KernelFrame.
+  const void* const* attributes;
+  uint32_t num_arguments;
+  uint32_t num_attributes;
+  uint32_t num_results;
+  uint32_t kernel_code;
+  uint32_t location;
+  bool is_nonstrict;
+
+  ArrayRef<uint32_t> GetArguments() const {
+    return llvm::makeArrayRef(arguments, num_arguments);
+  }
+  ArrayRef<const void*> GetAttributes() const {
+    return llvm::makeArrayRef(attributes, num_attributes);
+  }
+  ArrayRef<uint32_t> GetResults() const {
+    return llvm::makeArrayRef(results, num_results);
+  }
+};
+
 // This class implements Function for BEF files.
 class BEFFunction final : public Function {
  public:
@@ -51,11 +86,29 @@ class BEFFunction final : public Function {
   BEFFunction(BEFFunction&& other)
       : Function(std::move(other)),
         function_offset_(other.function_offset_),
+        kernels_(std::move(other.kernels_)),
+        kernel_attributes_(std::move(other.kernel_attributes_)),
+        max_kernel_frame_size_(other.max_kernel_frame_size_),
         bef_file_(other.bef_file_) {}
 
   size_t function_offset() const { return function_offset_; }
+  // The kernels of this function, indexed by kernel number.
+  ArrayRef<DecodedKernel> kernels() const { return kernels_; }
+  // The largest number of arguments, results and attributes of any kernel in
+  // this function.
+  size_t max_kernel_frame_size() const { return max_kernel_frame_size_; }
   BEFFileImpl* bef_file() const { return bef_file_; }
 
+  // Set the decoded kernels of this function. `kernel_attributes` holds the
+  // attributes that the kernels point to.
+  void SetKernels(std::vector<DecodedKernel> kernels,
+                  std::vector<const void*> kernel_attributes,
+                  size_t max_kernel_frame_size) {
+    kernels_ = std::move(kernels);
+    kernel_attributes_ = std::move(kernel_attributes);
+    max_kernel_frame_size_ = max_kernel_frame_size;
+  }
+
   void Execute(ArrayRef<AsyncValue*> arguments,
                MutableArrayRef<RCReference<AsyncValue>> results,
                HostContext* host) const override;
@@ -64,6 +117,9 @@ class BEFFunction final : public Function {
 
  private:
   size_t function_offset_;
+  std::vector<DecodedKernel> kernels_;
+  std::vector<const void*> kernel_attributes_;
+  size_t max_kernel_frame_size_ = 0;
   BEFFileImpl* bef_file_;
 };
 
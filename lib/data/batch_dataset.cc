@@ -0,0 +1,73 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- batch_dataset.cc ---------------------------------------------------===//
+//
+// This file implements helper functions for BatchDataset.
+//
+//===----------------------------------------------------------------------===//
+
+#include "batch_dataset.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tfrt {
+namespace data {
+
+void CopyNonTemporal(void* dst, const void* src, size_t size) {
+#if defined(__SSE2__)
+  char* dst_ptr = static_cast<char*>(dst);
+  const char* src_ptr = static_cast<const char*>(src);
+
+  // Copy the unaligned head with a regular memcpy, so that all streaming
+  // stores below are 16-byte aligned.
+  const size_t misalignment = reinterpret_cast<uintptr_t>(dst_ptr) % 16;
+  const size_t head = std::min(size, misalignment ? 16 - misalignment : 0);
+  std::memcpy(dst_ptr, src_ptr, head);
+  dst_ptr += head;
+  src_ptr += head;
+  size -= head;
+
+  // Copy one cache line per iteration.
+  for (; size >= 64; size -= 64, dst_ptr += 64, src_ptr += 64) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(src_ptr);
+    __m128i* d = reinterpret_cast<__m128i*>(dst_ptr);
+    __m128i v0 = _mm_loadu_si128(s + 0);
+    __m128i v1 = _mm_loadu_si128(s + 1);
+    __m128i v2 = _mm_loadu_si128(s + 2);
+    __m128i v3 = _mm_loadu_si128(s + 3);
+    _mm_stream_si128(d + 0, v0);
+    _mm_stream_si128(d + 1, v1);
+    _mm_stream_si128(d + 2, v2);
+    _mm_stream_si128(d + 3, v3);
+  }
+
+  // Copy the tail.
+  std::memcpy(dst_ptr, src_ptr, size);
+
+  // Streaming stores are weakly ordered, make them visible to other threads
+  // before the batch is published.
+  _mm_sfence();
+#else
+  std::memcpy(dst, src, size);
+#endif
+}
+
+}  // namespace data
+}  // namespace tfrt
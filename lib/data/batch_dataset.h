@@ -26,8 +26,10 @@
 #define TFRT_DATA_BATCH_DATASET_H_
 
 #include "dataset.h"
+#include "host_buffer_pool.h"
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/ref_count.h"
@@ -88,11 +90,18 @@ SmallVector<AsyncValueRef<TensorMetadata>, 4> GetInputMetadata(
   return metadatas;
 }
 
+// Copies `size` bytes from `src` to `dst` using non-temporal (streaming)
+// stores where they are supported. Streaming stores bypass the cache, which
+// avoids evicting useful data from the cache when writing large batches that
+// are not going to be read back immediately by the same core.
+void CopyNonTemporal(void* dst, const void* src, size_t size);
+
 // Copy bytes of `src` to the index-th element of `dst`. This is useful to batch
 // multiple scalar values into a DenseHostTenor.
 template <typename T>
-void CopyDataHelper(T* src, DenseHostTensor* dst, int index) {
-  int data_size = sizeof(*src);
+void CopyDataHelper(T* src, DenseHostTensor* dst, size_t index,
+                    bool non_temporal) {
+  size_t data_size = sizeof(*src);
   char* dst_ptr = static_cast<char*>(dst->data()) + index * data_size;
   std::memcpy(dst_ptr, src, data_size);
 }
@@ -101,97 +110,92 @@ void CopyDataHelper(T* src, DenseHostTensor* dst, int index) {
 // multiple DenseHostTensors into a DenseHostTenor.
 template <>
 inline void CopyDataHelper<DenseHostTensor>(DenseHostTensor* src,
-                                            DenseHostTensor* dst, int index) {
-  int data_size = src->DataSizeInBytes();
+                                            DenseHostTensor* dst, size_t index,
+                                            bool non_temporal) {
+  size_t data_size = src->DataSizeInBytes();
   char* dst_ptr = static_cast<char*>(dst->data()) + index * data_size;
-  std::memcpy(dst_ptr, src->data(), data_size);
-}
-
-struct CounterAndError {
-  explicit CounterAndError(uint32_t value) : counter(value) {}
-
-  std::atomic<uint32_t> counter;
-  std::atomic<AsyncValue*> error{nullptr};
-};
-
-// Copies value from `value` into the slice_index-th slice of `temp` when it is
-// ready and decrements the counter or forwards an error to `counter_and_error`.
-// Additionally, checks that the metadata of `value` matches
-// `expected_metadata`. When `counter_and_error` reaches 0, which means that all
-// slices have been copied, move `temp` to `result` and make it available.
-template <typename T>
-void CopySlice(RCReference<AsyncValue> value,
-               AsyncValueRef<TensorMetadata> expected_metadata,
-               AsyncValueRef<DenseHostTensor> temp,
-               RCReference<AsyncValue> result,
-               CounterAndError* counter_and_error, size_t slice_index) {
-  // `temp` is an allocated DenseHostTensor.
-  assert(temp.IsAvailable());
-  value->AndThen([value = value.CopyRef(),
-                  expected_metadata = std::move(expected_metadata),
-                  temp = std::move(temp), result = std::move(result),
-                  slice_index, counter_and_error]() mutable {
-    if (value->IsError()) {
-      AsyncValue* null_value = nullptr;
-      AsyncValue* error_value = value.release();
-      // Set error if it hasn't already been set.
-      //
-      // Use memory_order_release for the success case so that error_value is
-      // visible to other threads when they load with memory_order_acquire. For
-      // the failure case, we do not care about expected_value, so we can use
-      // memory_order_relaxed.
-      if (!counter_and_error->error.compare_exchange_strong(
-              null_value, error_value, std::memory_order_release,
-              std::memory_order_relaxed)) {
-        error_value->DropRef();
-      }
-    } else {
-      // Verify that the value's metadata equals the expected_metadata.
-      // IDEA(donglin): Do this check only in DEBUG mode.
-      assert(GetMetadataFromValue(value->get<T>()) == expected_metadata.get());
-      CopyDataHelper<T>(&value->get<T>(), &temp.get(), slice_index);
-    }
-
-    auto remaining_slices = counter_and_error->counter.fetch_sub(1) - 1;
-    if (remaining_slices == 0) {
-      // Use memory_order_consume so that writes to this atomic variable from
-      // other threads are visible to this thread.
-      auto* error_value =
-          counter_and_error->error.load(std::memory_order_consume);
-      // Forward the error if any, otherwise move `temp` to `result`.
-      if (error_value != nullptr) {
-        result->SetError(error_value->GetError());
-        error_value->DropRef();
-      } else {
-        result->emplace<DenseHostTensor>(std::move(temp.get()));
-      }
-      delete counter_and_error;
-    }
-  });
+  if (non_temporal) {
+    CopyNonTemporal(dst_ptr, src->data(), data_size);
+  } else {
+    std::memcpy(dst_ptr, src->data(), data_size);
+  }
 }
 
+// When `temp` and all `batched_inputs` are available, copies every input into
+// the corresponding slice of `temp`, then moves `temp` to `result`. Forwards
+// the error to `result` if the allocation or any of the inputs failed.
+// Additionally, checks that the metadata of every input matches
+// `expected_metadata`.
+//
+// The copy is split across the worker threads with ParallelFor. Batch assembly
+// is memory bandwidth bound, so doing it in one parallel pass after all inputs
+// are ready is faster than copying each slice from whichever thread resolved
+// the input.
 template <typename T>
 void CopyComponent(SmallVector<RCReference<AsyncValue>, 4>&& batched_inputs,
                    AsyncValueRef<TensorMetadata> expected_metadata,
                    AsyncValueRef<DenseHostTensor> temp,
-                   RCReference<AsyncValue> result) {
-  temp.AndThen([batched_inputs = std::move(batched_inputs),
-                expected_metadata = std::move(expected_metadata),
-                temp = temp.CopyRef(), result = std::move(result)]() mutable {
-    // If there was an error in tensor allocation, forward it to the result.
-    if (temp.IsError()) {
-      result->SetError(temp.GetError());
-      return;
-    }
-    auto* counter_and_error = new CounterAndError(batched_inputs.size());
-    // Otherwise, when each input is ready, copy it to `temp`. When all
-    // inputs are copied, move `temp` to `result`.
-    for (size_t i = 0; i < batched_inputs.size(); ++i) {
-      CopySlice<T>(batched_inputs[i].CopyRef(), expected_metadata.CopyRef(),
-                   temp.CopyRef(), result.CopyRef(), counter_and_error,
-                   /*slice_index=*/i);
-    }
-  });
+                   RCReference<AsyncValue> result,
+                   const ExecutionContext& exec_ctx) {
+  // Minimum number of bytes copied by a single ParallelFor task.
+  static constexpr size_t kMinBlockSizeInBytes = 128 * 1024;
+  // Batches larger than this are copied with non-temporal stores.
+  static constexpr size_t kNonTemporalCopyThreshold = 8 * 1024 * 1024;
+
+  SmallVector<AsyncValue*, 4> async_value_ptrs;
+  async_value_ptrs.reserve(batched_inputs.size() + 1);
+  async_value_ptrs.push_back(temp.GetAsyncValue());
+  for (const auto& input : batched_inputs) {
+    async_value_ptrs.push_back(input.get());
+  }
+
+  exec_ctx.host()->RunWhenReady(
+      async_value_ptrs,
+      [batched_inputs = std::move(batched_inputs),
+       expected_metadata = std::move(expected_metadata), temp = std::move(temp),
+       result = std::move(result), exec_ctx]() mutable {
+        // If there was an error in tensor allocation, forward it to the
+        // result.
+        if (temp.IsError()) {
+          result->SetError(temp.GetError());
+          return;
+        }
+        for (const auto& input : batched_inputs) {
+          if (input->IsError()) {
+            result->SetError(input->GetError());
+            return;
+          }
+          // Verify that the value's metadata equals the expected_metadata.
+          // IDEA(donglin): Do this check only in DEBUG mode.
+          assert(GetMetadataFromValue(input->get<T>()) ==
+                 expected_metadata.get());
+        }
+
+        const size_t batch_size_in_bytes = temp->DataSizeInBytes();
+        const size_t slice_size_in_bytes =
+            batch_size_in_bytes / batched_inputs.size();
+        const bool non_temporal =
+            batch_size_in_bytes >= kNonTemporalCopyThreshold;
+        const size_t min_block_size =
+            std::max<size_t>(1, kMinBlockSizeInBytes /
+                                    std::max<size_t>(slice_size_in_bytes, 1));
+        DenseHostTensor* dst = &temp.get();
+
+        ParallelFor(exec_ctx.host())
+            .Execute(
+                batched_inputs.size(),
+                ParallelFor::BlockSizes::Min(min_block_size),
+                [batched_inputs = std::move(batched_inputs), dst,
+                 non_temporal](size_t begin, size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                    CopyDataHelper<T>(&batched_inputs[i]->get<T>(), dst, i,
+                                      non_temporal);
+                  }
+                },
+                [temp = std::move(temp), result = std::move(result)]() mutable {
+                  result->emplace<DenseHostTensor>(std::move(temp.get()));
+                });
+      });
 }
 
 // Recursive base case.
@@ -200,7 +204,8 @@ void CopyToBatchHelper(
     SmallVector<SmallVector<RCReference<AsyncValue>, 4>, 4>&& inputs,
     SmallVector<AsyncValueRef<TensorMetadata>, 4>&& expected_metadata,
     SmallVector<AsyncValueRef<DenseHostTensor>, 4>&& temp_batched_values,
-    const SmallVector<RCReference<AsyncValue>, 4>& results) {}
+    const SmallVector<RCReference<AsyncValue>, 4>& results,
+    const ExecutionContext& exec_ctx) {}
 
 // Copy inputs to batch when they are ready. This function applies recursively
 // to one component (with type T) at a time.
@@ -209,7 +214,8 @@ void CopyToBatchHelper(
     SmallVector<SmallVector<RCReference<AsyncValue>, 4>, 4>&& inputs,
     SmallVector<AsyncValueRef<TensorMetadata>, 4>&& expected_metadata,
     SmallVector<AsyncValueRef<DenseHostTensor>, 4>&& temp_batched_values,
-    const SmallVector<RCReference<AsyncValue>, 4>& results) {
+    const SmallVector<RCReference<AsyncValue>, 4>& results,
+    const ExecutionContext& exec_ctx) {
   auto index = N - (sizeof...(RemainingT) + 1);
 
   SmallVector<RCReference<AsyncValue>, 4> batched_inputs;
@@ -220,11 +226,12 @@ void CopyToBatchHelper(
 
   CopyComponent<T>(
       std::move(batched_inputs), std::move(expected_metadata[index]),
-      std::move(temp_batched_values[index]), results[index].CopyRef());
+      std::move(temp_batched_values[index]), results[index].CopyRef(),
+      exec_ctx);
 
-  CopyToBatchHelper<N, RemainingT...>(std::move(inputs),
-                                      std::move(expected_metadata),
-                                      std::move(temp_batched_values), results);
+  CopyToBatchHelper<N, RemainingT...>(
+      std::move(inputs), std::move(expected_metadata),
+      std::move(temp_batched_values), results, exec_ctx);
 }
 
 template <typename... T>
@@ -232,23 +239,27 @@ void CopyToBatch(
     SmallVector<SmallVector<RCReference<AsyncValue>, 4>, 4>&& inputs,
     SmallVector<AsyncValueRef<TensorMetadata>, 4>&& expected_metadata,
     SmallVector<AsyncValueRef<DenseHostTensor>, 4>&& temp_batched_values,
-    const SmallVector<RCReference<AsyncValue>, 4>& results) {
+    const SmallVector<RCReference<AsyncValue>, 4>& results,
+    const ExecutionContext& exec_ctx) {
   CopyToBatchHelper<sizeof...(T), T...>(
       std::move(inputs), std::move(expected_metadata),
-      std::move(temp_batched_values), results);
+      std::move(temp_batched_values), results, exec_ctx);
 }
 
 // For each component in the batch, when the metadata is available, allocate a
-// DenseHostTensor with the corresponding batch shape and dtype.
+// DenseHostTensor with the corresponding batch shape and dtype. Tensor buffers
+// are allocated from the `buffer_pool`.
 static SmallVector<AsyncValueRef<DenseHostTensor>, 4> AllocateOutputTensors(
     const SmallVector<AsyncValueRef<TensorMetadata>, 4>& metadatas,
-    size_t batch_size, const ExecutionContext& exec_ctx) {
+    size_t batch_size, HostBufferPool* buffer_pool,
+    const ExecutionContext& exec_ctx) {
   SmallVector<AsyncValueRef<DenseHostTensor>, 4> results;
   results.reserve(metadatas.size());
   for (size_t i = 0; i < metadatas.size(); ++i) {
     auto result =
         exec_ctx.host()->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
     metadatas[i].AndThen([exec_ctx, batch_size,
+                          buffer_pool = FormRef(buffer_pool),
                           metadata = metadatas[i].CopyRef(),
                           result = result.CopyRef()]() {
       if (metadata.IsError()) {
@@ -262,14 +273,14 @@ static SmallVector<AsyncValueRef<DenseHostTensor>, 4> AllocateOutputTensors(
         output_dims[i + 1] = metadata->shape.GetDimensionSize(i);
       }
       TensorMetadata batched_metadata(metadata->dtype, output_dims);
-      auto dht = DenseHostTensor::CreateUninitialized(batched_metadata,
-                                                      exec_ctx.host());
-      if (!dht) {
+      auto buffer =
+          buffer_pool->Allocate(batched_metadata.GetHostSizeInBytes());
+      if (!buffer) {
         result.SetError(
             EmitError(exec_ctx, "failed to create uninitialized tensor"));
         return;
       }
-      result.emplace(std::move(*dht));
+      result.emplace(batched_metadata, std::move(buffer));
     });
     results.push_back(std::move(result));
   }
@@ -294,7 +305,9 @@ class BatchDataset : public Dataset {
         batch_size_(batch_size),
         same_input_metadata_(same_input_metadata),
         host_(host),
-        allocator_(host->allocator()) {}
+        allocator_(host->allocator()),
+        buffer_pool_(TakeRef(new HostBufferPool(
+            kMaxCachedBuffersPerComponent * sizeof...(T), allocator_))) {}
 
   // This class is not copyable or movable.
   BatchDataset(const BatchDataset&) = delete;
@@ -306,6 +319,11 @@ class BatchDataset : public Dataset {
   // Allow iterator to rely on private data members of this dataset.
   friend class BatchDatasetIterator<T...>;
 
+  // Output tensors of the same shape are produced for every batch, except for
+  // the last one, so a few cached buffers per component are enough to recycle
+  // the memory of all batches released by the consumer.
+  static constexpr size_t kMaxCachedBuffersPerComponent = 4;
+
   void Destroy() override {
     internal::DestroyImpl<BatchDataset>(this, allocator_);
   }
@@ -315,6 +333,8 @@ class BatchDataset : public Dataset {
   const bool same_input_metadata_;
   HostContext* host_;
   HostAllocator* allocator_;
+  // Pool of output tensor buffers shared by all iterators of this dataset.
+  RCReference<HostBufferPool> buffer_pool_;
 };
 
 template <typename... T>
@@ -354,9 +374,6 @@ RCReference<Iterator> BatchDataset<T...>::MakeIterator() {
 }
 
 // TODO(b/155918211): Handle asynchrous EOF from the input_iterator_
-// IDEA(donglin): Consider scheduling the batch operation to the background
-// threadpool explicitly. This can prevent GetNext() from doing memory copy
-// synchronously regardless of whether the input values are available.
 template <typename... T>
 IterationResult BatchDatasetIterator<T...>::GetNext(
     const ExecutionContext& exec_ctx) {
@@ -380,10 +397,6 @@ IterationResult BatchDatasetIterator<T...>::GetNext(
     // the first input and re-use it to allocate output tensor for every batch.
     // This allows us to allocate output tensor before input values are
     // available except for the first input.
-    //
-    // This improves L1/L2 cache affinity of the data copying from the input
-    // values to the output tensor because the same thread that computes the
-    // input value can copy this value to the output tensor.
     if (!is_initialized_) {
       input_metadata_ = GetInputMetadata<T...>(inputs[0], host);
       is_initialized_ = true;
@@ -396,8 +409,8 @@ IterationResult BatchDatasetIterator<T...>::GetNext(
     metadata = GetInputMetadata<T...>(inputs[0], host);
   }
 
-  auto temp_batched_values =
-      AllocateOutputTensors(metadata, inputs.size(), exec_ctx);
+  auto temp_batched_values = AllocateOutputTensors(
+      metadata, inputs.size(), parent_dataset_->buffer_pool_.get(), exec_ctx);
 
   SmallVector<RCReference<AsyncValue>, 4> results;
   results.reserve(sizeof...(T));
@@ -406,7 +419,7 @@ IterationResult BatchDatasetIterator<T...>::GetNext(
   }
 
   CopyToBatch<T...>(std::move(inputs), std::move(metadata),
-                    std::move(temp_batched_values), results);
+                    std::move(temp_batched_values), results, exec_ctx);
   return IterationResult::Values(std::move(results), host);
 }
 
@@ -21,9 +21,12 @@
 #include "batch_dataset.h"
 #include "filter_dataset.h"
 #include "interleave_dataset.h"
+#include "iterator_stats.h"
 #include "map_dataset.h"
 #include "memory_dataset.h"
+#include "padded_batch_dataset.h"
 #include "prefetch_dataset.h"
+#include "ragged_batch_dataset.h"
 #include "range_dataset.h"
 #include "repeat_dataset.h"
 #include "slice_dataset.h"
@@ -31,6 +34,7 @@
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/ostream.h"
 #include "tfrt/support/ref_count.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 
@@ -43,14 +47,16 @@ namespace data {
 
 // Create a dataset with the values specified in the args.
 template <typename T>
-RCReference<SliceDataset<T>> MakeDatasetFromValues(
-    Chain chain, RemainingArguments args, const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeDatasetFromValues(Chain chain, RemainingArguments args,
+                                           const ExecutionContext& exec_ctx) {
   std::vector<T> vector;
   for (int i = 0, e = args.size(); i < e; i++) {
     vector.push_back(args[i]->get<T>());
   }
-  return TakeRef(exec_ctx.host()->Construct<SliceDataset<T>>(std::move(vector),
-                                                             exec_ctx.host()));
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<SliceDataset<T>>(std::move(vector), host)),
+      "SliceDataset", {}, host);
 }
 
 // Add template specialization for DenseHostTensor because DenseHostTensor does
@@ -62,14 +68,17 @@ RCReference<SliceDataset<T>> MakeDatasetFromValues(
 // outside the SliceDataset after they are used to create the SliceDataset. We
 // can pass values as attribute when we support e.g. TensorAttribute in TFRT.
 template <>
-RCReference<SliceDataset<DenseHostTensor>> MakeDatasetFromValues(
+RCReference<Dataset> MakeDatasetFromValues<DenseHostTensor>(
     Chain chain, RemainingArguments args, const ExecutionContext& exec_ctx) {
   std::vector<DenseHostTensor> vector;
   for (int i = 0, e = args.size(); i < e; i++) {
     vector.push_back(args[i]->get<DenseHostTensor>().CopyRef());
   }
-  return TakeRef(exec_ctx.host()->Construct<SliceDataset<DenseHostTensor>>(
-      std::move(vector), exec_ctx.host()));
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<SliceDataset<DenseHostTensor>>(std::move(vector),
+                                                             host)),
+      "SliceDataset", {}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -78,24 +87,29 @@ RCReference<SliceDataset<DenseHostTensor>> MakeDatasetFromValues(
 
 // Create a dataset that yields the specified range.
 template <typename T>
-RCReference<RangeDataset<T>> MakeRangeDataset(
-    T start, T stop, T step, const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeRangeDataset(T start, T stop, T step,
+                                      const ExecutionContext& exec_ctx) {
   assert(step != 0 && "step size cannot be 0");
-  return TakeRef(exec_ctx.host()->Construct<RangeDataset<T>>(start, stop, step,
-                                                             exec_ctx.host()));
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<RangeDataset<T>>(start, stop, step, host)),
+      "RangeDataset", {}, host);
 }
 
 //===----------------------------------------------------------------------===//
 // MapDataset
 //===----------------------------------------------------------------------===//
 
-RCReference<MapDataset> MakeMapDataset(RCReference<Dataset>* dataset,
-                                       RemainingArguments args,
-                                       Attribute<Function> fn,
-                                       const ExecutionContext& exec_ctx) {
-  return TakeRef(exec_ctx.host()->Construct<MapDataset>(
-      dataset->CopyRef(), RCArray<AsyncValue>(args.values()),
-      FormRef(&fn.get()), exec_ctx.host()));
+RCReference<Dataset> MakeMapDataset(RCReference<Dataset>* dataset,
+                                    RemainingArguments args,
+                                    Attribute<Function> fn,
+                                    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<MapDataset>(dataset->CopyRef(),
+                                          RCArray<AsyncValue>(args.values()),
+                                          FormRef(&fn.get()), host)),
+      "MapDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -103,12 +117,26 @@ RCReference<MapDataset> MakeMapDataset(RCReference<Dataset>* dataset,
 //===----------------------------------------------------------------------===//
 
 template <typename... T>
-RCReference<FilterDataset<T...>> MakeFilterDataset(
-    RCReference<Dataset>* dataset, Attribute<Function> fn,
-    const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeFilterDataset(RCReference<Dataset>* dataset,
+                                       Attribute<Function> fn,
+                                       const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  return TakeRef(host->Construct<FilterDataset<T...>>(
-      (*dataset).CopyRef(), FormRef(&fn.get()), host));
+  return MaybeCollectStats(TakeRef(host->Construct<FilterDataset<T...>>(
+                               (*dataset).CopyRef(), FormRef(&fn.get()), host)),
+                           "FilterDataset", {dataset->get()}, host);
+}
+
+// Create a filter dataset which evaluates the filter function for
+// `batch_size` input elements at a time.
+template <typename... T>
+RCReference<Dataset> MakeBatchedFilterDataset(
+    RCReference<Dataset>* dataset, Attribute<int32_t> batch_size,
+    Attribute<Function> fn, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<FilterDataset<T...>>(
+          (*dataset).CopyRef(), FormRef(&fn.get()), host, batch_size.get())),
+      "FilterDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -117,43 +145,76 @@ RCReference<FilterDataset<T...>> MakeFilterDataset(
 
 // TODO(rachelim): Support variable number of arguments.
 template <typename T, typename... U>
-RCReference<InterleaveDataset<std::tuple<T>, std::tuple<U...>>>
-MakeInterleaveDataset(RCReference<Dataset>* dataset, int64_t cycle_length,
-                      int64_t block_length, Attribute<Function> fn,
-                      const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeInterleaveDataset(RCReference<Dataset>* dataset,
+                                           int64_t cycle_length,
+                                           int64_t block_length,
+                                           Attribute<Function> fn,
+                                           const ExecutionContext& exec_ctx) {
   assert(fn->argument_types().size() == 1 &&
          "Interleave only supports functions with unary inputs.");
   assert(
       fn->result_types().size() == 1 &&
       "Interleave expects only one function output, which must be a dataset.");
 
-  return TakeRef(
-      exec_ctx.host()
-          ->Construct<InterleaveDataset<std::tuple<T>, std::tuple<U...>>>(
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(
+          host->Construct<InterleaveDataset<std::tuple<T>, std::tuple<U...>>>(
               dataset->CopyRef(), cycle_length, block_length,
-              FormRef(&fn.get()), exec_ctx.host()));
+              FormRef(&fn.get()), host)),
+      "InterleaveDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
 // TFRecordDataset
 //===----------------------------------------------------------------------===//
 
-RCReference<TFRecordDataset> MakeTFRecordDataset(
-    std::string path, const ExecutionContext& exec_ctx) {
-  return TakeRef(exec_ctx.host()->Construct<TFRecordDataset>(std::move(path),
-                                                             exec_ctx.host()));
+RCReference<Dataset> MakeTFRecordDataset(std::string path,
+                                         const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<TFRecordDataset>(std::move(path), host)),
+      "TFRecordDataset", {}, host);
+}
+
+// Create a dataset that reads the files with the given paths that belong to
+// the `shard_index`-th of `num_shards` shards.
+Expected<RCReference<Dataset>> MakeShardedTFRecordDataset(
+    RemainingArguments paths, Attribute<int64_t> num_shards,
+    Attribute<int64_t> shard_index, const ExecutionContext& exec_ctx) {
+  if (num_shards.get() <= 0) {
+    return MakeStringError("num_shards must be positive, but got ",
+                           num_shards.get());
+  }
+  if (shard_index.get() < 0 || shard_index.get() >= num_shards.get()) {
+    return MakeStringError("shard_index must be in [0, ", num_shards.get(),
+                           "), but got ", shard_index.get());
+  }
+
+  std::vector<std::string> file_paths;
+  file_paths.reserve(paths.size());
+  for (int i = 0, e = paths.size(); i < e; ++i) {
+    file_paths.push_back(paths[i]->get<std::string>());
+  }
+
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<TFRecordDataset>(file_paths, num_shards.get(),
+                                               shard_index.get(), host)),
+      "TFRecordDataset", {}, host);
 }
 
 //===----------------------------------------------------------------------===//
 // RepeatDataset
 //===----------------------------------------------------------------------===//
 
-RCReference<RepeatDataset> MakeRepeatDataset(RCReference<Dataset>* dataset,
-                                             Attribute<int32_t> count,
-                                             const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeRepeatDataset(RCReference<Dataset>* dataset,
+                                       Attribute<int32_t> count,
+                                       const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  return TakeRef(
-      host->Construct<RepeatDataset>(dataset->CopyRef(), count.get(), host));
+  return MaybeCollectStats(TakeRef(host->Construct<RepeatDataset>(
+                               dataset->CopyRef(), count.get(), host)),
+                           "RepeatDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -161,11 +222,12 @@ RCReference<RepeatDataset> MakeRepeatDataset(RCReference<Dataset>* dataset,
 //===----------------------------------------------------------------------===//
 
 template <typename... T>
-RCReference<MemoryDataset<T...>> MakeMemoryDataset(
-    RCReference<Dataset>* dataset, const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeMemoryDataset(RCReference<Dataset>* dataset,
+                                       const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  return TakeRef(
-      host->Construct<MemoryDataset<T...>>(dataset->CopyRef(), host));
+  return MaybeCollectStats(
+      TakeRef(host->Construct<MemoryDataset<T...>>(dataset->CopyRef(), host)),
+      "MemoryDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -173,23 +235,59 @@ RCReference<MemoryDataset<T...>> MakeMemoryDataset(
 //===----------------------------------------------------------------------===//
 
 template <typename... T>
-RCReference<BatchDataset<T...>> MakeBatchDataset(
-    RCReference<Dataset>* dataset, Attribute<int32_t> batch_size,
-    Attribute<bool> same_input_metadata, const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakeBatchDataset(RCReference<Dataset>* dataset,
+                                      Attribute<int32_t> batch_size,
+                                      Attribute<bool> same_input_metadata,
+                                      const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  return TakeRef(host->Construct<BatchDataset<T...>>(
-      dataset->CopyRef(), batch_size.get(), same_input_metadata.get(), host));
+  return MaybeCollectStats(
+      TakeRef(host->Construct<BatchDataset<T...>>(
+          dataset->CopyRef(), batch_size.get(), same_input_metadata.get(),
+          host)),
+      "BatchDataset", {dataset->get()}, host);
+}
+
+//===----------------------------------------------------------------------===//
+// PaddedBatchDataset
+//===----------------------------------------------------------------------===//
+
+template <typename T>
+RCReference<Dataset> MakePaddedBatchDataset(RCReference<Dataset>* dataset,
+                                            Attribute<int32_t> batch_size,
+                                            Attribute<T> pad_value,
+                                            const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(
+      TakeRef(host->Construct<PaddedBatchDataset<T>>(
+          dataset->CopyRef(), batch_size.get(), pad_value.get(), host)),
+      "PaddedBatchDataset", {dataset->get()}, host);
+}
+
+//===----------------------------------------------------------------------===//
+// RaggedBatchDataset
+//===----------------------------------------------------------------------===//
+
+template <typename T>
+RCReference<Dataset> MakeRaggedBatchDataset(RCReference<Dataset>* dataset,
+                                            Attribute<int32_t> batch_size,
+                                            const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return MaybeCollectStats(TakeRef(host->Construct<RaggedBatchDataset<T>>(
+                               dataset->CopyRef(), batch_size.get(), host)),
+                           "RaggedBatchDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
 // PrefetchDataset
 //===----------------------------------------------------------------------===//
 
-RCReference<PrefetchDataset> MakePrefetchDataset(
-    RCReference<Dataset>* dataset, const ExecutionContext& exec_ctx) {
+RCReference<Dataset> MakePrefetchDataset(RCReference<Dataset>* dataset,
+                                         const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  return TakeRef(host->Construct<PrefetchDataset>(
-      dataset->CopyRef(), host->GetNumWorkerThreads(), host));
+  return MaybeCollectStats(
+      TakeRef(host->Construct<PrefetchDataset>(
+          dataset->CopyRef(), host->GetNumWorkerThreads(), host)),
+      "PrefetchDataset", {dataset->get()}, host);
 }
 
 //===----------------------------------------------------------------------===//
@@ -396,6 +494,28 @@ static void EnumerateIterator(RemainingArguments args, RemainingResults results,
       });
 }
 
+//===----------------------------------------------------------------------===//
+// Iterator statistics
+//===----------------------------------------------------------------------===//
+
+// Enables statistics collection for the datasets created after this kernel
+// runs. Datasets created before are not instrumented, so with statistics
+// disabled iterators run without any bookkeeping overhead.
+static Chain EnableIteratorStats(Chain chain,
+                                 const ExecutionContext& exec_ctx) {
+  exec_ctx.host()->GetOrCreateSharedContext<IteratorStatsRegistry>().Enable();
+  return Chain();
+}
+
+// Prints the statistics of all instrumented datasets as a tree, where every
+// node is a dataset and its children are the input datasets.
+static Chain PrintIteratorStats(Chain chain, const ExecutionContext& exec_ctx) {
+  exec_ctx.host()->GetOrCreateSharedContext<IteratorStatsRegistry>().Print(
+      tfrt::outs());
+  tfrt::outs().flush();
+  return Chain();
+}
+
 //===----------------------------------------------------------------------===//
 // Kernel registrations
 //===----------------------------------------------------------------------===//
@@ -407,6 +527,9 @@ void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("data.iterator_get_next", TFRT_KERNEL(IteratorGetNext));
   registry->AddKernel("data.enumerate.iterator",
                       TFRT_KERNEL(EnumerateIterator));
+  registry->AddKernel("data.enable_iterator_stats",
+                      TFRT_KERNEL(EnableIteratorStats));
+  registry->AddKernel("data.iterator_stats", TFRT_KERNEL(PrintIteratorStats));
 
   // TODO(b/155892156): Remove type specialization on dataset kernels.
   registry->AddKernel("data.make_dataset_from_values.i32",
@@ -437,6 +560,20 @@ void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("data.batch_dataset.i64_and_i64",
                       TFRT_KERNEL(MakeBatchDataset<int64_t, int64_t>));
 
+  registry->AddKernel("data.padded_batch_dataset.i32",
+                      TFRT_KERNEL(MakePaddedBatchDataset<int32_t>));
+  registry->AddKernel("data.padded_batch_dataset.i64",
+                      TFRT_KERNEL(MakePaddedBatchDataset<int64_t>));
+  registry->AddKernel("data.padded_batch_dataset.f32",
+                      TFRT_KERNEL(MakePaddedBatchDataset<float>));
+
+  registry->AddKernel("data.ragged_batch_dataset.i32",
+                      TFRT_KERNEL(MakeRaggedBatchDataset<int32_t>));
+  registry->AddKernel("data.ragged_batch_dataset.i64",
+                      TFRT_KERNEL(MakeRaggedBatchDataset<int64_t>));
+  registry->AddKernel("data.ragged_batch_dataset.f32",
+                      TFRT_KERNEL(MakeRaggedBatchDataset<float>));
+
   registry->AddKernel("data.memory_dataset.i64",
                       TFRT_KERNEL(MakeMemoryDataset<int64_t>));
   registry->AddKernel("data.memory_dataset.str",
@@ -444,9 +581,13 @@ void RegisterDataKernels(KernelRegistry* registry) {
 
   registry->AddKernel("data.filter_dataset.i64",
                       TFRT_KERNEL(MakeFilterDataset<int64_t>));
+  registry->AddKernel("data.batched_filter_dataset.i64",
+                      TFRT_KERNEL(MakeBatchedFilterDataset<int64_t>));
 
   registry->AddKernel("data.tf_record_dataset",
                       TFRT_KERNEL(MakeTFRecordDataset));
+  registry->AddKernel("data.sharded_tf_record_dataset",
+                      TFRT_KERNEL(MakeShardedTFRecordDataset));
   registry->AddKernel("data.map_dataset", TFRT_KERNEL(MakeMapDataset));
   registry->AddKernel("data.prefetch_dataset",
                       TFRT_KERNEL(MakePrefetchDataset));
@@ -25,6 +25,7 @@
 
 #include <memory>
 
+#include "llvm/ADT/Optional.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_allocator.h"
 #include "tfrt/host_context/host_context.h"
@@ -143,6 +144,10 @@ class Iterator : public ReferenceCounted<Iterator> {
 
   virtual IterationResult GetNext(const ExecutionContext& exec_ctx) = 0;
 
+  // Returns the number of completed elements buffered ahead of the GetNext()
+  // calls for prefetching iterators, and None for all other iterators.
+  virtual Optional<size_t> NumBufferedElements() const { return llvm::None; }
+
  protected:
   // For access to Destroy().
   friend class ReferenceCounted<Iterator>;
@@ -40,18 +40,27 @@ namespace data {
 template <typename... T>
 class FilterDatasetIterator;
 
+template <typename... T>
+class BatchedFilterDatasetIterator;
+
 // FilterDataset takes elements from the underlying dataset and outputs those
 // elements which satisfy a user-defined filter function.
+//
+// If `batch_size` is larger than 1, the iterator pulls elements from the
+// underlying dataset `batch_size` at a time and evaluates the filter function
+// for the whole batch in a tight loop on a single thread. This amortizes the
+// per-element asynchronous bookkeeping for cheap and selective filters.
 template <typename... T>
 class FilterDataset : public Dataset {
  public:
   explicit FilterDataset(RCReference<Dataset> input_dataset,
                          RCReference<const Function> filter_fn,
-                         HostContext* host)
+                         HostContext* host, int32_t batch_size = 1)
       : input_dataset_(std::move(input_dataset)),
         host_(host),
         allocator_(host->allocator()),
-        filter_fn_(std::move(filter_fn)) {}
+        filter_fn_(std::move(filter_fn)),
+        batch_size_(batch_size) {}
 
   // This class is not copyable or movable.
   FilterDataset(const FilterDataset&) = delete;
@@ -60,8 +69,9 @@ class FilterDataset : public Dataset {
   RCReference<Iterator> MakeIterator() override;
 
  private:
-  // Allow iterator to rely on private data members of this dataset.
+  // Allow iterators to rely on private data members of this dataset.
   friend class FilterDatasetIterator<T...>;
+  friend class BatchedFilterDatasetIterator<T...>;
 
   void Destroy() override {
     internal::DestroyImpl<FilterDataset<T...>>(this, allocator_);
@@ -73,6 +83,9 @@ class FilterDataset : public Dataset {
   // The function should take value from the `input_dataset_` as input and
   // then output a boolean value.
   RCReference<const Function> filter_fn_;
+  // The number of elements fetched from the `input_dataset_` and filtered
+  // together by the BatchedFilterDatasetIterator.
+  const int32_t batch_size_;
 };
 
 template <typename... T>
@@ -167,8 +180,87 @@ class FilterDatasetIterator : public Iterator {
   bool token_owned_ TFRT_GUARDED_BY(mu_);
 };
 
+// BatchedFilterDatasetIterator fetches `batch_size` elements from the input
+// iterator at a time. When all of them are available, it evaluates the filter
+// function for every element of the batch in a tight loop in a single task, and
+// buffers the elements which satisfy the predicate. GetNext() requests are
+// fulfilled in order from this buffer.
+//
+// At most one batch is in flight at any time, which guarantees in-order
+// delivery of the results.
+template <typename... T>
+class BatchedFilterDatasetIterator : public Iterator {
+ public:
+  explicit BatchedFilterDatasetIterator(
+      RCReference<FilterDataset<T...>> parent_dataset)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator()) {}
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override {
+    auto* host = exec_ctx.host();
+
+    llvm::SmallVector<RCReference<AsyncValue>, 4> result_values;
+    result_values.resize(sizeof...(T));
+    for (size_t i = 0; i < sizeof...(T); ++i) {
+      result_values[i] = host->MakeIndirectAsyncValue();
+    }
+    auto result_eof = host->MakeUnconstructedAsyncValueRef<bool>();
+    auto result = IterationResult::Pending(std::move(result_values),
+                                           std::move(result_eof));
+    {
+      mutex_lock lock(mu_);
+      output_buffer_.push(result.CopyRef());
+    }
+    MaybeFetchInputs(exec_ctx);
+    return result;
+  }
+
+ private:
+  // This class is not copyable or movable.
+  BatchedFilterDatasetIterator(const BatchedFilterDatasetIterator&) = delete;
+  BatchedFilterDatasetIterator& operator=(const BatchedFilterDatasetIterator&) =
+      delete;
+
+  void Destroy() override {
+    internal::DestroyImpl<BatchedFilterDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  // Fulfills pending outputs from the buffer of filtered elements. If there
+  // are still unfulfilled outputs, and no batch is in flight, fetches the next
+  // batch of elements from the `input_iterator_`.
+  void MaybeFetchInputs(const ExecutionContext& exec_ctx) TFRT_EXCLUDES(mu_);
+
+  // Evaluates the filter function for all `inputs`, appends the elements which
+  // satisfy the predicate to the `filtered_buffer_`, and then tries to fulfill
+  // pending outputs.
+  void FilterInputs(SmallVector<IterationResult, 16> inputs,
+                    const ExecutionContext& exec_ctx) TFRT_EXCLUDES(mu_);
+
+  RCReference<FilterDataset<T...>> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+
+  mutex mu_;
+  // A queue of IterationResult that have already been returned to the
+  // GetNext(...) caller.
+  std::queue<IterationResult> output_buffer_ TFRT_GUARDED_BY(mu_);
+  // A queue of available input elements which satisfy the predicate, or errors
+  // that must be forwarded to the outputs.
+  std::queue<IterationResult> filtered_buffer_ TFRT_GUARDED_BY(mu_);
+  // True if there is a batch of inputs fetched from the `input_iterator_` that
+  // is not yet filtered.
+  bool fetch_in_flight_ TFRT_GUARDED_BY(mu_) = false;
+  // True if the `input_iterator_` has been exhausted.
+  bool end_of_input_ TFRT_GUARDED_BY(mu_) = false;
+};
+
 template <typename... T>
 RCReference<Iterator> FilterDataset<T...>::MakeIterator() {
+  if (batch_size_ > 1) {
+    return TakeRef(
+        host_->Construct<BatchedFilterDatasetIterator<T...>>(FormRef(this)));
+  }
   return TakeRef(host_->Construct<FilterDatasetIterator<T...>>(FormRef(this)));
 }
 
@@ -291,6 +383,152 @@ void FilterDatasetIterator<T...>::MaybeScheduleBackgroundTask(
   });
 }
 
+template <typename... T>
+void BatchedFilterDatasetIterator<T...>::MaybeFetchInputs(
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+
+  // Pairs of pending outputs and the values they should be forwarded to.
+  SmallVector<std::pair<IterationResult, IterationResult>, 4> ready;
+  // Pending outputs that should be fulfilled with EOF.
+  SmallVector<IterationResult, 4> eof;
+  bool fetch = false;
+  {
+    mutex_lock lock(mu_);
+    while (!output_buffer_.empty() && !filtered_buffer_.empty()) {
+      ready.emplace_back(std::move(output_buffer_.front()),
+                         std::move(filtered_buffer_.front()));
+      output_buffer_.pop();
+      filtered_buffer_.pop();
+    }
+    if (!output_buffer_.empty()) {
+      if (end_of_input_) {
+        while (!output_buffer_.empty()) {
+          eof.push_back(std::move(output_buffer_.front()));
+          output_buffer_.pop();
+        }
+      } else if (!fetch_in_flight_) {
+        fetch_in_flight_ = true;
+        fetch = true;
+      }
+    }
+  }
+
+  // Forward values outside of the lock, because it might run arbitrary
+  // callbacks waiting for the outputs.
+  for (auto& output_and_value : ready) {
+    auto& output = output_and_value.first;
+    auto& value = output_and_value.second;
+    for (size_t i = 0; i < sizeof...(T); ++i) {
+      auto* output_value = cast<IndirectAsyncValue>(output.values[i].get());
+      output_value->ForwardTo(std::move(value.values[i]));
+    }
+    if (value.eof.IsError()) {
+      output.eof.SetError(value.eof.GetError());
+    } else {
+      output.eof.emplace(false);
+    }
+  }
+  if (!eof.empty()) {
+    auto error = host->MakeErrorAsyncValueRef("iterator reached end");
+    for (auto& output : eof) {
+      for (auto& value : output.values) {
+        value->SetError(error->GetError());
+      }
+      output.eof.emplace(true);
+    }
+  }
+
+  if (!fetch) return;
+
+  // Fetch the next batch of inputs, and filter them when all of them are
+  // available.
+  SmallVector<IterationResult, 16> inputs;
+  SmallVector<AsyncValue*, 32> async_value_ptrs;
+  for (int i = 0; i < parent_dataset_->batch_size_; ++i) {
+    auto input = input_iterator_->GetNext(exec_ctx);
+    const bool end_of_input = internal::IsConcreteAndEmpty(input);
+    for (auto* value : input.AsyncValues()) async_value_ptrs.push_back(value);
+    inputs.push_back(std::move(input));
+    if (end_of_input) break;
+  }
+
+  host->RunWhenReady(async_value_ptrs, [exec_ctx, host,
+                                        inputs = std::move(inputs),
+                                        iterator = FormRef(this)]() mutable {
+    // Always filter inputs in a separate task, so that the stack does not grow
+    // with the number of batches when inputs are available immediately.
+    host->EnqueueWork([exec_ctx, inputs = std::move(inputs),
+                       iterator = std::move(iterator)]() mutable {
+      iterator->FilterInputs(std::move(inputs), exec_ctx);
+    });
+  });
+}
+
+template <typename... T>
+void BatchedFilterDatasetIterator<T...>::FilterInputs(
+    SmallVector<IterationResult, 16> inputs, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  const Function* filter_fn = parent_dataset_->filter_fn_.get();
+
+  // Evaluate the predicate for every valid input in a tight loop. Predicates of
+  // inputs that do not have to be filtered are left empty.
+  SmallVector<RCReference<AsyncValue>, 16> predicates;
+  predicates.resize(inputs.size());
+  SmallVector<AsyncValue*, 16> pending_predicates;
+  SmallVector<AsyncValue*, 4> args;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const auto& input = inputs[i];
+    if (input.eof.IsError() || input.eof.get()) continue;
+    if (llvm::any_of(input.values, [](auto& v) { return v->IsError(); }))
+      continue;
+
+    args.clear();
+    for (const auto& value : input.values) args.push_back(value.get());
+    filter_fn->Execute(args, MutableArrayRef<RCReference<AsyncValue>>(
+                                 &predicates[i], 1),
+                       host);
+    if (!predicates[i]->IsAvailable())
+      pending_predicates.push_back(predicates[i].get());
+  }
+
+  // For synchronous filter functions all predicates are already available.
+  host->RunWhenReady(pending_predicates, [exec_ctx, inputs = std::move(inputs),
+                                          predicates = std::move(predicates),
+                                          iterator = FormRef(this)]() mutable {
+    {
+      mutex_lock lock(iterator->mu_);
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        auto& input = inputs[i];
+        if (input.eof.IsError()) {
+          iterator->filtered_buffer_.push(std::move(input));
+          continue;
+        }
+        if (input.eof.get()) {
+          iterator->end_of_input_ = true;
+          break;
+        }
+        auto error_value = llvm::find_if(
+            input.values, [](auto& value) { return value->IsError(); });
+        if (error_value != input.values.end()) {
+          iterator->filtered_buffer_.push(
+              IterationResult::Error(error_value->CopyRef(), sizeof...(T)));
+          continue;
+        }
+        auto& predicate = predicates[i];
+        if (predicate->IsError()) {
+          iterator->filtered_buffer_.push(
+              IterationResult::Error(std::move(predicate), sizeof...(T)));
+        } else if (predicate->get<bool>()) {
+          iterator->filtered_buffer_.push(std::move(input));
+        }
+      }
+      iterator->fetch_in_flight_ = false;
+    }
+    iterator->MaybeFetchInputs(exec_ctx);
+  });
+}
+
 }  // namespace data
 }  // namespace tfrt
 
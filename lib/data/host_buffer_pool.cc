@@ -0,0 +1,78 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- host_buffer_pool.cc ------------------------------------------------===//
+//
+// This file implements HostBufferPool.
+//
+//===----------------------------------------------------------------------===//
+
+#include "host_buffer_pool.h"
+
+namespace tfrt {
+namespace data {
+
+HostBufferPool::~HostBufferPool() {
+  for (auto& buffer : free_buffers_) {
+    allocator_->DeallocateBytes(buffer.first, buffer.second);
+  }
+}
+
+RCReference<HostBuffer> HostBufferPool::Allocate(size_t size) {
+  void* ptr = nullptr;
+  {
+    mutex_lock lock(mu_);
+    for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+      if (it->second == size) {
+        ptr = it->first;
+        free_buffers_.erase(it);
+        break;
+      }
+    }
+  }
+
+  if (ptr == nullptr) ptr = allocator_->AllocateBytes(size, kAlignment);
+  if (ptr == nullptr) return {};
+
+  return HostBuffer::CreateFromExternal(
+      ptr, size, [pool = FormRef(this)](void* ptr, size_t size) {
+        pool->Release(ptr, size);
+      });
+}
+
+void HostBufferPool::Release(void* ptr, size_t size) {
+  if (max_cached_buffers_ == 0) {
+    allocator_->DeallocateBytes(ptr, size);
+    return;
+  }
+
+  std::pair<void*, size_t> evicted = {nullptr, 0};
+  {
+    mutex_lock lock(mu_);
+    // Evict the least recently released block if the pool is full, so that
+    // blocks of a stale size (e.g. from a smaller last batch) do not occupy
+    // the pool forever.
+    if (free_buffers_.size() >= max_cached_buffers_) {
+      evicted = free_buffers_.front();
+      free_buffers_.erase(free_buffers_.begin());
+    }
+    free_buffers_.emplace_back(ptr, size);
+  }
+  if (evicted.first != nullptr) {
+    allocator_->DeallocateBytes(evicted.first, evicted.second);
+  }
+}
+
+}  // namespace data
+}  // namespace tfrt
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- host_buffer_pool.h ---------------------------------------*- C++ -*-===//
+//
+// This file declares HostBufferPool, a small cache of host memory blocks that
+// lets data pipeline stages reuse output buffers across iterations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_LIB_DATA_HOST_BUFFER_POOL_H_
+#define TFRT_LIB_DATA_HOST_BUFFER_POOL_H_
+
+#include <utility>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace data {
+
+// HostBufferPool hands out HostBuffers whose memory is returned to the pool,
+// instead of the allocator, when the last reference to the buffer is dropped.
+// Pipeline stages like BatchDataset produce a sequence of equally sized
+// outputs, so recycling the memory avoids a large allocation (and page faults
+// on first touch) for every produced element.
+//
+// Buffers handed out by the pool keep a reference to the pool, so it is safe
+// for them to outlive the dataset that owns the pool. HostBufferPool is thread
+// safe.
+class HostBufferPool : public ReferenceCounted<HostBufferPool> {
+ public:
+  // Alignment of all buffers allocated by the pool. Cache line alignment
+  // allows aligned vector (and non-temporal) stores into the buffer.
+  static constexpr size_t kAlignment = 64;
+
+  // `allocator` must outlive the pool and all buffers allocated from it.
+  HostBufferPool(size_t max_cached_buffers, HostAllocator* allocator)
+      : max_cached_buffers_(max_cached_buffers), allocator_(allocator) {}
+
+  ~HostBufferPool();
+
+  // This class is not copyable or movable.
+  HostBufferPool(const HostBufferPool&) = delete;
+  HostBufferPool& operator=(const HostBufferPool&) = delete;
+
+  // Returns a buffer of `size` bytes, reusing a cached memory block of the same
+  // size if there is one. Returns a null RCReference on allocation failure.
+  RCReference<HostBuffer> Allocate(size_t size);
+
+ private:
+  // Returns the memory block back to the pool. If the pool is full, the least
+  // recently released block is returned to the allocator.
+  void Release(void* ptr, size_t size);
+
+  const size_t max_cached_buffers_;
+  HostAllocator* allocator_;
+
+  mutex mu_;
+  // Memory blocks available for reuse, and their sizes.
+  llvm::SmallVector<std::pair<void*, size_t>, 4> free_buffers_
+      TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_HOST_BUFFER_POOL_H_
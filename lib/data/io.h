@@ -81,6 +81,11 @@ class PrefetchingIterator : public Iterator {
   // empty, reads next element from the derived iterator.
   IterationResult GetNext(const ExecutionContext& exec_ctx) final;
 
+  Optional<size_t> NumBufferedElements() const final {
+    mutex_lock lock(state_mu_);
+    return buffer_.size();
+  }
+
  protected:
   // Reads the next element from the underlying IO source. Prefetching iterator
   // guarantees that all calls to this function will be properly synchronized.
@@ -95,7 +100,7 @@ class PrefetchingIterator : public Iterator {
   // State mutext guards access to prefetch buffer and prefetch state. It
   // synchronizes concurrent access between PrefetchingIterator::GetNext()
   // and asynchronous prefetch tasks.
-  mutex state_mu_;
+  mutable mutex state_mu_;
 
   // Input mutex guards non thread safe IO operations implemented by the
   // derived iterator. In practice if asynchronous prefetch tasks are running
@@ -0,0 +1,257 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//===- iterator_stats.cc --------------------------------------------------===//
+//
+// This file implements classes that collect input pipeline statistics.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iterator_stats.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace data {
+
+namespace {
+
+// Returns the number of bytes held by a concrete iterator value. Only tensors
+// and strings are accounted for, other values (and values that are forwarded
+// through an IndirectAsyncValue) count as zero bytes.
+size_t ValueSizeInBytes(const AsyncValue& value) {
+  if (value.IsType<DenseHostTensor>()) {
+    return value.get<DenseHostTensor>().DataSizeInBytes();
+  }
+  if (value.IsType<std::string>()) {
+    return value.get<std::string>().size();
+  }
+  return 0;
+}
+
+void UpdateMax(std::atomic<int64_t>* max, int64_t value) {
+  int64_t current = max->load(std::memory_order_relaxed);
+  while (current < value &&
+         !max->compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// IteratorStats methods
+//===----------------------------------------------------------------------===//
+
+void IteratorStats::RecordGetNext(Clock::time_point start) {
+  num_get_next_calls_.fetch_add(1, std::memory_order_relaxed);
+  int64_t expected = 0;
+  first_get_next_ns_.compare_exchange_strong(expected, ToNanos(start),
+                                             std::memory_order_relaxed);
+}
+
+void IteratorStats::RecordElement(Clock::duration latency, size_t bytes) {
+  const int64_t latency_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+  num_elements_.fetch_add(1, std::memory_order_relaxed);
+  num_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  total_latency_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  UpdateMax(&max_latency_ns_, latency_ns);
+  UpdateMax(&last_element_ns_, ToNanos(Clock::now()));
+}
+
+void IteratorStats::RecordBufferOccupancy(size_t num_buffered_elements) {
+  buffer_occupancy_sum_.fetch_add(num_buffered_elements,
+                                  std::memory_order_relaxed);
+  num_buffer_samples_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IteratorStats::Print(raw_ostream& os, int indent) const {
+  const int64_t num_elements = num_elements_.load(std::memory_order_relaxed);
+  const int64_t num_bytes = num_bytes_.load(std::memory_order_relaxed);
+  const int64_t total_latency_ns =
+      total_latency_ns_.load(std::memory_order_relaxed);
+  const int64_t max_latency_ns =
+      max_latency_ns_.load(std::memory_order_relaxed);
+
+  os.indent(indent) << name_ << ": elements = " << num_elements
+                    << ", get_next_calls = "
+                    << num_get_next_calls_.load(std::memory_order_relaxed)
+                    << ", bytes = " << num_bytes;
+
+  if (num_elements > 0) {
+    os << ", avg_latency_us = "
+       << llvm::format("%.2f", total_latency_ns / 1e3 / num_elements)
+       << ", max_latency_us = " << llvm::format("%.2f", max_latency_ns / 1e3);
+
+    const int64_t elapsed_ns =
+        last_element_ns_.load(std::memory_order_relaxed) -
+        first_get_next_ns_.load(std::memory_order_relaxed);
+    if (elapsed_ns > 0) {
+      const double elapsed_s = elapsed_ns / 1e9;
+      os << ", elements_per_sec = "
+         << llvm::format("%.2f", num_elements / elapsed_s)
+         << ", mb_per_sec = "
+         << llvm::format("%.2f", num_bytes / elapsed_s / (1 << 20));
+    }
+  }
+
+  const int64_t num_buffer_samples =
+      num_buffer_samples_.load(std::memory_order_relaxed);
+  if (num_buffer_samples > 0) {
+    os << ", avg_buffer_occupancy = "
+       << llvm::format("%.2f",
+                       static_cast<double>(buffer_occupancy_sum_.load(
+                           std::memory_order_relaxed)) /
+                           num_buffer_samples);
+  }
+  os << '\n';
+
+  for (const IteratorStats* input : inputs_) input->Print(os, indent + 2);
+}
+
+//===----------------------------------------------------------------------===//
+// IteratorStatsRegistry methods
+//===----------------------------------------------------------------------===//
+
+IteratorStats* IteratorStatsRegistry::AddNode(string_view name,
+                                              ArrayRef<const Dataset*> inputs) {
+  mutex_lock lock(mu_);
+  std::vector<IteratorStats*> input_nodes;
+  for (const Dataset* input : inputs) {
+    auto it = dataset_nodes_.find(input);
+    if (it == dataset_nodes_.end()) continue;
+    input_nodes.push_back(it->second);
+    ++node_refs_[it->second];
+  }
+
+  std::string node_name;
+  llvm::raw_string_ostream(node_name) << name << '#' << next_node_id_++;
+  nodes_.push_back(
+      std::make_unique<IteratorStats>(node_name, std::move(input_nodes)));
+  return nodes_.back().get();
+}
+
+void IteratorStatsRegistry::AddDataset(const Dataset* dataset,
+                                       IteratorStats* stats) {
+  mutex_lock lock(mu_);
+  dataset_nodes_[dataset] = stats;
+  ++node_refs_[stats];
+}
+
+void IteratorStatsRegistry::RemoveDataset(const Dataset* dataset) {
+  mutex_lock lock(mu_);
+  auto it = dataset_nodes_.find(dataset);
+  if (it == dataset_nodes_.end()) return;
+  IteratorStats* stats = it->second;
+  dataset_nodes_.erase(it);
+  if (!DropRefLocked(stats)) return;
+
+  // Keep the statistics of the finished node until they are printed.
+  finished_nodes_.push_back(stats);
+  if (finished_nodes_.size() > kMaxFinishedNodes) {
+    RemoveNodeLocked(finished_nodes_.front());
+    finished_nodes_.pop_front();
+  }
+}
+
+bool IteratorStatsRegistry::DropRefLocked(IteratorStats* node) {
+  auto refs = node_refs_.find(node);
+  assert(refs != node_refs_.end() && refs->second > 0);
+  if (--refs->second > 0) return false;
+  node_refs_.erase(refs);
+  return true;
+}
+
+void IteratorStatsRegistry::RemoveNodeLocked(IteratorStats* node) {
+  auto it = llvm::find_if(nodes_, [node](const auto& n) {
+    return n.get() == node;
+  });
+  assert(it != nodes_.end());
+  std::unique_ptr<IteratorStats> removed = std::move(*it);
+  nodes_.erase(it);
+  // Inputs that are not referenced anymore were printed as a part of `node`.
+  for (IteratorStats* input : removed->inputs()) {
+    if (DropRefLocked(input)) RemoveNodeLocked(input);
+  }
+}
+
+void IteratorStatsRegistry::Print(raw_ostream& os) {
+  mutex_lock lock(mu_);
+  llvm::DenseSet<const IteratorStats*> inputs;
+  for (const auto& node : nodes_) {
+    for (const IteratorStats* input : node->inputs()) inputs.insert(input);
+  }
+  for (const auto& node : nodes_) {
+    if (!inputs.count(node.get())) node->Print(os);
+  }
+
+  for (IteratorStats* node : finished_nodes_) RemoveNodeLocked(node);
+  finished_nodes_.clear();
+}
+
+//===----------------------------------------------------------------------===//
+// StatsDataset methods
+//===----------------------------------------------------------------------===//
+
+RCReference<Iterator> StatsDataset::MakeIterator() {
+  return TakeRef(host_->Construct<StatsIterator>(FormRef(this)));
+}
+
+//===----------------------------------------------------------------------===//
+// StatsIterator methods
+//===----------------------------------------------------------------------===//
+
+IterationResult StatsIterator::GetNext(const ExecutionContext& exec_ctx) {
+  IteratorStats* stats = parent_dataset_->stats_;
+  const auto start = IteratorStats::Clock::now();
+  stats->RecordGetNext(start);
+
+  auto result = input_iterator_->GetNext(exec_ctx);
+  if (auto num_buffered_elements = input_iterator_->NumBufferedElements()) {
+    stats->RecordBufferOccupancy(*num_buffered_elements);
+  }
+
+  exec_ctx.host()->RunWhenReady(
+      result.AsyncValues(), [stats, start, result = result.CopyRef()]() {
+        // End of iteration and errors do not produce an element.
+        if (result.eof.IsError() || *result.eof) return;
+
+        size_t bytes = 0;
+        for (const auto& value : result.values) {
+          if (!value->IsError()) bytes += ValueSizeInBytes(*value);
+        }
+        stats->RecordElement(IteratorStats::Clock::now() - start, bytes);
+      });
+
+  return result;
+}
+
+RCReference<Dataset> MaybeCollectStats(RCReference<Dataset> dataset,
+                                       string_view name,
+                                       ArrayRef<const Dataset*> inputs,
+                                       HostContext* host) {
+  auto& registry = host->GetOrCreateSharedContext<IteratorStatsRegistry>();
+  if (!registry.IsEnabled()) return dataset;
+
+  IteratorStats* stats = registry.AddNode(name, inputs);
+  return TakeRef(host->Construct<StatsDataset>(std::move(dataset), stats,
+                                               &registry, host));
+}
+
+}  // namespace data
+}  // namespace tfrt
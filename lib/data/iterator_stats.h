@@ -0,0 +1,221 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- iterator_stats.h -----------------------------------------*- C++ -*-===//
+//
+// This file declares classes that collect per dataset node statistics of the
+// input pipeline iterators: number of produced elements, GetNext() latency,
+// produced bytes and prefetch buffer occupancy.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_LIB_DATA_ITERATOR_STATS_H_
+#define TFRT_LIB_DATA_ITERATOR_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "dataset.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/host_context/shared_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+
+namespace tfrt {
+namespace data {
+
+// IteratorStats accumulates statistics of all iterators created from a single
+// dataset node of the input pipeline. All methods are thread safe.
+class IteratorStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  IteratorStats(std::string name, std::vector<IteratorStats*> inputs)
+      : name_(std::move(name)), inputs_(std::move(inputs)) {}
+
+  // Records a call to Iterator::GetNext() made at `start`.
+  void RecordGetNext(Clock::time_point start);
+
+  // Records an element of `bytes` bytes that became available `latency` after
+  // the corresponding call to Iterator::GetNext().
+  void RecordElement(Clock::duration latency, size_t bytes);
+
+  // Records the number of elements buffered by a prefetching iterator.
+  void RecordBufferOccupancy(size_t num_buffered_elements);
+
+  // Prints statistics of this node and all its inputs as a tree.
+  void Print(raw_ostream& os, int indent = 0) const;
+
+  const std::string& name() const { return name_; }
+  ArrayRef<IteratorStats*> inputs() const { return inputs_; }
+
+ private:
+  static int64_t ToNanos(Clock::time_point time_point) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               time_point.time_since_epoch())
+        .count();
+  }
+
+  const std::string name_;
+  const std::vector<IteratorStats*> inputs_;
+
+  std::atomic<int64_t> num_get_next_calls_{0};
+  std::atomic<int64_t> num_elements_{0};
+  std::atomic<int64_t> num_bytes_{0};
+  std::atomic<int64_t> total_latency_ns_{0};
+  std::atomic<int64_t> max_latency_ns_{0};
+  std::atomic<int64_t> buffer_occupancy_sum_{0};
+  std::atomic<int64_t> num_buffer_samples_{0};
+
+  // Time of the first GetNext() call and of the last produced element, in
+  // nanoseconds since the clock epoch. Used to compute the throughput.
+  std::atomic<int64_t> first_get_next_ns_{0};
+  std::atomic<int64_t> last_element_ns_{0};
+};
+
+// IteratorStatsRegistry owns the statistics of the dataset nodes created in a
+// HostContext after statistics collection was enabled. A node is finished once
+// its dataset is destroyed and it is no longer an input of another node.
+// StatsIterators keep their StatsDataset alive, so this happens after the last
+// iterator of the node is destroyed. Finished nodes are kept, together with
+// their inputs, until they are printed.
+class IteratorStatsRegistry : public SharedContext {
+ public:
+  // The maximum number of finished nodes kept until they are printed. When it
+  // is exceeded, the nodes that finished first are removed.
+  static constexpr size_t kMaxFinishedNodes = 256;
+
+  explicit IteratorStatsRegistry(HostContext* host) {}
+
+  void Enable() { enabled_.store(true, std::memory_order_release); }
+  bool IsEnabled() const { return enabled_.load(std::memory_order_acquire); }
+
+  // Creates a statistics node named `name`. The statistics nodes of `inputs`
+  // become the children of the new node.
+  IteratorStats* AddNode(string_view name, ArrayRef<const Dataset*> inputs);
+
+  // Associates `dataset` with its statistics node, so that the datasets that
+  // take `dataset` as an input can find it.
+  void AddDataset(const Dataset* dataset, IteratorStats* stats);
+
+  // Forgets the association between `dataset` and its statistics node. The
+  // node is finished unless it is still an input of another node.
+  void RemoveDataset(const Dataset* dataset);
+
+  // Prints statistics of all dataset nodes as a forest, where the roots are
+  // the nodes that are not inputs of any other node. Finished nodes are
+  // removed after they are printed.
+  void Print(raw_ostream& os);
+
+ private:
+  // Drops a reference to `node`. Returns true if this was the last reference.
+  bool DropRefLocked(IteratorStats* node) TFRT_REQUIRES(mu_);
+
+  // Removes `node`, together with the inputs that are not referenced anymore.
+  void RemoveNodeLocked(IteratorStats* node) TFRT_REQUIRES(mu_);
+
+  std::atomic<bool> enabled_{false};
+
+  mutable mutex mu_;
+  std::vector<std::unique_ptr<IteratorStats>> nodes_ TFRT_GUARDED_BY(mu_);
+  llvm::DenseMap<const Dataset*, IteratorStats*> dataset_nodes_
+      TFRT_GUARDED_BY(mu_);
+  // Number of references to every node in `nodes_`: one from its dataset and
+  // one from every node that takes it as an input. Finished nodes have none.
+  llvm::DenseMap<const IteratorStats*, int> node_refs_ TFRT_GUARDED_BY(mu_);
+  // Finished nodes that were not printed yet, in the order they finished.
+  std::deque<IteratorStats*> finished_nodes_ TFRT_GUARDED_BY(mu_);
+  int next_node_id_ TFRT_GUARDED_BY(mu_) = 0;
+};
+
+// StatsDataset wraps around another dataset and wraps every iterator created
+// from it into a StatsIterator that records the statistics of that dataset
+// node.
+class StatsDataset : public Dataset {
+ public:
+  StatsDataset(RCReference<Dataset> input_dataset, IteratorStats* stats,
+               IteratorStatsRegistry* registry, HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        stats_(stats),
+        registry_(registry),
+        host_(host) {
+    registry_->AddDataset(this, stats_);
+  }
+
+  ~StatsDataset() override { registry_->RemoveDataset(this); }
+
+  // This class is not copyable or movable.
+  StatsDataset(const StatsDataset&) = delete;
+  StatsDataset& operator=(const StatsDataset&) = delete;
+
+  RCReference<Iterator> MakeIterator() override;
+
+ private:
+  friend class StatsIterator;
+
+  void Destroy() override {
+    internal::DestroyImpl<StatsDataset>(this, host_->allocator());
+  }
+
+  RCReference<Dataset> input_dataset_;
+  IteratorStats* stats_;
+  IteratorStatsRegistry* registry_;
+  HostContext* host_;
+};
+
+class StatsIterator : public Iterator {
+ public:
+  explicit StatsIterator(RCReference<StatsDataset> parent_dataset)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator()) {}
+
+  // This class is not copyable or movable.
+  StatsIterator(const StatsIterator&) = delete;
+  StatsIterator& operator=(const StatsIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+  Optional<size_t> NumBufferedElements() const override {
+    return input_iterator_->NumBufferedElements();
+  }
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<StatsIterator>(this,
+                                         parent_dataset_->host_->allocator());
+  }
+
+  RCReference<StatsDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+};
+
+// Returns `dataset` wrapped into a StatsDataset named `name` if statistics
+// collection is enabled for `host`, and `dataset` unchanged otherwise.
+// `inputs` are the input datasets of `dataset`.
+RCReference<Dataset> MaybeCollectStats(RCReference<Dataset> dataset,
+                                       string_view name,
+                                       ArrayRef<const Dataset*> inputs,
+                                       HostContext* host);
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_ITERATOR_STATS_H_
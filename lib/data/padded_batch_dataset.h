@@ -0,0 +1,286 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- padded_batch_dataset.h -----------------------------------*- C++ -*-===//
+//
+// This file declares PaddedBatchDataset class which wraps around another
+// Dataset instance of variable-shape tensors and batches the underlying
+// elements into a single tensor, padding every element to the per-batch
+// maximum shape.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_DATA_PADDED_BATCH_DATASET_H_
+#define TFRT_DATA_PADDED_BATCH_DATASET_H_
+
+#include <algorithm>
+
+#include "dataset.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+namespace data {
+
+template <typename T>
+class PaddedBatchDatasetIterator;
+
+namespace internal {
+
+// Returns the metadata of the tensor that holds all `inputs` batched together,
+// where each dimension is the maximum of the corresponding input dimensions.
+// All inputs must be DenseHostTensors of dtype T with the same rank.
+template <typename T>
+llvm::Expected<TensorMetadata> GetPaddedBatchMetadata(
+    ArrayRef<RCReference<AsyncValue>> inputs) {
+  assert(!inputs.empty());
+  const int rank = inputs[0]->get<DenseHostTensor>().shape().GetRank();
+
+  SmallVector<ssize_t, 4> batch_dims;
+  batch_dims.resize(rank + 1, 0);
+  batch_dims[0] = inputs.size();
+
+  for (const auto& input : inputs) {
+    const auto& tensor = input->get<DenseHostTensor>();
+    if (tensor.dtype() != GetDType<T>()) {
+      return MakeStringError("padded batch expected elements of dtype ",
+                             GetDType<T>(), " but got ", tensor.dtype());
+    }
+    if (tensor.shape().GetRank() != rank) {
+      return MakeStringError(
+          "padded batch requires elements of the same rank, but got ", rank,
+          " and ", tensor.shape().GetRank());
+    }
+    for (int i = 0; i < rank; ++i) {
+      batch_dims[i + 1] =
+          std::max(batch_dims[i + 1], tensor.shape().GetDimensionSize(i));
+    }
+  }
+
+  return TensorMetadata(GetDType<T>(), batch_dims);
+}
+
+// Copies a row-major tensor with dimensions `src_dims` into the row-major
+// buffer `dst` with dimensions `dst_dims`, filling every element of `dst` that
+// is out of the `src` bounds with `pad_value`. Every output element is written
+// exactly once.
+template <typename T>
+void CopyWithPadding(const T* src, ArrayRef<ssize_t> src_dims, T* dst,
+                     ArrayRef<ssize_t> dst_dims, T pad_value) {
+  assert(src_dims.size() == dst_dims.size());
+  if (src_dims.empty()) {
+    *dst = *src;
+    return;
+  }
+
+  if (src_dims.size() == 1) {
+    std::copy_n(src, src_dims[0], dst);
+    std::fill(dst + src_dims[0], dst + dst_dims[0], pad_value);
+    return;
+  }
+
+  ssize_t src_stride = 1, dst_stride = 1;
+  for (size_t i = 1; i < src_dims.size(); ++i) {
+    src_stride *= src_dims[i];
+    dst_stride *= dst_dims[i];
+  }
+
+  for (ssize_t i = 0; i < src_dims[0]; ++i) {
+    CopyWithPadding(src + i * src_stride, src_dims.drop_front(),
+                    dst + i * dst_stride, dst_dims.drop_front(), pad_value);
+  }
+  std::fill(dst + src_dims[0] * dst_stride, dst + dst_dims[0] * dst_stride,
+            pad_value);
+}
+
+// When all `inputs` are available, allocates the padded batch tensor and fills
+// it in a single parallel pass, with every input written to its own slice of
+// the output by one of the worker threads. Emplaces the batched tensor into
+// `result` or forwards the first error.
+template <typename T>
+void CopyToPaddedBatch(SmallVector<RCReference<AsyncValue>, 4> inputs,
+                       T pad_value, AsyncValueRef<DenseHostTensor> result,
+                       const ExecutionContext& exec_ctx) {
+  SmallVector<AsyncValue*, 4> async_value_ptrs;
+  for (const auto& input : inputs) async_value_ptrs.push_back(input.get());
+
+  exec_ctx.host()->RunWhenReady(async_value_ptrs, [inputs = std::move(inputs),
+                                                   pad_value,
+                                                   result = std::move(result),
+                                                   exec_ctx]() mutable {
+    for (const auto& input : inputs) {
+      if (input->IsError()) {
+        result.SetError(input->GetError());
+        return;
+      }
+    }
+
+    auto metadata = GetPaddedBatchMetadata<T>(inputs);
+    if (!metadata) {
+      result.SetError(EmitError(exec_ctx, metadata.takeError()));
+      return;
+    }
+
+    auto dht =
+        DenseHostTensor::CreateUninitialized(*metadata, exec_ctx.host());
+    if (!dht) {
+      result.SetError(
+          EmitError(exec_ctx, "failed to create uninitialized tensor"));
+      return;
+    }
+
+    SmallVector<ssize_t, 4> slice_dims;
+    metadata->shape.GetDimensions(&slice_dims);
+    slice_dims.erase(slice_dims.begin());
+    ssize_t slice_size = 1;
+    for (ssize_t dim : slice_dims) slice_size *= dim;
+
+    T* output = static_cast<T*>(dht->data());
+
+    ParallelFor(exec_ctx.host())
+        .Execute(
+            inputs.size(), ParallelFor::BlockSizes::Min(1),
+            [inputs = std::move(inputs), slice_dims = std::move(slice_dims),
+             slice_size, output, pad_value](size_t begin, size_t end) {
+              SmallVector<ssize_t, 4> input_dims;
+              for (size_t i = begin; i < end; ++i) {
+                const auto& input = inputs[i]->get<DenseHostTensor>();
+                input.shape().GetDimensions(&input_dims);
+                CopyWithPadding(static_cast<const T*>(input.data()),
+                                input_dims, output + i * slice_size,
+                                slice_dims, pad_value);
+              }
+            },
+            [result = std::move(result), dht = std::move(*dht)]() mutable {
+              result.emplace(std::move(dht));
+            });
+  });
+}
+
+}  // namespace internal
+
+// PaddedBatchDataset wraps around another Dataset instance whose elements are
+// DenseHostTensors of dtype T and of the same rank, but with possibly different
+// shapes, e.g. variable-length sequences or variable-size images.
+//
+// GetNext() returns a tensor with +1 dimension, where each of the other
+// dimensions is the maximum size of that dimension among the batched elements.
+// Each element is padded with `pad_value` to the batch shape.
+template <typename T>
+class PaddedBatchDataset : public Dataset {
+ public:
+  explicit PaddedBatchDataset(RCReference<Dataset> input_dataset,
+                              int32_t batch_size, T pad_value,
+                              HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        batch_size_(batch_size),
+        pad_value_(pad_value),
+        host_(host),
+        allocator_(host->allocator()) {}
+
+  // This class is not copyable or movable.
+  PaddedBatchDataset(const PaddedBatchDataset&) = delete;
+  PaddedBatchDataset& operator=(const PaddedBatchDataset&) = delete;
+
+  RCReference<Iterator> MakeIterator() override;
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class PaddedBatchDatasetIterator<T>;
+
+  void Destroy() override {
+    internal::DestroyImpl<PaddedBatchDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  const int32_t batch_size_;
+  const T pad_value_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+};
+
+template <typename T>
+class PaddedBatchDatasetIterator : public Iterator {
+ public:
+  explicit PaddedBatchDatasetIterator(
+      RCReference<PaddedBatchDataset<T>> parent_dataset)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator()) {}
+
+  // This class is not copyable or movable.
+  PaddedBatchDatasetIterator(const PaddedBatchDatasetIterator&) = delete;
+  PaddedBatchDatasetIterator& operator=(const PaddedBatchDatasetIterator&) =
+      delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<PaddedBatchDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<PaddedBatchDataset<T>> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+};
+
+template <typename T>
+RCReference<Iterator> PaddedBatchDataset<T>::MakeIterator() {
+  return TakeRef(
+      host_->Construct<PaddedBatchDatasetIterator<T>>(FormRef(this)));
+}
+
+// TODO(b/155918211): Handle asynchrous EOF from the input_iterator_
+template <typename T>
+IterationResult PaddedBatchDatasetIterator<T>::GetNext(
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  SmallVector<RCReference<AsyncValue>, 4> inputs;
+  // Get up to batch_size values from the underlying iterator.
+  for (int i = 0; i < parent_dataset_->batch_size_; ++i) {
+    auto input = input_iterator_->GetNext(exec_ctx);
+    if (internal::IsConcreteAndEmpty(input)) {
+      break;
+    }
+    assert(input.values.size() == 1);
+    inputs.push_back(std::move(input.values[0]));
+  }
+  if (inputs.empty()) {
+    return IterationResult::Eof(host, 1);
+  }
+
+  // The batch shape depends on the shapes of all inputs, so the output tensor
+  // can only be allocated after all of them are available.
+  auto result = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  internal::CopyToPaddedBatch<T>(std::move(inputs), parent_dataset_->pad_value_,
+                                 result.CopyRef(), exec_ctx);
+
+  SmallVector<RCReference<AsyncValue>, 4> results;
+  results.push_back(result.ReleaseRCRef());
+  return IterationResult::Values(std::move(results), host);
+}
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_PADDED_BATCH_DATASET_H_
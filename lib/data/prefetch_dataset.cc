@@ -23,6 +23,8 @@
 //===----------------------------------------------------------------------===//
 #include "prefetch_dataset.h"
 
+#include "llvm/ADT/STLExtras.h"
+
 namespace tfrt {
 namespace data {
 
@@ -39,12 +41,22 @@ RCReference<Iterator> PrefetchDataset::MakeIterator() {
 IterationResult PrefetchDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
   while (buffer_.size() < parent_dataset_->prefetch_num_) {
-    buffer_.push(input_iterator_->GetNext(exec_ctx));
+    buffer_.push_back(input_iterator_->GetNext(exec_ctx));
   }
   auto result = std::move(buffer_.front());
-  buffer_.pop();
+  buffer_.pop_front();
   return result;
 }
 
+Optional<size_t> PrefetchDatasetIterator::NumBufferedElements() const {
+  size_t num_ready = 0;
+  for (const auto& result : buffer_) {
+    auto values = result.AsyncValues();
+    if (llvm::all_of(values, [](AsyncValue* v) { return v->IsAvailable(); }))
+      ++num_ready;
+  }
+  return num_ready;
+}
+
 }  // namespace data
 }  // namespace tfrt
@@ -25,7 +25,7 @@
 #ifndef TFRT_LIB_DATA_PREFETCH_DATASET_H_
 #define TFRT_LIB_DATA_PREFETCH_DATASET_H_
 
-#include <queue>
+#include <deque>
 
 #include "dataset.h"
 #include "tfrt/support/forward_decls.h"
@@ -77,6 +77,10 @@ class PrefetchDatasetIterator : public Iterator {
 
   IterationResult GetNext(const ExecutionContext& exec_ctx) override;
 
+  // Returns the number of prefetched elements that are ready to be consumed.
+  // Elements still being computed by the input iterator are not counted.
+  Optional<size_t> NumBufferedElements() const override;
+
  private:
   void Destroy() override {
     internal::DestroyImpl<PrefetchDatasetIterator>(
@@ -85,7 +89,7 @@ class PrefetchDatasetIterator : public Iterator {
 
   RCReference<PrefetchDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
-  std::queue<IterationResult> buffer_;
+  std::deque<IterationResult> buffer_;
 };
 
 }  // namespace data
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- ragged_batch_dataset.h -----------------------------------*- C++ -*-===//
+//
+// This file declares RaggedBatchDataset class which wraps around another
+// Dataset instance of variable-length tensors and batches the underlying
+// elements into a flat values tensor and a row splits tensor.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TFRT_DATA_RAGGED_BATCH_DATASET_H_
+#define TFRT_DATA_RAGGED_BATCH_DATASET_H_
+
+#include <cstring>
+
+#include "dataset.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+namespace data {
+
+template <typename T>
+class RaggedBatchDatasetIterator;
+
+namespace internal {
+
+// Computes the row splits of the ragged batch of `inputs` and returns the
+// metadata of the flat values tensor. All inputs must be DenseHostTensors of
+// dtype T with rank >= 1 and the same inner (non-leading) dimensions.
+template <typename T>
+llvm::Expected<TensorMetadata> GetRaggedBatchMetadata(
+    ArrayRef<RCReference<AsyncValue>> inputs, MutableArrayRef<int64_t> splits) {
+  assert(!inputs.empty());
+  assert(splits.size() == inputs.size() + 1);
+  const TensorShape& first_shape = inputs[0]->get<DenseHostTensor>().shape();
+  if (first_shape.GetRank() == 0) {
+    return MakeStringError("ragged batch requires elements of rank >= 1");
+  }
+
+  SmallVector<ssize_t, 4> values_dims;
+  first_shape.GetDimensions(&values_dims);
+
+  splits[0] = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const auto& tensor = inputs[i]->get<DenseHostTensor>();
+    if (tensor.dtype() != GetDType<T>()) {
+      return MakeStringError("ragged batch expected elements of dtype ",
+                             GetDType<T>(), " but got ", tensor.dtype());
+    }
+    const TensorShape& shape = tensor.shape();
+    if (shape.GetRank() != static_cast<int>(values_dims.size())) {
+      return MakeStringError(
+          "ragged batch requires elements of the same rank, but got ",
+          values_dims.size(), " and ", shape.GetRank());
+    }
+    for (int d = 1; d < shape.GetRank(); ++d) {
+      if (shape.GetDimensionSize(d) != values_dims[d]) {
+        return MakeStringError(
+            "ragged batch requires elements with the same inner dimensions, "
+            "but got ",
+            first_shape, " and ", shape);
+      }
+    }
+    splits[i + 1] = splits[i] + shape.GetDimensionSize(0);
+  }
+
+  values_dims[0] = splits.back();
+  return TensorMetadata(GetDType<T>(), values_dims);
+}
+
+// When all `inputs` are available, allocates the values and row splits tensors
+// and concatenates the inputs into the values tensor in a single parallel pass.
+// The i-th input occupies rows [splits[i], splits[i + 1]) of the values tensor.
+template <typename T>
+void CopyToRaggedBatch(SmallVector<RCReference<AsyncValue>, 4> inputs,
+                       AsyncValueRef<DenseHostTensor> values,
+                       AsyncValueRef<DenseHostTensor> row_splits,
+                       const ExecutionContext& exec_ctx) {
+  SmallVector<AsyncValue*, 4> async_value_ptrs;
+  for (const auto& input : inputs) async_value_ptrs.push_back(input.get());
+
+  exec_ctx.host()->RunWhenReady(async_value_ptrs, [inputs = std::move(inputs),
+                                                   values = std::move(values),
+                                                   row_splits =
+                                                       std::move(row_splits),
+                                                   exec_ctx]() mutable {
+    for (const auto& input : inputs) {
+      if (input->IsError()) {
+        values.SetError(input->GetError());
+        row_splits.SetError(input->GetError());
+        return;
+      }
+    }
+
+    HostContext* host = exec_ctx.host();
+    const ssize_t num_splits = inputs.size() + 1;
+    auto splits_dht = DenseHostTensor::CreateUninitialized(
+        TensorMetadata(GetDType<int64_t>(), ArrayRef<ssize_t>(num_splits)),
+        host);
+    if (!splits_dht) {
+      auto diag = EmitError(exec_ctx, "failed to create uninitialized tensor");
+      values.SetError(diag);
+      row_splits.SetError(diag);
+      return;
+    }
+    MutableArrayRef<int64_t> splits(static_cast<int64_t*>(splits_dht->data()),
+                                    num_splits);
+
+    auto metadata = GetRaggedBatchMetadata<T>(inputs, splits);
+    if (!metadata) {
+      auto diag = EmitError(exec_ctx, metadata.takeError());
+      values.SetError(diag);
+      row_splits.SetError(diag);
+      return;
+    }
+
+    auto values_dht = DenseHostTensor::CreateUninitialized(*metadata, host);
+    if (!values_dht) {
+      auto diag = EmitError(exec_ctx, "failed to create uninitialized tensor");
+      values.SetError(diag);
+      row_splits.SetError(diag);
+      return;
+    }
+
+    const size_t row_size_in_bytes =
+        values_dht->DataSizeInBytes() / std::max<int64_t>(splits.back(), 1);
+    char* output = static_cast<char*>(values_dht->data());
+
+    ParallelFor(host).Execute(
+        inputs.size(), ParallelFor::BlockSizes::Min(1),
+        [inputs = std::move(inputs), splits, row_size_in_bytes, output](
+            size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            const auto& input = inputs[i]->get<DenseHostTensor>();
+            std::memcpy(output + splits[i] * row_size_in_bytes, input.data(),
+                        input.DataSizeInBytes());
+          }
+        },
+        [values = std::move(values), row_splits = std::move(row_splits),
+         values_dht = std::move(*values_dht),
+         splits_dht = std::move(*splits_dht)]() mutable {
+          values.emplace(std::move(values_dht));
+          row_splits.emplace(std::move(splits_dht));
+        });
+  });
+}
+
+}  // namespace internal
+
+// RaggedBatchDataset wraps around another Dataset instance whose elements are
+// DenseHostTensors of dtype T with rank >= 1, that may differ in their leading
+// dimension, e.g. variable-length sequences.
+//
+// GetNext() returns two tensors that together represent a ragged batch:
+//  (1) values: all elements concatenated along the leading dimension.
+//  (2) row_splits: a 1-D i64 tensor of size batch_size + 1, where the i-th
+//      element of the batch is values[row_splits[i]:row_splits[i + 1]].
+template <typename T>
+class RaggedBatchDataset : public Dataset {
+ public:
+  explicit RaggedBatchDataset(RCReference<Dataset> input_dataset,
+                              int32_t batch_size, HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        batch_size_(batch_size),
+        host_(host),
+        allocator_(host->allocator()) {}
+
+  // This class is not copyable or movable.
+  RaggedBatchDataset(const RaggedBatchDataset&) = delete;
+  RaggedBatchDataset& operator=(const RaggedBatchDataset&) = delete;
+
+  RCReference<Iterator> MakeIterator() override;
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class RaggedBatchDatasetIterator<T>;
+
+  void Destroy() override {
+    internal::DestroyImpl<RaggedBatchDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  const int32_t batch_size_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+};
+
+template <typename T>
+class RaggedBatchDatasetIterator : public Iterator {
+ public:
+  explicit RaggedBatchDatasetIterator(
+      RCReference<RaggedBatchDataset<T>> parent_dataset)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator()) {}
+
+  // This class is not copyable or movable.
+  RaggedBatchDatasetIterator(const RaggedBatchDatasetIterator&) = delete;
+  RaggedBatchDatasetIterator& operator=(const RaggedBatchDatasetIterator&) =
+      delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<RaggedBatchDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<RaggedBatchDataset<T>> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+};
+
+template <typename T>
+RCReference<Iterator> RaggedBatchDataset<T>::MakeIterator() {
+  return TakeRef(
+      host_->Construct<RaggedBatchDatasetIterator<T>>(FormRef(this)));
+}
+
+// TODO(b/155918211): Handle asynchrous EOF from the input_iterator_
+template <typename T>
+IterationResult RaggedBatchDatasetIterator<T>::GetNext(
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  SmallVector<RCReference<AsyncValue>, 4> inputs;
+  // Get up to batch_size values from the underlying iterator.
+  for (int i = 0; i < parent_dataset_->batch_size_; ++i) {
+    auto input = input_iterator_->GetNext(exec_ctx);
+    if (internal::IsConcreteAndEmpty(input)) {
+      break;
+    }
+    assert(input.values.size() == 1);
+    inputs.push_back(std::move(input.values[0]));
+  }
+  if (inputs.empty()) {
+    return IterationResult::Eof(host, 2);
+  }
+
+  auto values = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  auto row_splits = host->MakeUnconstructedAsyncValueRef<DenseHostTensor>();
+  internal::CopyToRaggedBatch<T>(std::move(inputs), values.CopyRef(),
+                                 row_splits.CopyRef(), exec_ctx);
+
+  SmallVector<RCReference<AsyncValue>, 4> results;
+  results.push_back(values.ReleaseRCRef());
+  results.push_back(row_splits.ReleaseRCRef());
+  return IterationResult::Values(std::move(results), host);
+}
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_RAGGED_BATCH_DATASET_H_
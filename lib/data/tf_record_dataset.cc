@@ -14,8 +14,8 @@
 
 //===- tf_record_dataset.cc -----------------------------------------------===//
 //
-// This file implements TFRecordDataset class which reads records from TFRecord
-// files into strings.
+// This file implements TFRecordDataset class which reads records from a list of
+// TFRecord files into strings.
 //
 //===----------------------------------------------------------------------===//
 
@@ -71,24 +71,68 @@ RCReference<Iterator> TFRecordDataset::MakeIterator() {
 //===----------------------------------------------------------------------===//
 // Implementation for TFRecordDatasetIterator member functions
 //===----------------------------------------------------------------------===//
+void TFRecordDatasetIterator::OpenFilesAhead(
+    const ExecutionContext& exec_ctx) {
+  const auto& paths = parent_dataset_->paths_;
+  while (next_files_.size() < kMaxFilesOpenedAhead &&
+         next_file_index_ < paths.size()) {
+    auto file =
+        std::make_shared<internal::TFRecordFile>(paths[next_file_index_++]);
+    // If the task can't be enqueued the file is opened by StartNextFile().
+    bool enqueued =
+        exec_ctx.host()->EnqueueBlockingWork([file]() { file->Open(); });
+    (void)enqueued;
+    next_files_.push(std::move(file));
+  }
+}
+
+bool TFRecordDatasetIterator::StartNextFile(const ExecutionContext& exec_ctx) {
+  OpenFilesAhead(exec_ctx);
+  if (next_files_.empty()) return false;
+
+  file_ = std::move(next_files_.front());
+  next_files_.pop();
+  stream_ = std::move(file_->Open());
+
+  // Keep the pipeline of files opened ahead full.
+  OpenFilesAhead(exec_ctx);
+  return true;
+}
+
 IterationResult TFRecordDatasetIterator::GetNextElement(
     const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  bool eof = false;
-  auto result = ReadRecord(&eof);
 
-  if (eof) {
-    return IterationResult::Eof(host, 1);
-  }
-  if (!result) {
-    auto error = EmitErrorAsync(exec_ctx, result.takeError());
-    return IterationResult::Error(std::move(error), 1);
+  // Read the next record, moving on to the next file when the current one is
+  // exhausted.
+  while (file_ || StartNextFile(exec_ctx)) {
+    bool eof = false;
+    auto result = ReadRecord(&eof);
+
+    if (eof) {
+      llvm::consumeError(result.takeError());
+      stream_.close();
+      file_.reset();
+      continue;
+    }
+    if (!result) {
+      // Give up on the current file, the next call continues with the next
+      // file. The error is reported as the value of this element rather than
+      // as the end of the iteration.
+      stream_.close();
+      file_.reset();
+      llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+      values.push_back(EmitErrorAsync(exec_ctx, result.takeError()));
+      return IterationResult::Values(std::move(values), host);
+    }
+
+    llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+    values.push_back(
+        host->MakeAvailableAsyncValueRef<std::string>(std::move(*result)));
+    return IterationResult::Values(std::move(values), host);
   }
 
-  llvm::SmallVector<RCReference<AsyncValue>, 4> values;
-  values.push_back(
-      host->MakeAvailableAsyncValueRef<std::string>(std::move(*result)));
-  return IterationResult::Values(std::move(values), host);
+  return IterationResult::Eof(host, 1);
 }
 
 // Logic based on tensorflow/core/io/record_reader.*
@@ -135,7 +179,7 @@ llvm::Expected<std::string> TFRecordDatasetIterator::ReadRecord(bool* eof) {
   }
 
   if (stream_.fail()) {
-    return MakeStringError("failed to read file: ", parent_dataset_->path_);
+    return MakeStringError("failed to read file: ", file_->path());
   }
 
   // Read header.
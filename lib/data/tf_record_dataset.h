@@ -16,8 +16,8 @@
 
 //===- tf_record_dataset.h --------------------------------------*- C++ -*-===//
 //
-// This file declares TFRecordDataset class which reads records from TFRecord
-// files into strings.
+// This file declares TFRecordDataset class which reads records from a list of
+// TFRecord files into strings.
 //
 //===----------------------------------------------------------------------===//
 
@@ -25,6 +25,10 @@
 #define TFRT_LIB_DATA_TF_RECORD_DATASET_H_
 
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
 
 #include "dataset.h"
 #include "io.h"
@@ -33,7 +37,10 @@
 namespace tfrt {
 namespace data {
 
-// TFRecordDataset reads TFRecord bytes from a file.
+// TFRecordDataset reads TFRecord bytes from a list of files, one file after
+// another. With `num_shards` > 1 the dataset only reads every `num_shards`-th
+// file starting from `shard_index`, so that each of `num_shards` datasets
+// reads a disjoint subset of the files.
 //
 // TODO(rachelim): Consider using a custom data type to represent the
 // bytes read from a TFRecord file. This will make the code more type safe
@@ -42,7 +49,18 @@ namespace data {
 class TFRecordDataset : public Dataset {
  public:
   explicit TFRecordDataset(std::string path, HostContext* host)
-      : path_(std::move(path)), host_(host), allocator_(host->allocator()) {}
+      : TFRecordDataset(std::vector<std::string>{std::move(path)},
+                        /*num_shards=*/1, /*shard_index=*/0, host) {}
+
+  TFRecordDataset(ArrayRef<std::string> paths, int64_t num_shards,
+                  int64_t shard_index, HostContext* host)
+      : host_(host), allocator_(host->allocator()) {
+    assert(num_shards > 0);
+    assert(shard_index >= 0 && shard_index < num_shards);
+    for (size_t i = shard_index; i < paths.size(); i += num_shards) {
+      paths_.push_back(paths[i]);
+    }
+  }
 
   // This class is not copyable or movable.
   TFRecordDataset(const TFRecordDataset&) = delete;
@@ -57,26 +75,56 @@ class TFRecordDataset : public Dataset {
     internal::DestroyImpl<TFRecordDataset>(this, allocator_);
   }
 
-  const std::string path_;
+  // Paths of the files that belong to this dataset shard.
+  std::vector<std::string> paths_;
   HostContext* host_;
   HostAllocator* allocator_;
 };
 
+namespace internal {
+
+// TFRecordFile opens a file for reading at most once. The file is opened
+// either ahead of time by an asynchronous task on the blocking work queue, or
+// by the reader itself if that task has not started yet. If the task is
+// already opening the file, the reader blocks until it is done.
+class TFRecordFile {
+ public:
+  explicit TFRecordFile(std::string path) : path_(std::move(path)) {}
+
+  // Opens the file if it is not opened yet. Blocks if the file is being
+  // opened concurrently by another thread.
+  std::ifstream& Open() {
+    std::call_once(opened_, [this]() {
+      stream_.open(path_.c_str(), std::ios_base::binary);
+    });
+    return stream_;
+  }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  const std::string path_;
+  std::once_flag opened_;
+  std::ifstream stream_;
+};
+
+}  // namespace internal
+
 class TFRecordDatasetIterator : public io::PrefetchingIterator {
  public:
   explicit TFRecordDatasetIterator(RCReference<TFRecordDataset> parent_dataset)
       : io::PrefetchingIterator(256, 64),
-        parent_dataset_(std::move(parent_dataset)),
-        stream_(parent_dataset_->path_.c_str(), std::ios_base::binary) {}
+        parent_dataset_(std::move(parent_dataset)) {}
 
   // This class is not copyable or movable.
   TFRecordDatasetIterator(const TFRecordDatasetIterator&) = delete;
   TFRecordDatasetIterator& operator=(const TFRecordDatasetIterator&) = delete;
 
  protected:
-  // Reads the next record from the input file. Returns empty AsyncValueRef if
-  // input file is exhausted. Returns error async value if failed to read
-  // the next record.
+  // Reads the next record from the input files. Returns empty AsyncValueRef if
+  // all input files are exhausted. Returns error async value if failed to open
+  // the current file or to read the next record from it; the rest of that file
+  // is skipped and the following call reads from the next file.
   IterationResult GetNextElement(const ExecutionContext& exec_ctx) final;
 
  private:
@@ -101,7 +149,29 @@ class TFRecordDatasetIterator : public io::PrefetchingIterator {
   // return value.
   llvm::Expected<std::string> ReadRecord(bool* eof);
 
+  // Launches asynchronous opens of the files following the current one, so
+  // that opening the next files overlaps with reading the current one.
+  void OpenFilesAhead(const ExecutionContext& exec_ctx);
+
+  // Makes the next input file current. Returns false if there are no more
+  // input files.
+  bool StartNextFile(const ExecutionContext& exec_ctx);
+
+  // The maximum number of files opened ahead of the current file.
+  static constexpr int kMaxFilesOpenedAhead = 4;
+
   RCReference<TFRecordDataset> parent_dataset_;
+
+  // All members below are accessed only by GetNextElement(), which is called
+  // under the prefetching iterator input lock.
+
+  // Index of the next file in parent_dataset_->paths_ to open.
+  size_t next_file_index_ = 0;
+  // Files that are (being) opened ahead of the current file, in read order.
+  std::queue<std::shared_ptr<internal::TFRecordFile>> next_files_;
+  // The file that is currently read, or nullptr before the first file is
+  // started and after the current file is exhausted.
+  std::shared_ptr<internal::TFRecordFile> file_;
   std::ifstream stream_;
 };
 
@@ -164,6 +164,10 @@ int HostContext::GetNumWorkerThreads() const {
   return work_queue_->GetParallelismLevel();
 }
 
+int HostContext::GetCurrentWorkerThreadId() const {
+  return work_queue_->GetCurrentWorkerThreadId();
+}
+
 // Run the specified function when the specified set of AsyncValue's are all
 // resolved.  This is a set-version of "AndThen".
 void HostContext::RunWhenReady(ArrayRef<AsyncValue*> values,
@@ -99,7 +99,8 @@ static void TestReportErrorConcreteAsync(Argument<int32_t> in,
                                          KernelFrame* frame) {
   AsyncValueRef<int32_t> result_ref = out.Allocate();
   exec_ctx.host()->EnqueueWork(
-      [in = *in, result_ref = std::move(result_ref), frame = *frame]() mutable {
+      [in = *in, result_ref = std::move(result_ref),
+       frame = RAIIKernelFrame(*frame)]() mutable {
         if (in == 0) {
           result_ref.emplace(in);
         } else {
@@ -116,7 +117,7 @@ static void TestReportIndirectErrorAsync(Argument<int32_t> in,
   HostContext* host = exec_ctx.host();
   auto result_ref = out.AllocateIndirect();
   host->EnqueueWork([in = *in, result_ref = std::move(result_ref),
-                     frame = *frame, host]() mutable {
+                     frame = RAIIKernelFrame(*frame), host]() mutable {
     if (in == 0) {
       auto concrete_av = host->MakeAvailableAsyncValueRef<int32_t>();
       result_ref->ForwardTo(std::move(concrete_av));
@@ -47,7 +47,8 @@ static void TestReportErrorAsync(Result<int32_t> out,
                                  const ExecutionContext& exec_ctx,
                                  KernelFrame* frame) {
   exec_ctx.host()->EnqueueWork(
-      [out_ref = out.Allocate(), frame_copy = *frame]() mutable {
+      [out_ref = out.Allocate(),
+       frame_copy = RAIIKernelFrame(*frame)]() mutable {
         frame_copy.ReportError("something bad happened asynchronously");
       });
 }
@@ -172,6 +172,135 @@ func @controlflow_repeat_cancel() -> i32 {
 }
 // CHECK: 'controlflow_repeat_cancel' returned <<error: Canceled by test.cancel>>
 
+func @parallel_for_body(%index: i32, %x: i32) -> (i32, i32) {
+  %v = "hex.async_add.i32"(%index, %x) : (i32, i32) -> i32
+  %one = hex.constant.i32 1
+  hex.return %v, %one : i32, i32
+}
+
+func @parallel_for_sum(%a0: i32, %a1: i32, %b0: i32, %b1: i32) -> (i32, i32) {
+  %v0 = hex.add.i32 %a0, %b0
+  %v1 = hex.add.i32 %a1, %b1
+  hex.return %v0, %v1 : i32, i32
+}
+
+// CHECK-LABEL: --- Running 'controlflow_parallel_for'
+func @controlflow_parallel_for() {
+  %count = hex.constant.i32 1000
+  %zero = hex.constant.i32 0
+  %x = hex.constant.i32 2
+
+  // Sums `index + 2` and counts the iterations.
+  %sum, %iterations = "hex.parallel_for.i32"(%count, %zero, %zero, %x)
+    { body_fn = @parallel_for_body, reduce_fn = @parallel_for_sum }
+    : (i32, i32, i32, i32) -> (i32, i32)
+
+  %ch0 = hex.new.chain
+  // CHECK-NEXT: int32 = 501500
+  %ch1 = hex.print.i32 %sum, %ch0
+  // CHECK-NEXT: int32 = 1000
+  hex.print.i32 %iterations, %ch1
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'controlflow_parallel_for_zero'
+func @controlflow_parallel_for_zero() {
+  %count = hex.constant.i32 0
+  %init = hex.constant.i32 42
+  %x = hex.constant.i32 2
+
+  %sum, %iterations = "hex.parallel_for.i32"(%count, %init, %init, %x)
+    { body_fn = @parallel_for_body, reduce_fn = @parallel_for_sum }
+    : (i32, i32, i32, i32) -> (i32, i32)
+
+  %ch0 = hex.new.chain
+  // CHECK-NEXT: int32 = 42
+  %ch1 = hex.print.i32 %sum, %ch0
+  // CHECK-NEXT: int32 = 42
+  hex.print.i32 %iterations, %ch1
+
+  hex.return
+}
+
+func @parallel_for_cancel_body(%index: i32, %x: i32) -> (i32, i32) {
+  %ten = hex.constant.i32 10
+  %cond = "hex.lessequal.i32"(%ten, %index) : (i32, i32) -> (i1)
+
+  // Cancel when the loop index reaches 10.
+  %v = hex.if %cond, %x : (i32) -> i32 {
+    %ch0 = hex.new.chain
+    %y, %ch1 = "tfrt_test.cancel"(%ch0) : (!hex.chain) -> (i32, !hex.chain)
+    hex.return %y : i32
+  } else {
+    %y = "hex.async_add.i32"(%index, %x) : (i32, i32) -> i32
+    hex.return %y : i32
+  }
+
+  %one = hex.constant.i32 1
+  hex.return %v, %one : i32, i32
+}
+
+// CHECK-LABEL: --- Running 'controlflow_parallel_for_cancel'
+func @controlflow_parallel_for_cancel() -> (i32, i32) {
+  %count = hex.constant.i32 1000
+  %zero = hex.constant.i32 0
+  %x = hex.constant.i32 2
+
+  %sum, %iterations = "hex.parallel_for.i32"(%count, %zero, %zero, %x)
+    { body_fn = @parallel_for_cancel_body, reduce_fn = @parallel_for_sum }
+    : (i32, i32, i32, i32) -> (i32, i32)
+
+  hex.return %sum, %iterations : i32, i32
+}
+// CHECK: 'controlflow_parallel_for_cancel' returned <<error: Canceled by test.cancel>>,<<error: Canceled by test.cancel>>
+
+func @while_cond(%i: i32, %sum: i32) -> i1 {
+  %nine = hex.constant.i32 9
+  %cond = "hex.lessequal.i32"(%i, %nine) : (i32, i32) -> i1
+  hex.return %cond : i1
+}
+
+func @while_body(%i: i32, %sum: i32) -> (i32, i32) {
+  %one = hex.constant.i32 1
+  %next_i = hex.add.i32 %i, %one
+  %next_sum = "hex.async_add.i32"(%sum, %i) : (i32, i32) -> i32
+  hex.return %next_i, %next_sum : i32, i32
+}
+
+// CHECK-LABEL: --- Running 'controlflow_while'
+func @controlflow_while() {
+  %zero = hex.constant.i32 0
+
+  %res:2 = "hex.while"(%zero, %zero)
+    { body_fn = @while_body, cond_fn = @while_cond } : (i32, i32) -> (i32, i32)
+
+  %ch0 = hex.new.chain
+  // CHECK-NEXT: int32 = 10
+  %ch1 = hex.print.i32 %res#0, %ch0
+  // CHECK-NEXT: int32 = 45
+  hex.print.i32 %res#1, %ch1
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'controlflow_while_false'
+func @controlflow_while_false() {
+  %i = hex.constant.i32 10
+  %sum = hex.constant.i32 -1
+
+  %res:2 = "hex.while"(%i, %sum)
+    { body_fn = @while_body, cond_fn = @while_cond } : (i32, i32) -> (i32, i32)
+
+  %ch0 = hex.new.chain
+  // CHECK-NEXT: int32 = 10
+  %ch1 = hex.print.i32 %res#0, %ch0
+  // CHECK-NEXT: int32 = -1
+  hex.print.i32 %res#1, %ch1
+
+  hex.return
+}
+
 // BEFExecutor will allocate an IndirectAsyncValue for this function's return
 // value.
 func @indirect_async_return(%c1: i32) -> i32 {
@@ -38,3 +38,55 @@ func @if_mismatch(%cond: i1, %v1: i32, %v2: i32) -> i32 {
     hex.return %v1 : i32
   }
 }
+
+// -----
+
+func @parallel_for_body(%index: i32) -> i32 {
+  hex.return %index : i32
+}
+
+func @parallel_for_missing_reduce_fn(%count: i32, %init: i32) -> i32 {
+
+  // expected-error @+1 {{'hex.parallel_for.i32' op requires a 'reduce_fn' to combine the results}}
+  %res = "hex.parallel_for.i32"(%count, %init) { body_fn = @parallel_for_body }
+    : (i32, i32) -> i32
+  hex.return %res : i32
+}
+
+// -----
+
+func @parallel_for_body(%index: i32, %x: f32) -> i32 {
+  hex.return %index : i32
+}
+
+func @parallel_for_sum(%a: i32, %b: i32) -> i32 {
+  %v = hex.add.i32 %a, %b
+  hex.return %v : i32
+}
+
+func @parallel_for_body_mismatch(%count: i32, %init: i32, %x: i32) -> i32 {
+
+  // expected-error @+1 {{'hex.parallel_for.i32' op body_fn argument type mismatch}}
+  %res = "hex.parallel_for.i32"(%count, %init, %x)
+    { body_fn = @parallel_for_body, reduce_fn = @parallel_for_sum }
+    : (i32, i32, i32) -> i32
+  hex.return %res : i32
+}
+
+// -----
+
+func @while_cond(%i: i32) -> i32 {
+  hex.return %i : i32
+}
+
+func @while_body(%i: i32) -> i32 {
+  hex.return %i : i32
+}
+
+func @while_cond_mismatch(%i: i32) -> i32 {
+
+  // expected-error @+1 {{'hex.while' op cond_fn must return a single i1}}
+  %res = "hex.while"(%i) { body_fn = @while_body, cond_fn = @while_cond }
+    : (i32) -> i32
+  hex.return %res : i32
+}
@@ -0,0 +1,106 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=fail
+// RUN: tfrt_translate -mlir-to-bef -inline-call-threshold=4 %s | bef_executor | FileCheck %s --dump-input=fail
+// RUN: tfrt_translate -mlir-to-bef -inline-call-threshold=4 %s | tfrt_translate --bef-to-mlir --mlir-print-op-generic | FileCheck %s --check-prefix=INLINE --dump-input=fail
+
+// Small helper functions called through hex.call. With -inline-call-threshold
+// the calls are replaced by the callee bodies when converting to BEF.
+
+// INLINE-NOT: "hex.call"
+// INLINE: sym_name = "add_two"
+// INLINE-NOT: "hex.call"
+// INLINE: "hex.call"
+// INLINE-SAME: callee = @too_large
+// INLINE-NOT: "hex.call"
+// INLINE: sym_name = "inline_calls"
+// INLINE-NOT: "hex.call"
+// INLINE: sym_name = "call_heavy_benchmark"
+
+// CHECK-LABEL: --- Not running 'add_one' because it has arguments
+func @add_one(%x: i32) -> i32 {
+  %c1 = hex.constant.i32 1
+  %y = hex.add.i32 %x, %c1
+  hex.return %y : i32
+}
+
+// CHECK-LABEL: --- Not running 'add_two' because it has arguments
+func @add_two(%x: i32) -> i32 {
+  %y = hex.call @add_one(%x) : (i32) -> i32
+  %z = hex.call @add_one(%y) : (i32) -> i32
+  hex.return %z : i32
+}
+
+// CHECK-LABEL: --- Not running 'print_and_forward' because it has arguments
+func @print_and_forward(%x: i32, %ch: !hex.chain) -> (i32, !hex.chain) {
+  %ch1 = hex.print.i32 %x, %ch
+  hex.return %x, %ch1 : i32, !hex.chain
+}
+
+// CHECK-LABEL: --- Not running 'too_large' because it has arguments
+func @too_large(%x: i32) -> i32 {
+  %c1 = hex.constant.i32 1
+  %a = hex.add.i32 %x, %c1
+  %b = hex.add.i32 %a, %c1
+  %c = hex.add.i32 %b, %c1
+  %d = hex.add.i32 %c, %c1
+  hex.return %d : i32
+}
+
+// CHECK-LABEL: --- Running 'inline_calls'
+func @inline_calls() {
+  %c1 = hex.constant.i32 1
+  %ch0 = hex.new.chain
+
+  %x = hex.call @add_one(%c1) : (i32) -> i32
+  // CHECK-NEXT: int32 = 2
+  %y, %ch1 = hex.call @print_and_forward(%x, %ch0)
+    : (i32, !hex.chain) -> (i32, !hex.chain)
+
+  %z = hex.call @add_two(%y) : (i32) -> i32
+  // CHECK-NEXT: int32 = 4
+  %ch2 = hex.print.i32 %z, %ch1
+
+  %w = hex.call @too_large(%z) : (i32) -> i32
+  // CHECK-NEXT: int32 = 8
+  hex.print.i32 %w, %ch2
+
+  hex.return
+}
+
+// Benchmark of a call-heavy function body. Compare the numbers of the first
+// two RUN lines to see the cost of hex.call.
+// CHECK-LABEL: --- Running 'call_heavy_benchmark'
+func @call_heavy_benchmark() {
+  // CHECK: BM:call_heavy:Duration(us):
+  // CHECK: BM:call_heavy:Count:
+  // CHECK: BM:call_heavy:Time Min(us):
+  // CHECK: BM:call_heavy:Time 50%(us):
+  // CHECK: BM:call_heavy:Time 95%(us):
+  // CHECK: BM:call_heavy:Time 99%(us):
+
+  %c = hex.constant.i32 42
+
+  tfrt_test.benchmark "call_heavy"(%c : i32) duration_secs = 1, max_count = 1000, num_warmup_runs = 10
+  {
+    %a = hex.call @add_two(%c) : (i32) -> i32
+    %b = hex.call @add_two(%a) : (i32) -> i32
+    %d = hex.call @add_two(%b) : (i32) -> i32
+    %e = hex.call @add_two(%d) : (i32) -> i32
+    hex.return %e : i32
+  }
+
+  hex.return
+}
@@ -0,0 +1,84 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --strict-whitespace --dump-input=always
+
+func @add_one(%x : i64) -> i64 {
+  %one = hex.constant.i64 1
+  %y = hex.add.i64 %x, %one
+  hex.return %y : i64
+}
+
+func @count_batch(%batch : !t.tensor, %count : i32) -> i32 {
+  %one = hex.constant.i32 1
+  %next = hex.add.i32 %count, %one
+  hex.return %next : i32
+}
+
+// CHECK-LABEL: --- Running 'enable_iterator_stats'
+func @enable_iterator_stats() {
+  %ch0 = hex.new.chain
+  "data.enable_iterator_stats"(%ch0) : (!hex.chain) -> !hex.chain
+  hex.return
+}
+
+// The datasets of the pipeline are destroyed when the function returns.
+// CHECK-LABEL: --- Running 'run_pipeline'
+func @run_pipeline() -> i32 {
+  %start = hex.constant.i64 0
+  %stop = hex.constant.i64 10
+  %step = hex.constant.i64 1
+
+  %range = "data.range_dataset.i64"(%start, %stop, %step)
+    : (i64, i64, i64) -> !data.dataset
+  %map = "data.map_dataset"(%range) { function = @add_one }
+    : (!data.dataset) -> !data.dataset
+  %batch = "data.batch_dataset.i64"(%map)
+    { batch_size = 4 : i32, same_input_metadata = false }
+    : (!data.dataset) -> !data.dataset
+  %prefetch = "data.prefetch_dataset"(%batch)
+    : (!data.dataset) -> !data.dataset
+  %iterator = "data.make_iterator_from_dataset"(%prefetch)
+    : (!data.dataset) -> !data.iterator
+
+  %zero = hex.constant.i32 0
+  %count = "data.enumerate.iterator"(%iterator, %zero)
+    { function = @count_batch } : (!data.iterator, i32) -> i32
+
+  hex.return %count : i32
+}
+// CHECK: 'run_pipeline' returned 3
+
+// Statistics of the finished pipeline are printed as a tree. Batches of four
+// and two int64 values hold 80 bytes in total. The prefetch node gets one
+// GetNext() call for each batch and one for the end of iteration.
+// CHECK-LABEL: --- Running 'print_iterator_stats'
+func @print_iterator_stats() {
+  %ch0 = hex.new.chain
+  "data.iterator_stats"(%ch0) : (!hex.chain) -> !hex.chain
+  hex.return
+}
+// CHECK-NEXT: {{^PrefetchDataset#[0-9]+}}: elements = 3, get_next_calls = 4, bytes = 80,
+// CHECK-NEXT: {{^  BatchDataset#[0-9]+}}: elements = 3, get_next_calls = {{[0-9]+}}, bytes = 80,
+// CHECK-NEXT: {{^    MapDataset#[0-9]+}}: elements = 10, get_next_calls = {{[0-9]+}}, bytes = 0,
+// CHECK-NEXT: {{^      RangeDataset#[0-9]+}}: elements = 10, get_next_calls = {{[0-9]+}}, bytes = 0,
+
+// Printed statistics of finished nodes are removed.
+// CHECK-LABEL: --- Running 'print_iterator_stats_again'
+func @print_iterator_stats_again() {
+  %ch0 = hex.new.chain
+  "data.iterator_stats"(%ch0) : (!hex.chain) -> !hex.chain
+  hex.return
+}
+// CHECK-NOT: Dataset#
@@ -0,0 +1,117 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_translate -mlir-to-bef %s | bef_executor | FileCheck %s --dump-input=always
+
+// records.tfrecord holds the two records "hello" and "world".
+
+// CHECK-LABEL: --- Running 'tf_record_dataset'
+func @tf_record_dataset() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "mlir_tests/data/test_data/records.tfrecord"
+  } : () -> !hex.string
+
+  %dataset = "data.tf_record_dataset"(%path)
+    : (!hex.string) -> !data.dataset
+  %iterator = "data.make_iterator_from_dataset"(%dataset)
+    : (!data.dataset) -> !data.iterator
+
+  %str0 = "data.iterator_get_next"(%iterator, %ch0)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = hello
+  %ch1 = "tfrt_test.print_string"(%str0, %ch0)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  %str1 = "data.iterator_get_next"(%iterator, %ch1)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = world
+  %ch2 = "tfrt_test.print_string"(%str1, %ch1)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  hex.return
+}
+
+// CHECK-LABEL: --- Running 'sharded_tf_record_dataset'
+func @sharded_tf_record_dataset() {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "mlir_tests/data/test_data/records.tfrecord"
+  } : () -> !hex.string
+  %missing = "tfrt_test.get_string"() {
+      value = "mlir_tests/data/test_data/missing.tfrecord"
+  } : () -> !hex.string
+
+  // Shard 1 of 2 reads only the second and the fourth file.
+  %dataset = "data.sharded_tf_record_dataset"(%missing, %path, %missing, %path)
+    { num_shards = 2 : i64, shard_index = 1 : i64 }
+    : (!hex.string, !hex.string, !hex.string, !hex.string) -> !data.dataset
+  %iterator = "data.make_iterator_from_dataset"(%dataset)
+    : (!data.dataset) -> !data.iterator
+
+  %str0 = "data.iterator_get_next"(%iterator, %ch0)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = hello
+  %ch1 = "tfrt_test.print_string"(%str0, %ch0)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  %str1 = "data.iterator_get_next"(%iterator, %ch1)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = world
+  %ch2 = "tfrt_test.print_string"(%str1, %ch1)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  %str2 = "data.iterator_get_next"(%iterator, %ch2)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = hello
+  %ch3 = "tfrt_test.print_string"(%str2, %ch2)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  hex.return
+}
+
+// A file that can't be opened fails one element, and the iteration continues
+// with the next file.
+// CHECK-LABEL: --- Running 'tf_record_dataset_skips_missing_file'
+func @tf_record_dataset_skips_missing_file() -> !hex.string {
+  %ch0 = hex.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "mlir_tests/data/test_data/records.tfrecord"
+  } : () -> !hex.string
+  %missing = "tfrt_test.get_string"() {
+      value = "mlir_tests/data/test_data/missing.tfrecord"
+  } : () -> !hex.string
+
+  %dataset = "data.sharded_tf_record_dataset"(%missing, %path)
+    { num_shards = 1 : i64, shard_index = 0 : i64 }
+    : (!hex.string, !hex.string) -> !data.dataset
+  %iterator = "data.make_iterator_from_dataset"(%dataset)
+    : (!data.dataset) -> !data.iterator
+
+  // expected-error @+1 {{runtime error: failed to read file: mlir_tests/data/test_data/missing.tfrecord}}
+  %str0 = "data.iterator_get_next"(%iterator, %ch0)
+    : (!data.iterator, !hex.chain) -> !hex.string
+
+  %str1 = "data.iterator_get_next"(%iterator, %ch0)
+    : (!data.iterator, !hex.chain) -> !hex.string
+  // CHECK: string = hello
+  %ch1 = "tfrt_test.print_string"(%str1, %ch0)
+    : (!hex.string, !hex.chain) -> !hex.chain
+
+  hex.return %str0 : !hex.string
+}
+// CHECK: 'tf_record_dataset_skips_missing_file' returned <<error: failed to read file: mlir_tests/data/test_data/missing.tfrecord>>
@@ -37,6 +37,9 @@ class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
   }
 
   int GetParallelismLevel() const final { return num_threads_; }
+  int GetCurrentWorkerThreadId() const final {
+    return non_blocking_work_queue_.CurrentThreadId();
+  }
 
   void AddTask(TaskFunction task) final;
   Optional<TaskFunction> AddBlockingTask(TaskFunction task,
@@ -236,6 +236,10 @@ class WorkQueueBase {
   // yet unparked and running. For strong guarantee must use use Quiesce.
   bool AllBlocked() const { return NumBlockedThreads() == num_threads_; }
 
+  // Returns current thread id in the [0, num_threads) range if the caller
+  // thread is managed by `this`, returns `-1` otherwise.
+  int CurrentThreadId() const;
+
   // CheckCallerThread() will abort the program if the caller thread is managed
   // by `*this`. This is required to prevent deadlocks from calling `Quiesce`
   // from a thread managed by the current worker queue.
@@ -324,10 +328,6 @@ class WorkQueueBase {
 
   void Notify() { event_count_.Notify(false); }
 
-  // Returns current thread id if the caller thread is managed by `this`,
-  // returns `-1` otherwise.
-  int CurrentThreadId() const;
-
   // NonEmptyQueueIndex() returns the index of a non-empty worker queue, or `-1`
   // if all queues are empty.
   LLVM_NODISCARD int NonEmptyQueueIndex();